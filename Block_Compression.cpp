@@ -0,0 +1,645 @@
+#include "Block_Compression.h"
+#include "Cpu.h"
+#include "Parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(CPU_SSE2)
+#include <emmintrin.h>
+#endif
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+// the pixels of one block, channel by channel - four pixels fit into one sse register
+struct Block_Pixels {
+    alignas(16) float r[16];
+    alignas(16) float g[16];
+    alignas(16) float b[16];
+    alignas(16) float a[16];
+};
+
+// up to 16 candidate colors an index can select
+struct Block_Palette {
+    float r[16] = {};
+    float g[16] = {};
+    float b[16] = {};
+    float a[16] = {};
+    int   size  = 0;
+};
+
+struct Channel_Weights {
+    float r = 1.0f, g = 1.0f, b = 1.0f, a = 1.0f;
+};
+
+Block_Pixels To_Block_Pixels(const uchar rgba[64])
+{
+    Block_Pixels pixels;
+    for (int n = 0; n < 16; ++n) {
+        pixels.r[n] = rgba[n * 4 + 0];
+        pixels.g[n] = rgba[n * 4 + 1];
+        pixels.b[n] = rgba[n * 4 + 2];
+        pixels.a[n] = rgba[n * 4 + 3];
+    }
+    return pixels;
+}
+
+// picks the nearest palette entry for every pixel and returns the summed squared error,
+// ties go to the lower index - the simd and the scalar version give identical results
+using Index_Search = float (*)(Block_Pixels const& pixels, Block_Palette const& palette, Channel_Weights const& weights, u8 indices[16]);
+
+#if defined(CPU_SSE2)
+float Select_Indices_SSE2(Block_Pixels const& pixels, Block_Palette const& palette, Channel_Weights const& weights, u8 indices[16])
+{
+    __m128 const wr = _mm_set1_ps(weights.r);
+    __m128 const wg = _mm_set1_ps(weights.g);
+    __m128 const wb = _mm_set1_ps(weights.b);
+    __m128 const wa = _mm_set1_ps(weights.a);
+
+    __m128 total = _mm_setzero_ps();
+    for (int group = 0; group < 16; group += 4) {
+        __m128 const r = _mm_load_ps(pixels.r + group);
+        __m128 const g = _mm_load_ps(pixels.g + group);
+        __m128 const b = _mm_load_ps(pixels.b + group);
+        __m128 const a = _mm_load_ps(pixels.a + group);
+
+        __m128  best_error = _mm_set1_ps(3.4e38f);
+        __m128i best_index = _mm_setzero_si128();
+        for (int k = 0; k < palette.size; ++k) {
+            __m128 const dr = _mm_sub_ps(r, _mm_set1_ps(palette.r[k]));
+            __m128 const dg = _mm_sub_ps(g, _mm_set1_ps(palette.g[k]));
+            __m128 const db = _mm_sub_ps(b, _mm_set1_ps(palette.b[k]));
+            __m128 const da = _mm_sub_ps(a, _mm_set1_ps(palette.a[k]));
+
+            __m128 error = _mm_mul_ps(wr, _mm_mul_ps(dr, dr));
+            error = _mm_add_ps(error, _mm_mul_ps(wg, _mm_mul_ps(dg, dg)));
+            error = _mm_add_ps(error, _mm_mul_ps(wb, _mm_mul_ps(db, db)));
+            error = _mm_add_ps(error, _mm_mul_ps(wa, _mm_mul_ps(da, da)));
+
+            __m128i const better = _mm_castps_si128(_mm_cmplt_ps(error, best_error));
+            best_index = _mm_or_si128(_mm_and_si128(better, _mm_set1_epi32(k)), _mm_andnot_si128(better, best_index));
+            best_error = _mm_min_ps(error, best_error);
+        }
+
+        alignas(16) i32 group_indices[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(group_indices), best_index);
+        for (int n = 0; n < 4; ++n) {
+            indices[group + n] = u8(group_indices[n]);
+        }
+        total = _mm_add_ps(total, best_error);
+    }
+
+    alignas(16) float totals[4];
+    _mm_store_ps(totals, total);
+    return (totals[0] + totals[1]) + (totals[2] + totals[3]);
+}
+#endif
+
+// the error is summed in the same order as the four sse lanes
+float Select_Indices_Scalar(Block_Pixels const& pixels, Block_Palette const& palette, Channel_Weights const& weights, u8 indices[16])
+{
+    float totals[4] = {};
+    for (int n = 0; n < 16; ++n) {
+        float best_error = 3.4e38f;
+        int   best_index = 0;
+        for (int k = 0; k < palette.size; ++k) {
+            float const dr = pixels.r[n] - palette.r[k];
+            float const dg = pixels.g[n] - palette.g[k];
+            float const db = pixels.b[n] - palette.b[k];
+            float const da = pixels.a[n] - palette.a[k];
+
+            float error = weights.r * (dr * dr);
+            error = error + weights.g * (dg * dg);
+            error = error + weights.b * (db * db);
+            error = error + weights.a * (da * da);
+            if (error < best_error) {
+                best_error = error;
+                best_index = k;
+            }
+        }
+        indices[n] = u8(best_index);
+        totals[n % 4] += best_error;
+    }
+    return (totals[0] + totals[1]) + (totals[2] + totals[3]);
+}
+
+Index_Search Select_Index_Search(Block_Path path)
+{
+#if defined(CPU_SSE2)
+    if (path != block_scalar) {
+        return Select_Indices_SSE2;
+    }
+#endif
+    return Select_Indices_Scalar;
+}
+
+// writes/reads little endian bit fields, lowest bit first
+struct Bit_Writer {
+    Byte* out      = nullptr;
+    uint  position = 0;
+
+    void write(u32 value, uint bits)
+    {
+        for (uint n = 0; n < bits; ++n, ++position) {
+            if ((value >> n) & 1) {
+                out[position / 8] |= Byte(1u << (position % 8));
+            }
+        }
+    }
+};
+
+struct Bit_Reader {
+    const Byte* in       = nullptr;
+    uint        position = 0;
+
+    u32 read(uint bits)
+    {
+        u32 value = 0;
+        for (uint n = 0; n < bits; ++n, ++position) {
+            value |= u32((in[position / 8] >> (position % 8)) & 1) << n;
+        }
+        return value;
+    }
+};
+
+// principal axis of the pixel cloud (power iteration on the covariance), used to find good endpoints
+template <int Channels>
+void Principal_Axis(Block_Pixels const& pixels, float mean[Channels], float axis[Channels])
+{
+    const float* channels[4] = { pixels.r, pixels.g, pixels.b, pixels.a };
+
+    for (int c = 0; c < Channels; ++c) {
+        mean[c] = 0.0f;
+        for (int n = 0; n < 16; ++n) { mean[c] += channels[c][n]; }
+        mean[c] /= 16.0f;
+    }
+
+    float covariance[Channels][Channels] = {};
+    for (int n = 0; n < 16; ++n) {
+        for (int i = 0; i < Channels; ++i) {
+            for (int j = 0; j < Channels; ++j) {
+                covariance[i][j] += (channels[i][n] - mean[i]) * (channels[j][n] - mean[j]);
+            }
+        }
+    }
+
+    // start with the covariance row of the channel that varies most, it is never orthogonal to the
+    // principal axis (a fixed start like (1, 1, 1) is, for pixels that differ by e.g. (-2, 1, 1))
+    int widest = 0;
+    for (int c = 1; c < Channels; ++c) {
+        if (covariance[c][c] > covariance[widest][widest]) { widest = c; }
+    }
+    for (int c = 0; c < Channels; ++c) { axis[c] = covariance[widest][c]; }
+    for (int iteration = 0; iteration < 8; ++iteration) {
+        float next[Channels] = {};
+        float length = 0.0f;
+        for (int i = 0; i < Channels; ++i) {
+            for (int j = 0; j < Channels; ++j) { next[i] += covariance[i][j] * axis[j]; }
+            length = std::max(length, std::abs(next[i]));
+        }
+        if (length == 0.0f) { break; } // all pixels are the same
+        for (int c = 0; c < Channels; ++c) { axis[c] = next[c] / length; }
+    }
+
+    float length = 0.0f;
+    for (int c = 0; c < Channels; ++c) { length += axis[c] * axis[c]; }
+    length = std::sqrt(length);
+    for (int c = 0; c < Channels; ++c) { axis[c] = length > 0.0f ? axis[c] / length : 0.0f; }
+}
+
+// extreme projections onto the axis, moved in by 1/16 of the range (reduces the error of the inner pixels)
+template <int Channels>
+void Axis_Endpoints(Block_Pixels const& pixels, float low[Channels], float high[Channels])
+{
+    const float* channels[4] = { pixels.r, pixels.g, pixels.b, pixels.a };
+
+    float mean[Channels], axis[Channels];
+    Principal_Axis<Channels>(pixels, mean, axis);
+
+    float min_t = 0.0f, max_t = 0.0f;
+    for (int n = 0; n < 16; ++n) {
+        float t = 0.0f;
+        for (int c = 0; c < Channels; ++c) { t += (channels[c][n] - mean[c]) * axis[c]; }
+        min_t = std::min(min_t, t);
+        max_t = std::max(max_t, t);
+    }
+
+    float const inset = (max_t - min_t) / 16.0f;
+    min_t += inset;
+    max_t -= inset;
+
+    for (int c = 0; c < Channels; ++c) {
+        low[c]  = std::clamp(mean[c] + axis[c] * min_t, 0.0f, 255.0f);
+        high[c] = std::clamp(mean[c] + axis[c] * max_t, 0.0f, 255.0f);
+    }
+}
+
+// ---------------------------------------------
+// bc1 (color part of bc3 as well)
+// ---------------------------------------------
+
+u16 To_565(float const color[3])
+{
+    uint const r = uint(std::lround(color[0] * 31.0f / 255.0f));
+    uint const g = uint(std::lround(color[1] * 63.0f / 255.0f));
+    uint const b = uint(std::lround(color[2] * 31.0f / 255.0f));
+    return u16((r << 11) | (g << 5) | b);
+}
+
+void From_565(u16 color, int rgb[3])
+{
+    int const r = (color >> 11) & 31;
+    int const g = (color >> 5) & 63;
+    int const b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// the 4 color palette as the reference decoder produces it
+Block_Palette BC1_Palette(u16 color0, u16 color1)
+{
+    int c0[3], c1[3];
+    From_565(color0, c0);
+    From_565(color1, c1);
+
+    Block_Palette palette{};
+    palette.size = 4;
+    float* channels[3] = { palette.r, palette.g, palette.b };
+    for (int c = 0; c < 3; ++c) {
+        channels[c][0] = float(c0[c]);
+        channels[c][1] = float(c1[c]);
+        channels[c][2] = float((2 * c0[c] + c1[c]) / 3);
+        channels[c][3] = float((c0[c] + 2 * c1[c]) / 3);
+    }
+    return palette;
+}
+
+struct BC1_Result {
+    u16   color0 = 0;
+    u16   color1 = 0;
+    u8    indices[16] = {};
+    float error = 0.0f;
+};
+
+// color0 > color1 selects the 4 color mode, which is the only one the encoder uses
+BC1_Result BC1_Fit(Block_Pixels const& pixels, float const low[3], float const high[3], Index_Search select_indices)
+{
+    BC1_Result result{};
+    result.color0 = To_565(high);
+    result.color1 = To_565(low);
+    if (result.color0 < result.color1) {
+        std::swap(result.color0, result.color1);
+    }
+
+    Channel_Weights const weights{ 1.0f, 1.0f, 1.0f, 0.0f };
+    if (result.color0 == result.color1) {
+        // a single color: index 0 everywhere
+        Block_Palette palette = BC1_Palette(result.color0, result.color1);
+        palette.size = 1;
+        result.error = select_indices(pixels, palette, weights, result.indices);
+        return result;
+    }
+
+    result.error = select_indices(pixels, BC1_Palette(result.color0, result.color1), weights, result.indices);
+    return result;
+}
+
+// least squares endpoints for the chosen indices
+bool BC1_Refine(Block_Pixels const& pixels, u8 const indices[16], float low[3], float high[3])
+{
+    static constexpr float weight0[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    const float* channels[3] = { pixels.r, pixels.g, pixels.b };
+
+    float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+    float ax[3] = {}, bx[3] = {};
+    for (int n = 0; n < 16; ++n) {
+        float const a = weight0[indices[n]];
+        float const b = 1.0f - a;
+        aa += a * a;
+        ab += a * b;
+        bb += b * b;
+        for (int c = 0; c < 3; ++c) {
+            ax[c] += a * channels[c][n];
+            bx[c] += b * channels[c][n];
+        }
+    }
+
+    float const determinant = aa * bb - ab * ab;
+    if (std::abs(determinant) < 1e-6f) { return false; }
+
+    for (int c = 0; c < 3; ++c) {
+        high[c] = std::clamp((ax[c] * bb - bx[c] * ab) / determinant, 0.0f, 255.0f);
+        low[c]  = std::clamp((bx[c] * aa - ax[c] * ab) / determinant, 0.0f, 255.0f);
+    }
+    return true;
+}
+
+void Encode_BC1_Color(Block_Pixels const& pixels, Byte* block, Index_Search select_indices)
+{
+    float low[3], high[3];
+    Axis_Endpoints<3>(pixels, low, high);
+    BC1_Result best = BC1_Fit(pixels, low, high, select_indices);
+
+    // one least squares pass usually takes off another few percent of the error
+    if (BC1_Refine(pixels, best.indices, low, high)) {
+        BC1_Result const refined = BC1_Fit(pixels, low, high, select_indices);
+        if (refined.error < best.error) { best = refined; }
+    }
+
+    u32 bits = 0;
+    for (int n = 0; n < 16; ++n) { bits |= u32(best.indices[n]) << (2 * n); }
+
+    block[0] = Byte(best.color0);
+    block[1] = Byte(best.color0 >> 8);
+    block[2] = Byte(best.color1);
+    block[3] = Byte(best.color1 >> 8);
+    std::memcpy(block + 4, &bits, 4);
+}
+
+// four_color_only: the color block of bc3 ignores the 3 color mode
+void Decode_BC1_Color(const Byte* block, uchar rgba[64], bool four_color_only)
+{
+    u16 const color0 = u16(block[0] | (block[1] << 8));
+    u16 const color1 = u16(block[2] | (block[3] << 8));
+    u32 bits;
+    std::memcpy(&bits, block + 4, 4);
+
+    int c0[3], c1[3];
+    From_565(color0, c0);
+    From_565(color1, c1);
+
+    int palette[4][4];
+    for (int c = 0; c < 3; ++c) {
+        palette[0][c] = c0[c];
+        palette[1][c] = c1[c];
+        if (color0 > color1 || four_color_only) {
+            palette[2][c] = (2 * c0[c] + c1[c]) / 3;
+            palette[3][c] = (c0[c] + 2 * c1[c]) / 3;
+        }
+        else {
+            palette[2][c] = (c0[c] + c1[c]) / 2;
+            palette[3][c] = 0;
+        }
+    }
+    palette[0][3] = palette[1][3] = palette[2][3] = 255;
+    palette[3][3] = (color0 > color1 || four_color_only) ? 255 : 0;
+
+    for (int n = 0; n < 16; ++n) {
+        int const index = (bits >> (2 * n)) & 3;
+        for (int c = 0; c < 4; ++c) { rgba[n * 4 + c] = uchar(palette[index][c]); }
+    }
+}
+
+// ---------------------------------------------
+// bc4 (alpha of bc3, both channels of bc5)
+// ---------------------------------------------
+
+void Encode_BC4(const float values[16], Byte* block, Index_Search select_indices)
+{
+    float low = values[0], high = values[0];
+    for (int n = 1; n < 16; ++n) {
+        low  = std::min(low, values[n]);
+        high = std::max(high, values[n]);
+    }
+
+    // endpoint0 > endpoint1 selects the 8 value mode
+    int const endpoint0 = int(std::lround(high));
+    int const endpoint1 = int(std::lround(low));
+
+    Block_Pixels pixels{};
+    std::memcpy(pixels.r, values, sizeof(pixels.r));
+
+    Block_Palette palette{};
+    palette.size = endpoint0 == endpoint1 ? 1 : 8;
+    palette.r[0] = float(endpoint0);
+    palette.r[1] = float(endpoint1);
+    for (int k = 1; k < 7; ++k) {
+        palette.r[k + 1] = float(((7 - k) * endpoint0 + k * endpoint1) / 7);
+    }
+
+    u8 indices[16];
+    select_indices(pixels, palette, { 1.0f, 0.0f, 0.0f, 0.0f }, indices);
+
+    std::memset(block, 0, 8);
+    block[0] = Byte(endpoint0);
+    block[1] = Byte(endpoint1);
+    Bit_Writer writer{ block, 16 };
+    for (int n = 0; n < 16; ++n) { writer.write(indices[n], 3); }
+}
+
+void Decode_BC4(const Byte* block, uchar* out, int stride)
+{
+    int const endpoint0 = block[0];
+    int const endpoint1 = block[1];
+
+    int palette[8] = { endpoint0, endpoint1 };
+    if (endpoint0 > endpoint1) {
+        for (int k = 1; k < 7; ++k) { palette[k + 1] = ((7 - k) * endpoint0 + k * endpoint1) / 7; }
+    }
+    else {
+        for (int k = 1; k < 5; ++k) { palette[k + 1] = ((5 - k) * endpoint0 + k * endpoint1) / 5; }
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    Bit_Reader reader{ block, 16 };
+    for (int n = 0; n < 16; ++n) {
+        out[n * stride] = uchar(palette[reader.read(3)]);
+    }
+}
+
+// ---------------------------------------------
+// bc7 mode 6: one subset, rgba endpoints with 7 bits + a p-bit each, 4 bit indices.
+// the only bc7 mode this module writes or reads, by design: it fits the smooth content of most
+// textures, and searching the partitions of the other modes would cost far more per block
+// ---------------------------------------------
+
+constexpr int BC7_Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+int BC7_Interpolate(int e0, int e1, int index)
+{
+    return ((64 - BC7_Weights[index]) * e0 + BC7_Weights[index] * e1 + 32) >> 6;
+}
+
+// 7 bit components + the p-bit that fits the endpoint best
+void BC7_Quantize(float const endpoint[4], int quantized[4], int& p_bit)
+{
+    float best_error = 3.4e38f;
+    for (int p = 0; p < 2; ++p) {
+        int   candidate[4];
+        float error = 0.0f;
+        for (int c = 0; c < 4; ++c) {
+            candidate[c] = std::clamp(int(std::lround((endpoint[c] - p) / 2.0f)), 0, 127);
+            float const d = float((candidate[c] << 1) | p) - endpoint[c];
+            error += d * d;
+        }
+        if (error < best_error) {
+            best_error = error;
+            p_bit = p;
+            std::copy(candidate, candidate + 4, quantized);
+        }
+    }
+}
+
+void Encode_BC7_Mode6(Block_Pixels const& pixels, Byte* block, Index_Search select_indices)
+{
+    float low[4], high[4];
+    Axis_Endpoints<4>(pixels, low, high);
+
+    int e[2][4], p[2];
+    BC7_Quantize(low, e[0], p[0]);
+    BC7_Quantize(high, e[1], p[1]);
+
+    Block_Palette palette{};
+    palette.size = 16;
+    float* channels[4] = { palette.r, palette.g, palette.b, palette.a };
+    for (int c = 0; c < 4; ++c) {
+        int const e0 = (e[0][c] << 1) | p[0];
+        int const e1 = (e[1][c] << 1) | p[1];
+        for (int k = 0; k < 16; ++k) { channels[c][k] = float(BC7_Interpolate(e0, e1, k)); }
+    }
+
+    u8 indices[16];
+    select_indices(pixels, palette, {}, indices);
+
+    // the highest bit of the first index is implicit 0, swapping the endpoints flips all indices
+    if (indices[0] & 8) {
+        std::swap(e[0], e[1]);
+        std::swap(p[0], p[1]);
+        for (u8& index : indices) { index = u8(15 - index); }
+    }
+
+    std::memset(block, 0, 16);
+    Bit_Writer writer{ block, 0 };
+    writer.write(1 << 6, 7); // mode 6
+    for (int c = 0; c < 4; ++c) {
+        writer.write(e[0][c], 7);
+        writer.write(e[1][c], 7);
+    }
+    writer.write(p[0], 1);
+    writer.write(p[1], 1);
+    writer.write(indices[0], 3);
+    for (int n = 1; n < 16; ++n) { writer.write(indices[n], 4); }
+}
+
+void Decode_BC7(const Byte* block, uchar rgba[64])
+{
+    // the other modes are never written by Encode_BC7_Mode6, they decode to transparent black
+    if ((block[0] & 0x7F) != (1 << 6)) {
+        std::memset(rgba, 0, 64);
+        return;
+    }
+
+    Bit_Reader reader{ block, 7 };
+    int e[2][4];
+    for (int c = 0; c < 4; ++c) {
+        e[0][c] = reader.read(7);
+        e[1][c] = reader.read(7);
+    }
+    int const p0 = reader.read(1);
+    int const p1 = reader.read(1);
+
+    for (int n = 0; n < 16; ++n) {
+        int const index = reader.read(n == 0 ? 3 : 4);
+        for (int c = 0; c < 4; ++c) {
+            rgba[n * 4 + c] = uchar(BC7_Interpolate((e[0][c] << 1) | p0, (e[1][c] << 1) | p1, index));
+        }
+    }
+}
+
+#pragma endregion
+
+void Encode_Block(Block_Format format, const uchar rgba[64], Byte* block, Block_Path path)
+{
+    Block_Pixels const pixels = To_Block_Pixels(rgba);
+    Index_Search const select = Select_Index_Search(path);
+
+    switch (format) {
+    case bc1:
+        Encode_BC1_Color(pixels, block, select);
+        break;
+    case bc3:
+        Encode_BC4(pixels.a, block, select);
+        Encode_BC1_Color(pixels, block + 8, select);
+        break;
+    case bc5:
+        Encode_BC4(pixels.r, block, select);
+        Encode_BC4(pixels.g, block + 8, select);
+        break;
+    case bc7:
+        Encode_BC7_Mode6(pixels, block, select);
+        break;
+    }
+}
+
+void Decode_Block(Block_Format format, const Byte* block, uchar rgba[64])
+{
+    switch (format) {
+    case bc1:
+        Decode_BC1_Color(block, rgba, false);
+        break;
+    case bc3:
+        Decode_BC1_Color(block + 8, rgba, true);
+        Decode_BC4(block, rgba + 3, 4);
+        break;
+    case bc5:
+        std::memset(rgba, 0, 64);
+        Decode_BC4(block, rgba + 0, 4);
+        Decode_BC4(block + 8, rgba + 1, 4);
+        for (int n = 0; n < 16; ++n) { rgba[n * 4 + 3] = 255; }
+        break;
+    case bc7:
+        Decode_BC7(block, rgba);
+        break;
+    }
+}
+
+Bytes Compress_Image(Block_Format format, const uchar* rgba, int width, int height, uint thread_count, Block_Path path)
+{
+    int const blocks_x = Block_Count(width);
+    int const blocks_y = Block_Count(height);
+
+    Bytes blocks(std::size_t(blocks_x) * blocks_y * Block_Bytes(format));
+
+    // one task per block row, every block has its own spot in the output
+    Parallel_For(std::size_t(blocks_y), thread_count, [&](std::size_t block_y) {
+        uchar pixels[64];
+        for (int block_x = 0; block_x < blocks_x; ++block_x) {
+            for (int n = 0; n < 16; ++n) {
+                int const x = std::min(block_x * 4 + n % 4, width - 1);
+                int const y = std::min(int(block_y) * 4 + n / 4, height - 1);
+                std::memcpy(pixels + n * 4, rgba + (std::size_t(y) * width + x) * 4, 4);
+            }
+            Byte* block = blocks.data() + (block_y * blocks_x + block_x) * Block_Bytes(format);
+            Encode_Block(format, pixels, block, path);
+        }
+    });
+
+    return blocks;
+}
+
+void Decompress_Image(Block_Format format, const Byte* blocks, int width, int height, uchar* rgba)
+{
+    int const blocks_x = Block_Count(width);
+    int const blocks_y = Block_Count(height);
+
+    uchar pixels[64];
+    for (int block_y = 0; block_y < blocks_y; ++block_y) {
+        for (int block_x = 0; block_x < blocks_x; ++block_x) {
+            const Byte* block = blocks + (std::size_t(block_y) * blocks_x + block_x) * Block_Bytes(format);
+            Decode_Block(format, block, pixels);
+
+            for (int n = 0; n < 16; ++n) {
+                int const x = block_x * 4 + n % 4;
+                int const y = block_y * 4 + n / 4;
+                if (x >= width || y >= height) { continue; }
+                std::memcpy(rgba + (std::size_t(y) * width + x) * 4, pixels + n * 4, 4);
+            }
+        }
+    }
+}
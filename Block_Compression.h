@@ -0,0 +1,46 @@
+#pragma once
+
+// --------------------------------------------------
+// block compression (BCn) encoders and reference decoders, cpu only.
+// every format works on 4x4 pixel blocks of rgba8 input:
+//   bc1: rgb, 8 bytes per block (alpha is ignored)
+//   bc3: rgba, 16 bytes (bc4 alpha + bc1 color)
+//   bc5: two channels (r, g), 16 bytes - for normal maps
+//   bc7: rgba, 16 bytes, mode 6 only (see below)
+// --------------------------------------------------
+
+#include "Common.h"
+
+enum Block_Format : u32 {
+    bc1,
+    bc3,
+    bc5,
+    bc7
+};
+
+constexpr std::size_t Block_Bytes(Block_Format format)
+{
+    return format == bc1 ? 8 : 16;
+}
+
+constexpr int Block_Count(int pixels)
+{
+    return (pixels + 3) / 4;
+}
+
+// how the encoders pick the palette index of each pixel, the blocks are byte identical either way
+enum Block_Path : u32 {
+    block_best,  // sse2 where the cpu has it
+    block_scalar // reference implementation
+};
+
+// one block: the 16 rgba pixels are given row by row.
+// bc7 is limited to mode 6 on purpose (one subset, 4 bit indices): it suits the smooth content
+// of most textures and avoids the partition search of the other modes. the decoder only reads
+// what the encoder writes, bc7 blocks of any other mode decode to transparent black
+void Encode_Block(Block_Format format, const uchar rgba[64], Byte* block, Block_Path path = block_best);
+void Decode_Block(Block_Format format, const Byte* block, uchar rgba[64]);
+
+// whole images, rgba8 rows without padding. blocks that reach past the border repeat the edge pixels.
+Bytes Compress_Image(Block_Format format, const uchar* rgba, int width, int height, uint thread_count = 1, Block_Path path = block_best);
+void  Decompress_Image(Block_Format format, const Byte* blocks, int width, int height, uchar* rgba);
@@ -0,0 +1,102 @@
+#pragma once
+
+// --------------------------------------------------
+// instruction sets of the machine we run on. code for the wider sets is
+// compiled with TARGET_AVX2/TARGET_AVX512 and only called after checking
+// Get_Cpu_Features(), sse2 (every x64 cpu) and neon (every arm64 cpu) are
+// checked at compile time.
+// --------------------------------------------------
+
+#include <stdint.h> // no Common.h, the math headers include this one
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define CPU_SSE2 1
+#endif
+
+#if defined(__aarch64__) || defined(_M_ARM64)
+#define CPU_NEON 1
+#endif
+
+#if defined(CPU_X86) && defined(__clang__)
+#define TARGET_AVX2   __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+#elif defined(CPU_X86) && defined(__GNUC__)
+// avx512f implies fma, keep gcc from fusing mul + add so results match the other paths
+#define TARGET_AVX2   __attribute__((target("avx2")))
+#define TARGET_AVX512 __attribute__((target("avx512f"), optimize("fp-contract=off")))
+#else
+#define TARGET_AVX2
+#define TARGET_AVX512
+#endif
+
+struct Cpu_Features {
+    bool sse2   = false;
+    bool avx2   = false;
+    bool avx512 = false; // avx512f
+};
+
+#if defined(CPU_X86)
+inline void Cpu_Id(uint32_t leaf, uint32_t subleaf, uint32_t registers[4])
+{
+#if defined(_MSC_VER)
+    int values[4];
+    __cpuidex(values, int(leaf), int(subleaf));
+    for (int n = 0; n < 4; ++n) { registers[n] = uint32_t(values[n]); }
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+// which register sets the os saves on a context switch
+inline uint64_t Os_Saved_State()
+{
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    uint32_t low, high;
+    __asm__("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return (uint64_t(high) << 32) | low;
+#endif
+}
+#endif
+
+inline Cpu_Features Detect_Cpu_Features()
+{
+    Cpu_Features features{};
+#if defined(CPU_X86)
+    uint32_t registers[4]; // eax, ebx, ecx, edx
+    Cpu_Id(0, 0, registers);
+    uint32_t const max_leaf = registers[0];
+
+    Cpu_Id(1, 0, registers);
+    features.sse2 = (registers[3] >> 26) & 1;
+
+    bool const os_saves_avx = ((registers[2] >> 27) & 1) && (Os_Saved_State() & 0x6) == 0x6;
+    if (!os_saves_avx || max_leaf < 7) {
+        return features;
+    }
+
+    bool const os_saves_avx512 = (Os_Saved_State() & 0xE6) == 0xE6;
+
+    Cpu_Id(7, 0, registers);
+    features.avx2   = (registers[1] >> 5) & 1;
+    features.avx512 = os_saves_avx512 && ((registers[1] >> 16) & 1);
+#endif
+    return features;
+}
+
+// detected once, thread safe
+inline Cpu_Features const& Get_Cpu_Features()
+{
+    static Cpu_Features const features = Detect_Cpu_Features();
+    return features;
+}
@@ -0,0 +1,112 @@
+#include "Draw_Keys.h"
+#include "Hash.h"
+
+#include <cstring>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+constexpr int Pass_Bits    = 1;
+constexpr int Shader_Bits  = 10;
+constexpr int Texture_Bits = 12;
+constexpr int VAO_Bits     = 10;
+constexpr int Depth_Bits   = 12;
+static_assert(Pass_Bits + Shader_Bits + Texture_Bits + VAO_Bits + Depth_Bits + Draw_Keys::Draw_Bits == 64);
+
+constexpr u64 Mask(int bits)
+{
+    return (u64(1) << bits) - 1;
+}
+
+u64 Texture_Set_Id(Textures const& textures)
+{
+    u64 h = 0;
+    for (Texture const& texture : textures) {
+        h = Mix_Bits(h ^ (u64(texture.type) << 32 | texture.id));
+    }
+    return h;
+}
+
+// the bits of a positive float sort like the float itself, the top ones are enough to order the draws
+u64 Depth_Bits_Of(float depth)
+{
+    depth = depth > 0.0f ? depth : 0.0f;
+    u32 bits = 0;
+    std::memcpy(&bits, &depth, sizeof(bits));
+    return bits >> (31 - Depth_Bits);
+}
+
+#pragma endregion
+
+u64 Draw_Keys::Make(u32 pass, bool back_to_front, uint program, Textures const& textures, uint VAO, float depth, u32 draw)
+{
+    u64 depth_bits = Depth_Bits_Of(depth);
+    if (back_to_front) {
+        depth_bits = ~depth_bits;
+    }
+
+    u64 key = u64(pass) & Mask(Pass_Bits);
+    key = key << Shader_Bits  | (program & Mask(Shader_Bits));
+    key = key << Texture_Bits | (Texture_Set_Id(textures) & Mask(Texture_Bits));
+    key = key << VAO_Bits     | (VAO & Mask(VAO_Bits));
+    key = key << Depth_Bits   | (depth_bits & Mask(Depth_Bits));
+    key = key << Draw_Bits    | (draw & Mask(Draw_Bits));
+    return key;
+}
+
+void Draw_Keys::Sort(std::vector<u64>& keys, std::vector<u64>& scratch, std::vector<u32>& histograms, int first_bit)
+{
+    // 12 bits per digit, the counts of a digit fit into the l1 cache (16 kB) and the 45 bits
+    // above the draw index take 4 passes at most
+    constexpr int Digit_Bits   = 12;
+    constexpr int Max_Digits   = (64 + Digit_Bits - 1) / Digit_Bits;
+    constexpr u32 Bucket_Count = u32(1) << Digit_Bits;
+
+    // most bits are the same in every key (pass, shader, ...), the digits only start at bits that differ
+    u64 all_set = ~u64(0);
+    u64 any_set = 0;
+    for (u64 key : keys) {
+        all_set &= key;
+        any_set |= key;
+    }
+    u64 const varying = any_set & ~all_set & ~Mask(first_bit);
+
+    int digit_shifts[Max_Digits] = {};
+    int digit_count              = 0;
+    for (int bit = first_bit; bit < 64;) {
+        if (((varying >> bit) & 1) == 0) {
+            bit++;
+            continue;
+        }
+        digit_shifts[digit_count++] = bit;
+        bit += Digit_Bits;
+    }
+
+    // every histogram in one read
+    histograms.assign(std::size_t(digit_count) * Bucket_Count, 0);
+    for (u64 key : keys) {
+        for (int digit = 0; digit < digit_count; ++digit) {
+            histograms[digit * Bucket_Count + ((key >> digit_shifts[digit]) & (Bucket_Count - 1))]++;
+        }
+    }
+
+    scratch.resize(keys.size());
+    for (int digit = 0; digit < digit_count; ++digit) {
+        u32* const histogram = &histograms[digit * Bucket_Count];
+        int const  shift     = digit_shifts[digit];
+
+        u32 offset = 0;
+        for (u32 bucket = 0; bucket < Bucket_Count; ++bucket) {
+            u32 const bucket_size = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucket_size;
+        }
+        u64* const sorted = scratch.data();
+        for (u64 key : keys) {
+            sorted[histogram[(key >> shift) & (Bucket_Count - 1)]++] = key;
+        }
+        keys.swap(scratch);
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "Common.h"
+#include "Texture.h"
+
+#include <vector>
+
+// --------------------------------------------------
+// the 64 bit sort keys of Render_Queue, without any gl. from the most
+// significant bits down:
+//   pass 1 | shader 10 | texture set 12 | VAO 10 | depth 12 | draw 19
+// the ids are truncated and the texture set is hashed, a collision only
+// costs a state change. the draw index in the low bits makes the key its
+// own payload, the sort moves 8 bytes per draw instead of a key & index.
+// --------------------------------------------------
+namespace Draw_Keys {
+
+constexpr int         Draw_Bits = 19;
+constexpr std::size_t Max_Draws = std::size_t(1) << Draw_Bits;
+
+// pass: 0 or 1. back_to_front: the larger depth first, else the smaller (depth only orders equal state)
+u64 Make(u32 pass, bool back_to_front, uint program, Textures const& textures, uint VAO, float depth, u32 draw);
+
+inline u32 Draw(u64 key)
+{
+    return u32(key & (Max_Draws - 1));
+}
+
+// lsd radix sort, ascending by the bits from first_bit up. stable: the bits below keep the order
+// they had (Render_Queue adds its draws in order, so those need no sorting).
+// scratch & histograms are only kept to reuse their memory
+void Sort(std::vector<u64>& keys, std::vector<u64>& scratch, std::vector<u32>& histograms, int first_bit = Draw_Bits);
+
+}
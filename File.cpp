@@ -5,6 +5,17 @@
 #include <cassert>
 #include <iostream>
 
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 File::Text File::ReadFull(const char* file_name)
 {
     std::ifstream fs(file_name);
@@ -22,4 +33,85 @@ File::Text File::ReadFull(const char* file_name)
 File::Text_Pair File::ReadFull(const char* file_name1, const char* file_name2)
 {
     return std::make_pair(File::ReadFull(file_name1), File::ReadFull(file_name2));
-}
\ No newline at end of file
+}
+
+// ---------------------------------------------
+// memory mapped files
+// ---------------------------------------------
+#if defined(_WIN32)
+
+File::Mapped::Mapped(const char* file_name)
+{
+    HANDLE file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to map file " << file_name << '\n';
+        assert(false);
+        return;
+    }
+    file_handle = file;
+
+    LARGE_INTEGER file_size = {};
+    GetFileSizeEx(file, &file_size);
+    size = static_cast<std::size_t>(file_size.QuadPart);
+    open = true;
+
+    // an empty file can't be mapped, but it is still a valid (empty) view
+    if (size == 0) { return; }
+
+    mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle != nullptr) {
+        data = static_cast<const char*>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    }
+    if (data == nullptr) {
+        std::cerr << "Failed to map file " << file_name << '\n';
+        assert(false);
+        size = 0;
+        open = false;
+    }
+}
+
+File::Mapped::~Mapped()
+{
+    if (data)           { UnmapViewOfFile(data); }
+    if (mapping_handle) { CloseHandle(mapping_handle); }
+    if (file_handle)    { CloseHandle(file_handle); }
+}
+
+#else
+
+File::Mapped::Mapped(const char* file_name)
+{
+    int file = ::open(file_name, O_RDONLY);
+    if (file == -1) {
+        std::cerr << "Failed to map file " << file_name << '\n';
+        assert(false);
+        return;
+    }
+
+    struct stat info = {};
+    fstat(file, &info);
+    size = static_cast<std::size_t>(info.st_size);
+    open = true;
+
+    // an empty file can't be mapped, but it is still a valid (empty) view
+    void* view = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0) : nullptr;
+    ::close(file); // the mapping stays valid after the descriptor is closed
+
+    if (view == nullptr) { return; }
+    if (view == MAP_FAILED) {
+        std::cerr << "Failed to map file " << file_name << '\n';
+        assert(false);
+        size = 0;
+        open = false;
+        return;
+    }
+    madvise(view, size, MADV_SEQUENTIAL);
+    data = static_cast<const char*>(view);
+}
+
+File::Mapped::~Mapped()
+{
+    if (data) { munmap(const_cast<char*>(data), size); }
+}
+
+#endif
@@ -1,5 +1,7 @@
 #pragma once
 
+#include "Common.h"
+
 #include <string>
 #include <optional>  // needs c++17 compiler...
 
@@ -12,4 +14,26 @@ using Text_Pair = std::pair<Text, Text>;
 Text      ReadFull(const char* file_name);
 Text_Pair ReadFull(const char* file_name1, const char* file_name2);
 
-}
\ No newline at end of file
+// read-only view of a whole file, mapped into the address space instead of copied
+struct Mapped {
+
+    Mapped(const char* file_name);
+    ~Mapped();
+
+    bool is_open() const { return open; }
+
+    const char* data = nullptr;
+    std::size_t size = 0;
+    bool        open = false;
+
+    no_copy_and_assign(Mapped);
+    no_move_and_assign(Mapped);
+
+private:
+#if defined(_WIN32)
+    void* file_handle    = nullptr;
+    void* mapping_handle = nullptr;
+#endif
+};
+
+}
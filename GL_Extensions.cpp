@@ -0,0 +1,63 @@
+#include "GL_Extensions.h"
+#include "Graphics.h"
+
+#ifndef GL_VERSION_4_1
+PFNGLGETPROGRAMBINARYPROC  glad_glGetProgramBinary  = nullptr;
+PFNGLPROGRAMBINARYPROC     glad_glProgramBinary     = nullptr;
+PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri = nullptr;
+#endif
+#ifndef GL_VERSION_4_3
+PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect = nullptr;
+#endif
+#ifndef GL_VERSION_4_4
+PFNGLBUFFERSTORAGEPROC glad_glBufferStorage = nullptr;
+#endif
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+GL::Extensions Loaded_Extensions{};
+
+bool Has_Version(int major, int minor)
+{
+    return GLVersion.major > major || (GLVersion.major == major && GLVersion.minor >= minor);
+}
+
+#pragma endregion
+
+void GL::Load_Extensions(GLADloadproc load)
+{
+    Extensions extensions{};
+
+    if (Has_Version(4, 1) || Has_Extension("GL_ARB_get_program_binary")) {
+        glGetProgramBinary  = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(load("glGetProgramBinary"));
+        glProgramBinary     = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(load("glProgramBinary"));
+        glProgramParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(load("glProgramParameteri"));
+
+        // a driver may support the functions without any format it can save in
+        GLint format_count = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &format_count);
+        extensions.program_binary = glGetProgramBinary && glProgramBinary && glProgramParameteri && format_count > 0;
+    }
+
+    if (Has_Version(4, 3) || Has_Extension("GL_ARB_multi_draw_indirect")) {
+        glMultiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(load("glMultiDrawElementsIndirect"));
+        extensions.multi_draw_indirect = glMultiDrawElementsIndirect != nullptr;
+    }
+    extensions.shader_storage_buffer  = Has_Version(4, 3) || Has_Extension("GL_ARB_shader_storage_buffer_object");
+    extensions.shader_draw_parameters = Has_Extension("GL_ARB_shader_draw_parameters");
+
+    if (Has_Version(4, 4) || Has_Extension("GL_ARB_buffer_storage")) {
+        glBufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(load("glBufferStorage"));
+        extensions.buffer_storage = glBufferStorage != nullptr;
+    }
+
+    Loaded_Extensions = extensions;
+}
+
+GL::Extensions const& GL::Get_Extensions()
+{
+    return Loaded_Extensions;
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+// --------------------------------------------------
+// the glad loader stops at gl 4.0, the newer entry points the renderer
+// can use are loaded here by hand: from the core version if the context
+// has it, otherwise from the ARB extension. everything is off until
+// GL::Load_Extensions() ran (Global_Init does that), code using one of
+// these has to check Get_Extensions() and keep a 4.0 fallback
+// --------------------------------------------------
+
+#include <glad/glad.h>
+
+// 4.1 / ARB_get_program_binary
+#ifndef GL_VERSION_4_1
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+extern PFNGLGETPROGRAMBINARYPROC  glad_glGetProgramBinary;
+extern PFNGLPROGRAMBINARYPROC     glad_glProgramBinary;
+extern PFNGLPROGRAMPARAMETERIPROC glad_glProgramParameteri;
+#define glGetProgramBinary  glad_glGetProgramBinary
+#define glProgramBinary     glad_glProgramBinary
+#define glProgramParameteri glad_glProgramParameteri
+
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+#endif
+
+// 4.3 / ARB_multi_draw_indirect
+#ifndef GL_VERSION_4_3
+typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC glad_glMultiDrawElementsIndirect;
+#define glMultiDrawElementsIndirect glad_glMultiDrawElementsIndirect
+
+// 4.3 / ARB_shader_storage_buffer_object, the buffer functions themselves are 3.0
+#define GL_SHADER_STORAGE_BUFFER                  0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#endif
+
+// 4.4 / ARB_buffer_storage, immutable buffers that can stay mapped while gl reads them
+#ifndef GL_VERSION_4_4
+typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC glad_glBufferStorage;
+#define glBufferStorage glad_glBufferStorage
+
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT   0x0080
+#endif
+
+namespace GL {
+
+struct Extensions {
+    bool program_binary         = false; // 4.1 / ARB_get_program_binary, with at least one binary format
+    bool multi_draw_indirect    = false; // 4.3 / ARB_multi_draw_indirect
+    bool shader_storage_buffer  = false; // 4.3 / ARB_shader_storage_buffer_object
+    bool shader_draw_parameters = false; // gl_DrawIDARB, ARB_shader_draw_parameters (core in 4.6 as gl_DrawID)
+    bool buffer_storage         = false; // 4.4 / ARB_buffer_storage, persistent mapping
+};
+
+// needs a current context and the glad loader, load is the same function glad got
+void              Load_Extensions(GLADloadproc load);
+Extensions const& Get_Extensions();
+
+}
@@ -0,0 +1,270 @@
+#include "Geometry_Arena.h"
+#include "Graphics.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <glad/glad.h>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+// bytes per vertex in the first & second vertex buffer
+struct Strides {
+    u64 first  = 0;
+    u64 second = 0;
+};
+
+Strides Vertex_Strides(Mesh::Layout layout)
+{
+    switch (layout) {
+    case Mesh::split:  return { sizeof(float3), sizeof(Vertex_Attributes) };
+    case Mesh::packed: return { sizeof(Packed_Vertex), 0 };
+    default:           return { sizeof(Vertex), 0 };
+    }
+}
+
+uint New_Buffer(u64 size)
+{
+    uint buffer = 0;
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, GLsizeiptr(size), nullptr, GL_STATIC_DRAW);
+    return buffer;
+}
+
+// a new buffer of new_size bytes with the ranges of the old one at their new place (offsets & sizes
+// in units of unit bytes), the old buffer is deleted
+uint Copy_Ranges(uint old_buffer, u64 new_size, std::vector<Offset_Allocator::Move> const& moves, u64 unit)
+{
+    uint const buffer = New_Buffer(new_size);
+    glBindBuffer(GL_COPY_READ_BUFFER, old_buffer);
+
+    // neighbours that move by the same distance are one copy
+    for (std::size_t m = 0; m < moves.size(); /**/) {
+        u64 const from = moves[m].from;
+        u64 const to   = moves[m].to;
+        u64       size = moves[m].size;
+        for (++m; m < moves.size() && moves[m].from == from + size && moves[m].to == to + size; ++m) {
+            size += moves[m].size;
+        }
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GLintptr(from * unit), GLintptr(to * unit), GLsizeiptr(size * unit));
+    }
+
+    glDeleteBuffers(1, &old_buffer);
+    return buffer;
+}
+
+// where defragment() put the allocation that was at offset
+u64 Relocate(std::vector<Offset_Allocator::Move> const& moves, u64 offset)
+{
+    auto const move = std::lower_bound(moves.begin(), moves.end(), offset, [](Offset_Allocator::Move const& m, u64 o) { return m.from < o; });
+    assert(move != moves.end() && move->from == offset);
+    return move->to;
+}
+
+#pragma endregion
+
+GL::Geometry_Arena::Geometry_Arena(u64 vertex_capacity, u64 index_capacity)
+    : initial_vertex_capacity(std::max<u64>(vertex_capacity, 1)), initial_index_capacity(std::max<u64>(index_capacity, 4))
+{
+}
+
+GL::Geometry_Arena::~Geometry_Arena()
+{
+    for (Pool& pool : pools) {
+        assert(pool.meshes.empty() && "meshes still use the arena");
+        glDeleteVertexArrays(1, &pool.VAO);
+        glDeleteBuffers(1, &pool.VBO);
+        glDeleteBuffers(1, &pool.attribute_VBO);
+        glDeleteBuffers(1, &pool.EBO);
+    }
+}
+
+void GL::Geometry_Arena::allocate(Mesh& mesh)
+{
+    assert(mesh.VAO == 0 && "the mesh is already on the gpu");
+
+    Mesh::Layout const layout = mesh.layout;
+    Pool& pool = pools[layout];
+    if (pool.VAO == 0) {
+        create(pool, layout);
+    }
+
+    // empty meshes still get a range, the offset is the key of the allocation
+    u64 const vertex_count = std::max<u64>(mesh.vertex_count(), 1);
+    u32 const index_size   = mesh.vertex_count() <= Max_16_Bit_Vertices ? sizeof(u16) : sizeof(uint);
+    u64 const index_bytes  = std::max<u64>(mesh.indices.size() * index_size, index_size);
+
+    std::optional<u64> first_vertex = pool.vertices.allocate(vertex_count);
+    std::optional<u64> first_byte   = pool.indices.allocate(index_bytes, index_size);
+    if (!first_vertex || !first_byte) {
+        u64 const vertex_capacity = first_vertex ? 0 : std::max(pool.vertices.capacity() * 2, pool.vertices.capacity() + vertex_count);
+        u64 const index_capacity  = first_byte   ? 0 : std::max(pool.indices.capacity() * 2, pool.indices.capacity() + index_bytes + index_size);
+        grow(pool, layout, vertex_capacity, index_capacity);
+        first_vertex = first_vertex ? first_vertex : pool.vertices.allocate(vertex_count);
+        first_byte   = first_byte ? first_byte : pool.indices.allocate(index_bytes, index_size);
+    }
+    assert(first_vertex && first_byte);
+
+    // the copy targets leave the element buffer binding of whatever VAO is bound alone
+    Strides const strides = Vertex_Strides(layout);
+    GLintptr const vertex_offset = GLintptr(*first_vertex * strides.first);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.VBO);
+    if (layout == Mesh::split) {
+        Vertex_Streams const& streams = mesh.streams;
+        glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_offset, streams.positions.size() * sizeof(float3), streams.positions.data());
+        glBindBuffer(GL_COPY_WRITE_BUFFER, pool.attribute_VBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(*first_vertex * strides.second), streams.attributes.size() * sizeof(Vertex_Attributes), streams.attributes.data());
+    }
+    else if (layout == Mesh::packed) {
+        std::vector<Packed_Vertex> const& vertices = mesh.packed_vertices.vertices;
+        glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_offset, vertices.size() * sizeof(Packed_Vertex), vertices.data());
+    }
+    else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, vertex_offset, mesh.vertices.size() * sizeof(Vertex), mesh.vertices.data());
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, pool.EBO);
+    if (index_size == sizeof(u16)) {
+        std::vector<u16> const indices(mesh.indices.begin(), mesh.indices.end());
+        glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(*first_byte), indices.size() * sizeof(u16), indices.data());
+    }
+    else {
+        glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(*first_byte), mesh.indices.size() * sizeof(uint), mesh.indices.data());
+    }
+
+    mesh.VAO          = pool.VAO;
+    mesh.in_arena     = true;
+    mesh.base_vertex  = u32(*first_vertex);
+    mesh.index_offset = *first_byte;
+    mesh.index_size   = index_size;
+    pool.meshes.push_back(&mesh);
+}
+
+void GL::Geometry_Arena::free(Mesh& mesh)
+{
+    Pool& pool = pools[mesh.layout];
+    auto const at = std::find(pool.meshes.begin(), pool.meshes.end(), &mesh);
+    assert(mesh.in_arena && mesh.VAO == pool.VAO && at != pool.meshes.end() && "not a mesh of this arena (or it moved since allocate)");
+    if (!mesh.in_arena || at == pool.meshes.end()) {
+        return;
+    }
+
+    *at = pool.meshes.back();
+    pool.meshes.pop_back();
+    pool.vertices.free(mesh.base_vertex);
+    pool.indices.free(mesh.index_offset);
+
+    mesh.VAO          = 0;
+    mesh.in_arena     = false;
+    mesh.base_vertex  = 0;
+    mesh.index_offset = 0;
+}
+
+void GL::Geometry_Arena::defragment()
+{
+    measure_time();
+
+    for_size (layout, pools) {
+        Pool& pool = pools[layout];
+        if (pool.VAO == 0) {
+            continue;
+        }
+
+        std::vector<Offset_Allocator::Move> const vertex_moves = pool.vertices.defragment();
+        std::vector<Offset_Allocator::Move> const index_moves  = pool.indices.defragment();
+        auto const moved = [](Offset_Allocator::Move const& move) { return move.from != move.to; };
+        if (std::none_of(vertex_moves.begin(), vertex_moves.end(), moved) && std::none_of(index_moves.begin(), index_moves.end(), moved)) {
+            continue;
+        }
+
+        Strides const strides = Vertex_Strides(Mesh::Layout(layout));
+        pool.VBO = Copy_Ranges(pool.VBO, pool.vertices.capacity() * strides.first, vertex_moves, strides.first);
+        if (pool.attribute_VBO != 0) {
+            pool.attribute_VBO = Copy_Ranges(pool.attribute_VBO, pool.vertices.capacity() * strides.second, vertex_moves, strides.second);
+        }
+        pool.EBO = Copy_Ranges(pool.EBO, pool.indices.capacity(), index_moves, 1);
+
+        glBindVertexArray(pool.VAO);
+        Set_Vertex_Format(Mesh::Layout(layout), pool.VBO, pool.attribute_VBO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+        glBindVertexArray(0);
+
+        for (Mesh* mesh : pool.meshes) {
+            mesh->base_vertex  = u32(Relocate(vertex_moves, mesh->base_vertex));
+            mesh->index_offset = Relocate(index_moves, mesh->index_offset);
+        }
+    }
+}
+
+GL::Geometry_Stats GL::Geometry_Arena::stats() const
+{
+    Geometry_Stats stats{};
+    for_size (layout, pools) {
+        Pool const& pool = pools[layout];
+        Strides const strides = Vertex_Strides(Mesh::Layout(layout));
+        stats.vertex_bytes          += pool.vertices.used() * (strides.first + strides.second);
+        stats.vertex_capacity_bytes += pool.vertices.capacity() * (strides.first + strides.second);
+        stats.index_bytes           += pool.indices.used();
+        stats.index_capacity_bytes  += pool.indices.capacity();
+        stats.mesh_count            += pool.meshes.size();
+        stats.free_blocks           += pool.vertices.free_block_count() + pool.indices.free_block_count();
+    }
+    return stats;
+}
+
+void GL::Geometry_Arena::print_stats() const
+{
+    Geometry_Stats const s = stats();
+    std::cout << "geometry: " << s.mesh_count << " meshes, vertices " << s.vertex_bytes / 1024 << " / " << s.vertex_capacity_bytes / 1024
+              << " KB, indices " << s.index_bytes / 1024 << " / " << s.index_capacity_bytes / 1024 << " KB, " << s.free_blocks << " free blocks\n";
+}
+
+void GL::Geometry_Arena::create(Pool& pool, Mesh::Layout layout)
+{
+    Strides const strides = Vertex_Strides(layout);
+    pool.vertices = Offset_Allocator{ initial_vertex_capacity };
+    pool.indices  = Offset_Allocator{ initial_index_capacity };
+
+    pool.VBO = New_Buffer(initial_vertex_capacity * strides.first);
+    if (strides.second != 0) {
+        pool.attribute_VBO = New_Buffer(initial_vertex_capacity * strides.second);
+    }
+    pool.EBO = New_Buffer(initial_index_capacity);
+
+    glGenVertexArrays(1, &pool.VAO);
+    glBindVertexArray(pool.VAO);
+    Set_Vertex_Format(layout, pool.VBO, pool.attribute_VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+    glBindVertexArray(0);
+}
+
+void GL::Geometry_Arena::grow(Pool& pool, Mesh::Layout layout, u64 vertex_capacity, u64 index_capacity)
+{
+    measure_time();
+
+    // everything up to the old end stays where it is
+    Strides const strides = Vertex_Strides(layout);
+    if (vertex_capacity > pool.vertices.capacity()) {
+        std::vector<Offset_Allocator::Move> const all = { { 0, 0, pool.vertices.capacity() } };
+        pool.VBO = Copy_Ranges(pool.VBO, vertex_capacity * strides.first, all, strides.first);
+        if (pool.attribute_VBO != 0) {
+            pool.attribute_VBO = Copy_Ranges(pool.attribute_VBO, vertex_capacity * strides.second, all, strides.second);
+        }
+        pool.vertices.grow(vertex_capacity);
+    }
+    if (index_capacity > pool.indices.capacity()) {
+        std::vector<Offset_Allocator::Move> const all = { { 0, 0, pool.indices.capacity() } };
+        pool.EBO = Copy_Ranges(pool.EBO, index_capacity, all, 1);
+        pool.indices.grow(index_capacity);
+    }
+
+    glBindVertexArray(pool.VAO);
+    Set_Vertex_Format(layout, pool.VBO, pool.attribute_VBO);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.EBO);
+    glBindVertexArray(0);
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "Common.h"
+#include "Mesh.h"
+#include "Offset_Allocator.h"
+
+#include <array>
+#include <vector>
+
+namespace GL {
+
+struct Geometry_Stats {
+    u64         vertex_bytes          = 0; // every layout together
+    u64         vertex_capacity_bytes = 0;
+    u64         index_bytes           = 0;
+    u64         index_capacity_bytes  = 0;
+    std::size_t mesh_count            = 0;
+    std::size_t free_blocks           = 0; // the holes left by freed meshes
+};
+
+// --------------------------------------------------
+// static geometry of many meshes in a few big buffers: per Mesh::Layout
+// one VAO, one vertex buffer (two for the split layout) and one index
+// buffer. a mesh is a range of vertices and a range of index bytes in
+// them and is drawn with a base vertex, so meshes of the same layout
+// don't need a VAO switch. full buffers grow, the holes freed meshes
+// leave behind are closed by defragment()
+// --------------------------------------------------
+struct Geometry_Arena {
+
+    // the initial size of every layout (vertices & index bytes), its buffers are created with its first mesh
+    Geometry_Arena(u64 vertex_capacity = u64(1) << 20, u64 index_capacity = u64(16) << 20);
+    ~Geometry_Arena(); // every mesh has to be freed before
+
+    // instead of GL::Allocate_Mesh. the mesh has to stay at its address until it is freed,
+    // defragment() updates its ranges
+    void allocate(Mesh& mesh);
+    void free(Mesh& mesh);
+
+    // copies every layout into buffers of the same size without holes
+    void defragment();
+
+    Geometry_Stats stats() const;
+    void           print_stats() const;
+
+    no_copy_and_assign(Geometry_Arena);
+    no_move_and_assign(Geometry_Arena);
+
+private:
+    struct Pool {
+        uint               VAO           = 0;
+        uint               VBO           = 0;
+        uint               attribute_VBO = 0; // split layout only
+        uint               EBO           = 0;
+        Offset_Allocator   vertices      = {}; // in vertices
+        Offset_Allocator   indices       = {}; // in bytes, aligned to the index size of the mesh
+        std::vector<Mesh*> meshes        = {};
+    };
+
+    void create(Pool& pool, Mesh::Layout layout);
+    void grow(Pool& pool, Mesh::Layout layout, u64 vertex_capacity, u64 index_capacity);
+
+    u64 initial_vertex_capacity = 0;
+    u64 initial_index_capacity  = 0;
+
+    std::array<Pool, 3> pools = {}; // by Mesh::Layout
+};
+
+}
@@ -1,14 +1,19 @@
 #include "Graphics.h"
 #include "File.h"
+#include "GL_Extensions.h"
 #include "Profiling.h"
+#include "Program_Cache.h"
+#include "Uniform_Buffers.h"
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
 #include <iostream>
-#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glfw/glfw3.h>
-#include <stb/stb_image.h>
 
 
 // ---------------------------------------------
@@ -18,6 +23,9 @@ void Report_Error(uint id, std::string const& text);
 uint Compile_Shader(const char* raw_code, GLenum type);
 Shader_ID Link_Shader(uint vertex_shader, uint fragment_shader);
 
+// every state change of the render functions since the last reset
+GL::State_Changes State_Counters{};
+
 
 // ---------------------------------------------
 // basic functions
@@ -27,6 +35,14 @@ Shader_ID GL::Create_Shader_Program(const char* vertex_path, const char* fragmen
     measure_time();
 
     auto[vertex_code, fragment_code] = File::ReadFull(vertex_path, fragment_path);
+
+    // the binary of the last launch (or reload) with the same sources & driver
+    u64 const cache_key = Program_Cache::Make_Key(vertex_code.value(), fragment_code.value());
+    if (Shader_ID const cached = Program_Cache::Load(cache_key); cached != Bad_Shader) {
+        return cached;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
     uint vertex_shader = Compile_Shader(vertex_code.value().c_str(), GL_VERTEX_SHADER);
     uint fragment_shader = Compile_Shader(fragment_code.value().c_str(), GL_FRAGMENT_SHADER);
     Shader_ID program_id = Link_Shader(vertex_shader, fragment_shader);
@@ -34,6 +50,10 @@ Shader_ID GL::Create_Shader_Program(const char* vertex_path, const char* fragmen
     glDeleteShader(vertex_shader);
     glDeleteShader(fragment_shader);
 
+    // the driver may compile lazily, asking for the link status waits for it
+    double const compile_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    Program_Cache::Store(cache_key, program_id, compile_ms);
+
     return program_id;
 }
 
@@ -42,10 +62,10 @@ Uniform_Map GL::Map_Uniform_Locations(Shader_ID shader_id, std::initializer_list
     measure_time();
 
     Uniform_Map mapped_Data;
-    for (auto name : uniform_names) {
+    for (auto const& name : uniform_names) {
         auto location = glGetUniformLocation(shader_id, name.c_str());
         assert(location != -1);
-        mapped_Data[name] = location;
+        mapped_Data.insert(Uniform{ Fnv1a(name.data(), name.size()) }, location);
     }
 
     return mapped_Data;
@@ -86,6 +106,7 @@ Window* GL::Global_Init()
         assert(false);
         return nullptr;
     }
+    Load_Extensions((GLADloadproc)glfwGetProcAddress); // everything newer than 4.0
 
     // tell GL to only draw onto a pixel if the shape is closer to the viewer
     glEnable(GL_DEPTH_TEST); // enable depth-testing
@@ -124,6 +145,30 @@ void GL::Clear_Screen()
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+GL::State_Changes& GL::Get_State_Changes()
+{
+    return State_Counters;
+}
+
+void GL::Print_State_Changes()
+{
+    std::cout << "state changes: " << State_Counters.programs << " programs, " << State_Counters.vertex_arrays << " vertex arrays, "
+              << State_Counters.textures << " textures, " << State_Counters.draws << " draws\n";
+}
+
+bool GL::Has_Extension(const char* name)
+{
+    int count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (int n = 0; n < count; ++n) {
+        auto extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, n));
+        if (extension && std::strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
 Texture GL::Allocate_Texture(std::string const& file_path)
 {
     // try loading the texture first, no point in allocating any buffer on the gpu otherwise!
@@ -150,6 +195,60 @@ Texture GL::Allocate_Texture(std::string const& file_path)
     return t;
 }
 
+// normal, tex coord, tangent & bitangent (locations 1-4) from the bound GL_ARRAY_BUFFER,
+// Vertex for the interleaved layout and Vertex_Attributes for the split one
+template <typename Layout>
+void Set_Attribute_Pointers()
+{
+    // vertex normals
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Layout), (void*)offsetof(Layout, normal));
+    // vertex texture coords
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Layout), (void*)offsetof(Layout, tex_coord));
+    // vertex tangent
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Layout), (void*)offsetof(Layout, tangent));
+    // vertex bitangent
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Layout), (void*)offsetof(Layout, bitangent));
+}
+
+void GL::Set_Vertex_Format(Mesh::Layout layout, uint VBO, uint attribute_VBO)
+{
+    glBindBuffer(GL_ARRAY_BUFFER, VBO);
+
+    if (layout == Mesh::split) {
+        // vertex pos, alone in the first buffer
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(float3), (void*)0);
+
+        // everything else in the second one
+        glBindBuffer(GL_ARRAY_BUFFER, attribute_VBO);
+        Set_Attribute_Pointers<Vertex_Attributes>();
+    }
+    else if (layout == Mesh::packed) {
+        // vertex pos, unorm16 inside the mesh bounds
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(Packed_Vertex), (void*)offsetof(Packed_Vertex, position));
+        // vertex normals, octahedral
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(Packed_Vertex), (void*)offsetof(Packed_Vertex, normal));
+        // vertex texture coords, half floats
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(Packed_Vertex), (void*)offsetof(Packed_Vertex, tex_coord));
+        // vertex tangent, octahedral + bitangent sign in w. the bitangent (4) is rebuilt in the shader
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(Packed_Vertex), (void*)offsetof(Packed_Vertex, tangent));
+    }
+    else {
+        // vertex pos
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        Set_Attribute_Pointers<Vertex>();
+    }
+}
+
 void GL::Allocate_Mesh(Mesh& mesh)
 {
     glGenVertexArrays(1, &mesh.VAO);
@@ -157,83 +256,142 @@ void GL::Allocate_Mesh(Mesh& mesh)
     glGenBuffers(1, &mesh.EBO);
 
     glBindVertexArray(mesh.VAO);
-    glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
-    glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex), &mesh.vertices[0], GL_STATIC_DRAW);
 
+    // 16 bit indices whenever they can address every vertex
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint), &mesh.indices[0], GL_STATIC_DRAW);
+    if (mesh.vertex_count() <= Max_16_Bit_Vertices) {
+        std::vector<u16> const indices(mesh.indices.begin(), mesh.indices.end());
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(u16), indices.data(), GL_STATIC_DRAW);
+        mesh.index_size = sizeof(u16);
+    }
+    else {
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indices.size() * sizeof(uint), mesh.indices.data(), GL_STATIC_DRAW);
+        mesh.index_size = sizeof(uint);
+    }
 
-    // vertex pos
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    // vertex normals
-    glEnableVertexAttribArray(1);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, normal));
-    // vertex texture coords
-    glEnableVertexAttribArray(2);
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tex_coord));
-    // vertex tangent
-    glEnableVertexAttribArray(3);
-    glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, tangent));
-    // vertex bitangent
-    glEnableVertexAttribArray(4);
-    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, bitangent));
+    if (mesh.layout == Mesh::split) {
+        Vertex_Streams const& streams = mesh.streams;
+        assert(streams.positions.size() == streams.attributes.size());
 
+        // vertex pos alone in the first buffer, everything else in the second one
+        glGenBuffers(1, &mesh.attribute_VBO);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        glBufferData(GL_ARRAY_BUFFER, streams.positions.size() * sizeof(float3), streams.positions.data(), GL_STATIC_DRAW);
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.attribute_VBO);
+        glBufferData(GL_ARRAY_BUFFER, streams.attributes.size() * sizeof(Vertex_Attributes), streams.attributes.data(), GL_STATIC_DRAW);
+    }
+    else if (mesh.layout == Mesh::packed) {
+        std::vector<Packed_Vertex> const& vertices = mesh.packed_vertices.vertices;
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Packed_Vertex), vertices.data(), GL_STATIC_DRAW);
+    }
+    else {
+        glBindBuffer(GL_ARRAY_BUFFER, mesh.VBO);
+        glBufferData(GL_ARRAY_BUFFER, mesh.vertices.size() * sizeof(Vertex), mesh.vertices.data(), GL_STATIC_DRAW);
+    }
+    Set_Vertex_Format(mesh.layout, mesh.VBO, mesh.attribute_VBO);
 
     glBindVertexArray(0);
 }
 
-void Render_Mesh_internal(Mesh const& mesh, GL::Shader const& shader)
+void GL::Free_Mesh(Mesh& mesh)
 {
-    uint diffuse_count = 1;
-    uint specular_count = 1;
+    assert(!mesh.in_arena && "arena meshes are freed by their Geometry_Arena");
+    if (mesh.in_arena) {
+        return;
+    }
+
+    glDeleteVertexArrays(1, &mesh.VAO);
+    glDeleteBuffers(1, &mesh.VBO);
+    glDeleteBuffers(1, &mesh.EBO);
+    glDeleteBuffers(1, &mesh.attribute_VBO);
+    mesh.VAO = mesh.VBO = mesh.EBO = mesh.attribute_VBO = 0;
+}
+
+void GL::Bind_Textures(Mesh const& mesh, Shader const& shader)
+{
+    std::array<uint, Texture_Type_Count> counts = {};
 
     for (uint i = 0; i < mesh.textures.size(); i++) {
 
         // activate proper texture unit before binding
         glActiveTexture(GL_TEXTURE0 + i);
 
-        // read the texture number
-        std::string number{};
+        // the n-th texture of a type goes to <type>n
         Texture::Type type = mesh.textures[i].type;
-        if (type == Texture::diffuse) {
-            number = std::to_string(diffuse_count);
-            diffuse_count++;
-        }
-        else if (type == Texture::specular) {
-            number = std::to_string(specular_count);
-            specular_count++;
-        }
+        uint const number = ++counts[type];
 
         // send information to the shader
-        const std::string tex_name = "material." + std::to_string(type) + number;
-        shader.send_value(tex_name.c_str(), (float)i);
+        shader.material.set_unit(type, number, int(i));
 
         // bind the texture
         glBindTexture(GL_TEXTURE_2D, mesh.textures[i].id);
+        State_Counters.textures++;
     }
 
-    // draw mesh
-    glBindVertexArray(mesh.VAO);
-    glDrawElements(GL_TRIANGLES, mesh.indices.size(), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
-
     // set everything back to defaults
     glActiveTexture(GL_TEXTURE0);
 }
 
+void GL::Draw_Mesh(Mesh const& mesh, Shader const& shader, std::size_t level)
+{
+    // packed positions are relative to the mesh bounds
+    if (mesh.layout == Mesh::packed) {
+        glUniform3fv(shader.position_offset_location, 1, mesh.packed_vertices.position_offset.data);
+        glUniform3fv(shader.position_scale_location, 1, mesh.packed_vertices.position_scale.data);
+    }
+
+    Mesh_Lod const lod = mesh.lod(level);
+    GLenum const index_type = mesh.index_size == sizeof(u16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+    void* const  first      = (void*)(mesh.index_offset + std::size_t(lod.first_index) * mesh.index_size);
+    glDrawElementsBaseVertex(GL_TRIANGLES, lod.index_count, index_type, first, GLint(mesh.base_vertex));
+    State_Counters.draws++;
+}
+
+void Render_Mesh_internal(Mesh const& mesh, GL::Shader const& shader, std::size_t level = 0)
+{
+    // the caller binds the VAO (arena meshes share one)
+    GL::Bind_Textures(mesh, shader);
+    GL::Draw_Mesh(mesh, shader, level);
+}
+
 void GL::Render_Mesh(Mesh const& mesh, Shader const& shader)
 {
     shader.apply(); // activate!
+    glBindVertexArray(mesh.VAO);
+    State_Counters.vertex_arrays++;
     Render_Mesh_internal(mesh, shader);
+    glBindVertexArray(0);
 }
 
 void GL::Render_Meshes(Meshes const& meshes, Shader const& shader)
 {
     shader.apply(); // activate only once!
+    uint bound_VAO = 0; // meshes of the same arena share one, only switch when it changes
     for_size(n, meshes) {
+        if (meshes[n].VAO != bound_VAO) {
+            bound_VAO = meshes[n].VAO;
+            glBindVertexArray(bound_VAO);
+            State_Counters.vertex_arrays++;
+        }
         Render_Mesh_internal(meshes[n], shader);
     }
+    glBindVertexArray(0);
+}
+
+void GL::Render_Meshes(Meshes const& meshes, Shader const& shader, Lod_View const& view)
+{
+    shader.apply(); // activate only once!
+    uint bound_VAO = 0;
+    for_size(n, meshes) {
+        if (meshes[n].VAO != bound_VAO) {
+            bound_VAO = meshes[n].VAO;
+            glBindVertexArray(bound_VAO);
+            State_Counters.vertex_arrays++;
+        }
+        Render_Mesh_internal(meshes[n], shader, Select_Lod(meshes[n], view));
+    }
+    glBindVertexArray(0);
 }
 
 
@@ -242,43 +400,86 @@ void GL::Render_Meshes(Meshes const& meshes, Shader const& shader)
 // shader code
 // ---------------------------------------------
 #pragma region "Shader"
+GL::Material_Bindings::Material_Bindings(Shader_ID program_id)
+{
+    measure_time();
+
+    for (auto& type_locations : locations) {
+        type_locations.fill(-1);
+    }
+
+    // plain uniforms named after the type & number, like shader/model_loading.fragment declares them
+    for (std::size_t type = 0; type < Texture_Type_Count; ++type) {
+        std::string const name = std::to_string(Texture::Type(type));
+        for (uint number = 1; number <= Max_Numbered; ++number) {
+            locations[type][number - 1] = glGetUniformLocation(program_id, (name + std::to_string(number)).c_str());
+        }
+    }
+}
+
+void GL::Material_Bindings::set_unit(Texture::Type type, uint number, int unit) const
+{
+    uint const slot = number - 1;
+    if (number == 0 || slot >= Max_Numbered || locations[type][slot] == -1 || units[type][slot] == unit) {
+        return;
+    }
+    // the sampler is program state, the program has to be current (it is while its meshes are drawn)
+    glUniform1i(locations[type][slot], unit);
+    units[type][slot] = unit;
+}
+
 GL::Shader::Shader(const char* vertex_path, const char* fragment_path, Uniform_List uniform_names) : vertex_path { vertex_path }, fragment_path { fragment_path }
 {
     program_id = GL::Create_Shader_Program(vertex_path, fragment_path);
     uniforms = GL::Map_Uniform_Locations(program_id, uniform_names);
+    material = Material_Bindings{ program_id };
+    model_location = glGetUniformLocation(program_id, "model");
+    position_offset_location = glGetUniformLocation(program_id, "position_offset");
+    position_scale_location = glGetUniformLocation(program_id, "position_scale");
+
+    GLuint const frame_block = glGetUniformBlockIndex(program_id, "Frame");
+    if (frame_block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program_id, frame_block, Frame_Binding);
+    }
 }
 
 void GL::Shader::apply() const
 {
     glUseProgram(program_id);
+    State_Counters.programs++;
 }
 
-void GL::Shader::send_value(const char* name, bool value) const
+void GL::Shader::send_value(Uniform uniform, bool value) const
 {
-    int location = uniforms.at(name);
+    int location = uniforms.at(uniform);
     glUniform1i(location, (int)value);
 }
 
-void GL::Shader::send_value(const char* name, int value) const
+void GL::Shader::send_value(Uniform uniform, int value) const
 {
-    int location = uniforms.at(name);
+    int location = uniforms.at(uniform);
     glUniform1i(location, value);
 }
 
-void GL::Shader::send_value(const char* name, float value) const
+void GL::Shader::send_value(Uniform uniform, float value) const
 {
-    //int location = uniforms.at(name);
-    //glUniform1f(location, value);
-    auto loc = glGetUniformLocation(program_id, name);
-    glUniform1f(loc, value);
+    int location = uniforms.at(uniform);
+    glUniform1f(location, value);
 }
 
-void GL::Shader::send_value(const char* name, float3 value) const
+void GL::Shader::send_value(Uniform uniform, float3 value) const
 {
-    int location = uniforms.at(name);
+    int location = uniforms.at(uniform);
     glUniform3fv(location, 1, value.data);
 }
 
+void GL::Shader::send_value(Uniform uniform, float44 const& value) const
+{
+    // stored row by row, glsl wants the columns first
+    int location = uniforms.at(uniform);
+    glUniformMatrix4fv(location, 1, GL_TRUE, &value.data[0][0]);
+}
+
 #pragma endregion
 
 // ---------------------------------------------
@@ -287,28 +488,19 @@ void GL::Shader::send_value(const char* name, float3 value) const
 #pragma region "Image"
 GL::Image::Image(const char* file_name)
 {
-    // check image cache first
-    static std::unordered_map<const char*, uchar*> image_cache {};
-    if (image_cache.count(file_name) > 0) {
-        data = image_cache.at(file_name);
+    decoded = Image_Cache::Load(file_name);
+    if (decoded != nullptr) {
+        data     = decoded->pixels;
+        x        = decoded->x;
+        y        = decoded->y;
+        channels = decoded->channels;
         return;
     }
 
-    // first time this image is loaded
-    data = stbi_load(file_name, &x, &y, &channels, 0);
-    if (data != nullptr) { return; }
-
     // something went wrong - file name changed perhaps?
     std::cerr << "Failed to load image " << file_name << '\n';
     assert(false);
 }
-
-GL::Image::~Image()
-{
-    if (data) {
-        stbi_image_free(data);
-    }
-}
 #pragma endregion
 
 // ---------------------------------------------
@@ -418,7 +610,7 @@ void GL::Create_Cube_Buffer(uint& VBO, uint& VAO)
 
 void GL::Render_Test(Shader& shader, uint VAO, uint size, float3 pos)
 {
-    shader.send_value("offset", pos);
+    shader.send_value("offset"_uniform, pos);
     shader.apply();
     glBindVertexArray(VAO);
     // draw points 0-3 from the currently bound VAO with current in-use shader
@@ -459,6 +651,9 @@ Shader_ID Link_Shader(uint vertex_shader, uint fragment_shader)
     Shader_ID program_id = glCreateProgram();
     glAttachShader(program_id, vertex_shader);
     glAttachShader(program_id, fragment_shader);
+    if (GL::Get_Extensions().program_binary) {
+        glProgramParameteri(program_id, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE); // for the Program_Cache
+    }
     glLinkProgram(program_id);
 
     int success;
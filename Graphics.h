@@ -2,11 +2,15 @@
 
 #include "Common.h"
 #include "Vector.h"
+#include "Matrix.h"
 #include "Vertex.h"
 #include "Texture.h"
 #include "Mesh.h"
+#include "Image_Cache.h"
+#include "Lod_View.h"
+#include "Uniform_Map.h"
 
-#include <map>
+#include <array>
 #include <string>
 #include <vector>
 #include <optional>
@@ -17,7 +21,6 @@ using Window = GLFWwindow;
 using Shader_ID = int;
 const Shader_ID Bad_Shader = 0;
 
-using Uniform_Map = std::map<std::string, int>;
 using Uniform_List = std::initializer_list<std::string>;
 
 namespace GL {
@@ -31,24 +34,42 @@ bool    Is_Open(Window* window);
 void    Poll_And_Swap(Window* window); // poll for new events and swap the drawing buffer
 void    Close_On_Escape(Window* window);
 void    Clear_Screen();
+bool    Has_Extension(const char* name); // needs an initialized context
+
+// how often the render functions changed gl state, to see what the draw order saves
+struct State_Changes {
+    u64 programs      = 0;
+    u64 vertex_arrays = 0;
+    u64 textures      = 0;
+    u64 draws         = 0; // draw calls, a multi draw is one
+};
+State_Changes& Get_State_Changes(); // the render code counts into it, assign {} to reset
+void           Print_State_Changes();
 
 // texture specific functions
 Texture Allocate_Texture(std::string const& file_path);
 
+// decoded through the image cache, loading the same file again skips the decoding
 struct Image {
 
     Image(const char* file_path);
-    ~Image();
 
-    uchar* data = nullptr;
+    Shared_Image decoded = nullptr; // keeps the pixels alive
+
+    const uchar* data = nullptr;
     int x = 0;
     int y = 0;
     int channels = 0;
-};;
+};
 
 void Allocate_Mesh(Mesh& m);
+void Free_Mesh(Mesh& m); // not for meshes of a Geometry_Arena
+void Set_Vertex_Format(Mesh::Layout layout, uint VBO, uint attribute_VBO = 0); // attribute pointers of the bound VAO
+void Bind_Textures(Mesh const& m, Shader const& s); // texture units 0..n, the samplers through s.material
+void Draw_Mesh(Mesh const& m, Shader const& s, std::size_t level = 0); // only the draw, the caller binds VAO & textures
 void Render_Mesh(Mesh const& m, Shader const& s);
-void Render_Meshes(Meshes const& m, Shader const& s);
+void Render_Meshes(Meshes const& m, Shader const& s); // full detail
+void Render_Meshes(Meshes const& m, Shader const& s, Lod_View const& view); // coarsest level that looks the same (see Lod_View.h)
 
 // shader specific
 Shader_ID   Create_Shader_Program(const char* vertex_path, const char* fragment_path);
@@ -59,20 +80,43 @@ void Create_Test_Buffer(uint& VBO, uint& VAO);
 void Create_Cube_Buffer(uint& VBO, uint& VAO);
 void Render_Test(Shader& shader, uint VAO, uint size, float3 pos);
 
+// where the textures of a mesh go in one program: the location of every
+// material sampler the shaders declare (texture_diffuse1, texture_normal1, ...),
+// looked up once when the program is linked (a reload creates a new Shader),
+// and the unit each sampler was last set to. binding needs no names & no
+// glGetUniformLocation and only sends the samplers that change
+struct Material_Bindings {
+    static constexpr uint Max_Numbered = 8; // texture_diffuse1..8, texture_specular1..8, ...
+
+    Material_Bindings() = default;
+    Material_Bindings(Shader_ID program_id);
+
+    void set_unit(Texture::Type type, uint number, int unit) const; // number counts from 1 per type
+
+    std::array<std::array<int, Max_Numbered>, Texture_Type_Count> locations = {}; // -1: the program doesn't use it
+    mutable std::array<std::array<int, Max_Numbered>, Texture_Type_Count> units = {}; // gl starts every sampler at 0
+};
+
 struct Shader {
 
-    // create from files
+    // create from files, a Frame block (view, projection & time) is bound to Frame_Binding
     Shader(const char* vertex_path, const char* fragment_path, Uniform_List uniform_names);
 
     void apply() const;
 
-    void send_value(const char* name, bool   value) const;
-    void send_value(const char* name, int    value) const;
-    void send_value(const char* name, float  value) const;
-    void send_value(const char* name, float3 value) const;
-
-    Shader_ID   program_id;
-    Uniform_Map uniforms;
+    // the uniform has to be in the list the shader was created with
+    void send_value(Uniform uniform, bool   value) const;
+    void send_value(Uniform uniform, int    value) const;
+    void send_value(Uniform uniform, float  value) const;
+    void send_value(Uniform uniform, float3 value) const;
+    void send_value(Uniform uniform, float44 const& value) const;
+
+    Shader_ID         program_id;
+    Uniform_Map       uniforms;
+    Material_Bindings material;
+    int               model_location           = -1; // -1 for the indirect shaders, they read it per draw
+    int               position_offset_location = -1; // of the packed vertex shaders, -1 for the others
+    int               position_scale_location  = -1;
 
     std::string vertex_path;
     std::string fragment_path;
@@ -0,0 +1,63 @@
+#pragma once
+
+// --------------------------------------------------
+// non-cryptographic hashing
+// --------------------------------------------------
+
+#include "Common.h"
+
+#include <cstring>
+
+inline u64 Rotate_Left(u64 value, int bits)
+{
+    return (value << bits) | (value >> (64 - bits));
+}
+
+// 64 bit fnv-1a, constexpr so names can be hashed at compile time (see Uniform in Uniform_Map.h)
+constexpr u64 Fnv1a(const char* text, std::size_t size)
+{
+    u64 h = 0xcbf29ce484222325ull;
+    for (std::size_t n = 0; n < size; ++n) {
+        h = (h ^ u8(text[n])) * 0x100000001b3ull;
+    }
+    return h;
+}
+
+// murmur3 finalizer, spreads every input bit over the whole result
+inline u64 Mix_Bits(u64 h)
+{
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// 64 bit hash of a byte range, consumes 8 bytes per step (fast enough for whole files)
+inline u64 Hash_Bytes(const void* data, std::size_t size, u64 seed = 0)
+{
+    constexpr u64 k1 = 0x87c37b91114253d5ull;
+    constexpr u64 k2 = 0x4cf5ad432745937full;
+
+    const Byte* bytes = static_cast<const Byte*>(data);
+    u64 h = seed ^ (u64(size) * 0x9E3779B97F4A7C15ull);
+
+    auto add = [&h](u64 word) {
+        word *= k1; word = Rotate_Left(word, 31); word *= k2;
+        h ^= word;
+        h = Rotate_Left(h, 27) * 5 + 0x52dce729;
+    };
+
+    std::size_t n = 0;
+    for (/**/; n + 8 <= size; n += 8) {
+        u64 word;
+        std::memcpy(&word, bytes + n, 8);
+        add(word);
+    }
+    if (n < size) {
+        u64 word = 0;
+        std::memcpy(&word, bytes + n, size - n);
+        add(word);
+    }
+
+    return Mix_Bits(h);
+}
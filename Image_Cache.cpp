@@ -0,0 +1,156 @@
+#include "Image_Cache.h"
+#include "File.h"
+#include "Hash.h"
+
+#include <filesystem>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#include <stb/stb_image.h>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+// what the file looked like when its content was hashed, saves reading it again on every hit
+struct File_State {
+    u64 size         = 0;
+    i64 time         = 0;
+    u64 content_hash = 0;
+};
+
+struct Cached_Image {
+    Shared_Image              image         = {};
+    std::list<u64>::iterator  lru_position  = {};
+};
+
+struct Image_Cache_State {
+    std::mutex mutex;
+
+    std::unordered_map<std::string, File_State> files  = {}; // normalized path -> content
+    std::unordered_map<u64, Cached_Image>       images = {}; // content hash -> pixels
+    std::list<u64>                              lru    = {}; // content hashes, most recent at the back
+
+    std::size_t       budget = std::size_t(256) << 20;
+    Image_Cache::Stats stats = {};
+};
+
+Image_Cache_State& Cache_State()
+{
+    static Image_Cache_State state {};
+    return state;
+}
+
+// caller holds the lock
+void Evict_Images(Image_Cache_State& state)
+{
+    while (state.stats.bytes_cached > state.budget && !state.lru.empty()) {
+        auto found = state.images.find(state.lru.front());
+        state.stats.bytes_cached -= found->second.image->size();
+        state.stats.evictions++;
+        state.images.erase(found);
+        state.lru.pop_front();
+    }
+}
+
+// caller holds the lock
+Shared_Image Find_Image(Image_Cache_State& state, u64 content_hash)
+{
+    auto found = state.images.find(content_hash);
+    if (found == state.images.end()) { return nullptr; }
+
+    // move to the most recent end
+    state.lru.splice(state.lru.end(), state.lru, found->second.lru_position);
+    return found->second.image;
+}
+
+#pragma endregion
+
+Decoded_Image::~Decoded_Image()
+{
+    if (pixels) {
+        stbi_image_free(pixels);
+    }
+}
+
+Shared_Image Image_Cache::Load(std::string const& file_path)
+{
+    Image_Cache_State& state = Cache_State();
+
+    std::string const path = std::filesystem::path(file_path).lexically_normal().generic_string();
+
+    std::error_code size_error{}, time_error{};
+    u64 const size = std::filesystem::file_size(path, size_error);
+    i64 const time = std::filesystem::last_write_time(path, time_error).time_since_epoch().count();
+    if (size_error || time_error) {
+        return nullptr;
+    }
+
+    // hit path: the file is unchanged since it was hashed, no need to touch its content
+    {
+        std::lock_guard<std::mutex> lock{ state.mutex };
+        auto known = state.files.find(path);
+        if (known != state.files.end() && known->second.size == size && known->second.time == time) {
+            if (Shared_Image image = Find_Image(state, known->second.content_hash)) {
+                state.stats.hits++;
+                return image;
+            }
+        }
+    }
+
+    // new or changed file: hash the content, a copy of an already decoded file is still a hit
+    File::Mapped const file{ path.c_str() };
+    if (!file.is_open()) {
+        return nullptr;
+    }
+    u64 const content_hash = Hash_Bytes(file.data, file.size);
+
+    {
+        std::lock_guard<std::mutex> lock{ state.mutex };
+        state.files[path] = { size, time, content_hash };
+        if (Shared_Image image = Find_Image(state, content_hash)) {
+            state.stats.hits++;
+            return image;
+        }
+        state.stats.misses++;
+    }
+
+    // decode without holding the lock, other threads can keep using the cache meanwhile
+    auto image = std::make_shared<Decoded_Image>();
+    image->pixels = stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(file.data), int(file.size), &image->x, &image->y, &image->channels, 0);
+    if (image->pixels == nullptr) {
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock{ state.mutex };
+
+    // somebody else might have been faster
+    if (Shared_Image existing = Find_Image(state, content_hash)) {
+        return existing;
+    }
+
+    Cached_Image& cached = state.images[content_hash];
+    cached.image        = image;
+    cached.lru_position = state.lru.insert(state.lru.end(), content_hash);
+    state.stats.bytes_cached += image->size();
+
+    Evict_Images(state);
+    return image;
+}
+
+void Image_Cache::Set_Budget(std::size_t bytes)
+{
+    Image_Cache_State& state = Cache_State();
+    std::lock_guard<std::mutex> lock{ state.mutex };
+    state.budget = bytes;
+    Evict_Images(state);
+}
+
+Image_Cache::Stats Image_Cache::Get_Stats()
+{
+    Image_Cache_State& state = Cache_State();
+    std::lock_guard<std::mutex> lock{ state.mutex };
+    return state.stats;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "Common.h"
+
+#include <memory>
+#include <string>
+
+// decoded pixels of an image file, rows top to bottom, channels interleaved
+struct Decoded_Image {
+
+    Decoded_Image() = default;
+    ~Decoded_Image();
+
+    uchar* pixels   = nullptr; // from stb_image
+    int    x        = 0;
+    int    y        = 0;
+    int    channels = 0;
+
+    std::size_t size() const { return std::size_t(x) * y * channels; }
+
+    no_copy_and_assign(Decoded_Image);
+    no_move_and_assign(Decoded_Image);
+};
+using Shared_Image = std::shared_ptr<const Decoded_Image>;
+
+// --------------------------------------------------
+// decoded image cache: files are identified by their normalized path and
+// the hash of their content, so the same file (or a copy of it under a
+// different name) is only decoded once. the cache keeps the most recently
+// used images up to its byte budget, everybody holding a Shared_Image
+// keeps the pixels alive regardless of that. thread safe.
+// --------------------------------------------------
+namespace Image_Cache {
+
+struct Stats {
+    u64         hits         = 0;
+    u64         misses       = 0;
+    u64         evictions    = 0;
+    std::size_t bytes_cached = 0;
+};
+
+// nullptr if the file can't be read or decoded
+Shared_Image Load(std::string const& file_path);
+
+void  Set_Budget(std::size_t bytes);
+Stats Get_Stats();
+
+}
@@ -0,0 +1,37 @@
+#include "Indirect_Commands.h"
+
+void Indirect_Commands::build(Meshes const& meshes, float44 const& model, Lod_View const* view, std::size_t draw_alignment)
+{
+    commands.clear();
+    draws.clear();
+    runs.clear();
+
+    for (Mesh const& mesh : meshes) {
+        Mesh_Lod const lod = mesh.lod(view ? Select_Lod(mesh, *view) : 0);
+        if (lod.index_count == 0) {
+            continue;
+        }
+
+        Run const* run = runs.empty() ? nullptr : &runs.back();
+        if (!run || run->first_mesh->VAO != mesh.VAO || run->index_size != mesh.index_size || !Same_Textures(run->first_mesh->textures, mesh.textures)) {
+            // gl_DrawIDARB starts at 0 for every multi draw, so every run gets its own buffer range
+            draws.resize((draws.size() + draw_alignment - 1) / draw_alignment * draw_alignment);
+            runs.push_back({ &mesh, u32(mesh.index_size), commands.size(), 0, draws.size() });
+        }
+
+        // the arena aligns index_offset to the index size
+        Command command{};
+        command.count       = lod.index_count;
+        command.first_index = u32(mesh.index_offset / mesh.index_size) + lod.first_index;
+        command.base_vertex = mesh.base_vertex;
+        commands.push_back(command);
+
+        Draw_Data draw{};
+        draw.model           = model;
+        draw.position_offset = mesh.layout == Mesh::packed ? mesh.packed_vertices.position_offset : float3{ 0.0f, 0.0f, 0.0f };
+        draw.position_scale  = mesh.layout == Mesh::packed ? mesh.packed_vertices.position_scale : float3{ 1.0f, 1.0f, 1.0f };
+        draws.push_back(draw);
+
+        runs.back().command_count++;
+    }
+}
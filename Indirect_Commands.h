@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Common.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+#include "Lod_View.h"
+
+#include <vector>
+
+// what the indirect shaders read at gl_DrawIDARB from the storage buffer at Draw_Binding (std430, row_major):
+// the model transform and the position decode of the packed layout, offset 0 & scale 1 for the other layouts
+struct Draw_Data {
+    float44 model           = identity44();
+    float3  position_offset = {};
+    float   padding0        = 0.0f;
+    float3  position_scale  = {};
+    float   padding1        = 0.0f;
+};
+static_assert(sizeof(Draw_Data) == 96, "std430 layout of the shader struct");
+
+// --------------------------------------------------
+// the cpu half of GL::Indirect_Renderer, without gl: one indirect
+// command & Draw_Data per visible mesh, grouped into runs of meshes
+// that share the VAO, the index size and the textures (one multi draw
+// each). rebuilt every call, the capacity stays
+// --------------------------------------------------
+struct Indirect_Commands {
+
+    // DrawElementsIndirectCommand
+    struct Command {
+        u32 count          = 0;
+        u32 instance_count = 1;
+        u32 first_index    = 0;
+        u32 base_vertex    = 0;
+        u32 base_instance  = 0;
+    };
+
+    // meshes that go into one multi draw
+    struct Run {
+        Mesh const* first_mesh    = nullptr; // VAO & textures of the whole run
+        u32         index_size    = 0;       // in bytes
+        std::size_t first_command = 0;
+        std::size_t command_count = 0;
+        std::size_t first_draw    = 0; // in draws, a multiple of draw_alignment for glBindBufferRange
+    };
+
+    // view: nullptr for full detail. draw_alignment: in Draw_Data, of storage buffer ranges
+    void build(Meshes const& meshes, float44 const& model, Lod_View const* view, std::size_t draw_alignment);
+
+    std::vector<Command>   commands = {};
+    std::vector<Draw_Data> draws    = {};
+    std::vector<Run>       runs     = {};
+};
@@ -0,0 +1,118 @@
+#include "Indirect_Renderer.h"
+#include "GL_Extensions.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include <glad/glad.h>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+// a new store every frame, the driver doesn't have to wait for the last frame still reading the old one
+template <typename T>
+void Upload(GLenum target, uint buffer, std::vector<T> const& data)
+{
+    glBindBuffer(target, buffer);
+    glBufferData(target, GLsizeiptr(data.size() * sizeof(T)), data.data(), GL_STREAM_DRAW);
+}
+
+#pragma endregion
+
+GL::Indirect_Renderer::Indirect_Renderer()
+{
+    Extensions const& extensions = Get_Extensions();
+    enabled = extensions.multi_draw_indirect && extensions.shader_storage_buffer && extensions.shader_draw_parameters;
+    if (!enabled) {
+        return;
+    }
+
+    glGenBuffers(1, &command_buffer);
+
+    GLint alignment = 0;
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    offset_alignment = std::max<std::size_t>(1, std::size_t(alignment));
+    draw_alignment   = offset_alignment / std::gcd(offset_alignment, sizeof(Draw_Data)); // the smallest run of them that is aligned
+    assert(draw_alignment * sizeof(Draw_Data) % offset_alignment == 0);
+}
+
+GL::Indirect_Renderer::~Indirect_Renderer()
+{
+    glDeleteBuffers(1, &command_buffer);
+}
+
+void GL::Indirect_Renderer::render(Meshes const& meshes, Shader const& shader, float44 const& model)
+{
+    if (!enabled) {
+        render_fallback(meshes, shader, model, nullptr);
+        return;
+    }
+    batch.build(meshes, model, nullptr, draw_alignment);
+    submit(shader);
+}
+
+void GL::Indirect_Renderer::render(Meshes const& meshes, Shader const& shader, Lod_View const& view)
+{
+    if (!enabled) {
+        render_fallback(meshes, shader, view.model, &view);
+        return;
+    }
+    batch.build(meshes, view.model, &view, draw_alignment);
+    submit(shader);
+}
+
+void GL::Indirect_Renderer::next_frame()
+{
+    draw_stream.next_frame();
+}
+
+void GL::Indirect_Renderer::render_fallback(Meshes const& meshes, Shader const& shader, float44 const& model, Lod_View const* view)
+{
+    // one model for the whole call, the plain shaders have it as a uniform. the queue binds the
+    // program, so it uploads the model after that
+    fallback.clear();
+    for (Mesh const& mesh : meshes) {
+        if (view) {
+            float const depth = length(transform_point(model, mesh.bounding_center) - view->camera_position);
+            fallback.add(mesh, shader, Select_Lod(mesh, *view), depth, Render_Queue::opaque, &model);
+        }
+        else {
+            fallback.add(mesh, shader, 0, 0.0f, Render_Queue::opaque, &model);
+        }
+    }
+    fallback.sort();
+    fallback.submit();
+}
+
+void GL::Indirect_Renderer::submit(Shader const& shader)
+{
+    if (batch.commands.empty()) {
+        return;
+    }
+
+    Upload(GL_DRAW_INDIRECT_BUFFER, command_buffer, batch.commands);
+    std::size_t const draws_offset = draw_stream.write(batch.draws.data(), batch.draws.size() * sizeof(Draw_Data), offset_alignment);
+
+    shader.apply();
+    Indirect_Commands::Run const* previous = nullptr;
+    for (Indirect_Commands::Run const& run : batch.runs) {
+        Mesh const& mesh = *run.first_mesh;
+        if (!previous || previous->first_mesh->VAO != mesh.VAO) {
+            glBindVertexArray(mesh.VAO);
+            Get_State_Changes().vertex_arrays++;
+        }
+        if (!previous || !Same_Textures(previous->first_mesh->textures, mesh.textures)) {
+            Bind_Textures(mesh, shader);
+        }
+
+        GLintptr const first_draw = GLintptr(draws_offset + run.first_draw * sizeof(Draw_Data));
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, Draw_Binding, draw_stream.id(), first_draw, GLsizeiptr(run.command_count * sizeof(Draw_Data)));
+        GLenum const index_type = run.index_size == sizeof(u16) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+        glMultiDrawElementsIndirect(GL_TRIANGLES, index_type, (void*)(run.first_command * sizeof(Indirect_Commands::Command)), GLsizei(run.command_count), 0);
+        Get_State_Changes().draws++;
+        previous = &run;
+    }
+    glBindVertexArray(0);
+}
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "Common.h"
+#include "Vector.h"
+#include "Graphics.h"
+#include "Indirect_Commands.h"
+#include "Render_Queue.h"
+#include "Uniform_Buffers.h"
+
+#include <vector>
+
+namespace GL {
+
+// --------------------------------------------------
+// Render_Meshes with one glMultiDrawElementsIndirect per run of meshes
+// that share the VAO, the index type and the textures (the meshes of a
+// Geometry_Arena layout), instead of one draw per mesh. the commands are
+// uploaded once per call, the Draw_Data of every visible mesh is one write
+// into a Stream_Buffer (persistently mapped where the driver can).
+// view & projection come from the Frame block (see Frame_Block).
+// needs multi draw indirect, storage buffers & gl_DrawIDARB and a shader
+// that reads Draw_Data (shader/model_loading_indirect.vertex and
+// shader/model_loading_packed_indirect.vertex). without them
+// supported() is false, the caller has to use the plain shaders and the
+// meshes go through a sorted Render_Queue instead.
+// the command building is in Indirect_Commands.h, tested and benched
+// without gl in tests/. there is no test of the gl half: the tests are
+// plain programs without a context, and contexts only come from the
+// glfw window of Global_Init. a headless run needs an egl context on a
+// driver with the three extensions (mesa's llvmpipe has them), which
+// neither the windows project nor the test Makefile sets up
+// --------------------------------------------------
+struct Indirect_Renderer {
+
+    Indirect_Renderer(); // needs a context with loaded extensions
+    ~Indirect_Renderer();
+
+    bool supported() const { return enabled; }
+
+    void render(Meshes const& meshes, Shader const& shader, float44 const& model = identity44()); // full detail
+    void render(Meshes const& meshes, Shader const& shader, Lod_View const& view); // coarsest level that looks the same, view.model is the model
+
+    // after the last render call of a frame, the draw data of the next frame goes into the next region
+    void next_frame();
+
+    // of the last render call
+    std::size_t draw_count() const { return batch.commands.size(); }
+    std::size_t multi_draw_count() const { return batch.runs.size(); }
+
+    no_copy_and_assign(Indirect_Renderer);
+    no_move_and_assign(Indirect_Renderer);
+
+private:
+    void render_fallback(Meshes const& meshes, Shader const& shader, float44 const& model, Lod_View const* view);
+    void submit(Shader const& shader);
+
+    bool        enabled         = false;
+    uint          command_buffer   = 0;
+    Stream_Buffer draw_stream      = {};
+    std::size_t   offset_alignment = 1; // of storage buffer ranges, in bytes
+    std::size_t   draw_alignment   = 1; // the same in Draw_Data
+
+    Render_Queue      fallback = {};
+    Indirect_Commands batch    = {};
+};
+
+}
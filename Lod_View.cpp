@@ -0,0 +1,38 @@
+#include "Lod_View.h"
+
+#include <algorithm>
+#include <cmath>
+
+Lod_View Make_Lod_View(float3 camera_position, float44 const& model, float fov_y, uint viewport_height)
+{
+    Lod_View view{};
+    view.camera_position = camera_position;
+    view.model           = model;
+    view.pixel_scale     = float(viewport_height) / (2.0f * std::tan(fov_y * 0.5f));
+    return view;
+}
+
+std::size_t Select_Lod(Mesh const& mesh, Lod_View const& view)
+{
+    // the bounding sphere in world space, scaled by the largest axis of the model matrix
+    float3 const center = transform_point(view.model, mesh.bounding_center);
+    float const scale = std::max({
+        length(transform_vector(view.model, float3{ 1.0f, 0.0f, 0.0f })),
+        length(transform_vector(view.model, float3{ 0.0f, 1.0f, 0.0f })),
+        length(transform_vector(view.model, float3{ 0.0f, 0.0f, 1.0f })) });
+    float const radius = mesh.bounding_radius * scale;
+
+    // from the nearest point of the sphere, inside it everything is full detail
+    float const distance = length(center - view.camera_position) - radius;
+    if (distance <= 0.0f) {
+        return 0;
+    }
+
+    for (std::size_t level = mesh.lod_count() - 1; level > 0; --level) {
+        float const pixels = mesh.lod(level).error * radius / distance * view.pixel_scale;
+        if (pixels <= view.max_pixel_error) {
+            return level;
+        }
+    }
+    return 0;
+}
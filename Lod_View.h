@@ -0,0 +1,16 @@
+#pragma once
+
+#include "Common.h"
+#include "Vector.h"
+#include "Matrix.h"
+#include "Mesh.h"
+
+// where the meshes are seen from, for picking the level of detail
+struct Lod_View {
+    float3  camera_position = {};
+    float44 model           = identity44();
+    float   pixel_scale     = 0.0f; // pixels per unit at distance 1: viewport_height / (2 * tan(fov_y / 2))
+    float   max_pixel_error = 1.0f; // how far the surface may move on screen
+};
+Lod_View    Make_Lod_View(float3 camera_position, float44 const& model, float fov_y, uint viewport_height);
+std::size_t Select_Lod(Mesh const& m, Lod_View const& view); // coarsest level that looks the same
@@ -2,11 +2,20 @@
 #include "Vector.h"
 #include "Matrix.h"
 #include "Graphics.h"
+#include "Geometry_Arena.h"
+#include "Indirect_Renderer.h"
 #include "Model.h"
 #include "Input.h"
 #include "File.h"
+#include "Profiling.h"
+#include "Program_Cache.h"
+#include "Texture_Manager.h"
+#include "Texture_Streamer.h"
+#include "Texture_Compression.h"
 
+#include <chrono>
 #include <iostream>
+#include <string>
 
 
 #pragma comment(lib, "opengl32.lib")
@@ -15,8 +24,30 @@
 
 float44 mat;
 
-int main()
+int main(int argc, char** argv)
 {
+    // offline asset step, no window needed: 3D_Game --bake models/a.obj models/b.obj ...
+    if (argc > 1 && std::string{ argv[1] } == "--bake") {
+        bool success = true;
+        for (int n = 2; n < argc; ++n) {
+            success = Bake_Model(argv[n], All_Cores) && success;
+        }
+        return success ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // offline asset step: 3D_Game --compress bc1|bc3|bc5|bc7 [--srgb] image.png texture.dds
+    if (argc > 1 && std::string{ argv[1] } == "--compress") {
+        int  n      = 2;
+        auto format = n < argc ? Texture_Compression::Parse_Format(argv[n++]) : std::nullopt;
+        bool gamma  = n < argc && std::string{ argv[n] } == "--srgb";
+        n += gamma ? 1 : 0;
+        if (!format || argc - n != 2) {
+            std::cerr << "usage: --compress bc1|bc3|bc5|bc7 [--srgb] <image> <texture.dds>\n";
+            return EXIT_FAILURE;
+        }
+        return Texture_Compression::Compress_File(argv[n], argv[n + 1], *format, gamma, All_Cores) ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     /// test the model loading
     /// auto obj = Model::LoadOBJ("test.blend");
 
@@ -27,43 +58,99 @@ int main()
     }
     on_exit(GL::Global_Teardown());
 
-    GL::Shader test_shader("shader/model_loading.vertex", "shader/model_loading.fragment", { "model" });// {"material.texture_diffuse1"});
+    // one multi draw for the whole model if the driver can, its shader reads the per draw data
+    GL::Indirect_Renderer renderer {};
+    const char* vertex_path = renderer.supported() ? "shader/model_loading_indirect.vertex" : "shader/model_loading.vertex";
+
+    GL::Shader test_shader(vertex_path, "shader/model_loading.fragment", {});
 
     Input_Controller input { window };
 
-    auto model = Load_Model("models/test_model.obj");
+    // view, projection & time of every shader, one upload per frame
+    GL::Frame_Block    frame_block {};
+    GL::Frame_Uniforms frame {};
+    float3 const       camera_position { 0.0f, 0.0f, 3.0f };
+    float const        fov_y = 0.8f;
+    frame.view       = look_at(camera_position, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f });
+    frame.projection = perspective(fov_y, float(input.w) / float(input.h), 0.1f, 100.0f);
+
+    // every mesh draws the coarsest level that still looks like the full detail from the camera
+    Lod_View const lod_view = Make_Lod_View(camera_position, identity44(), fov_y, input.h);
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    GL::Texture_Streamer streamer {};
+    GL::Texture_Manager  textures { std::size_t(512) << 20, &streamer };
+
+    GL::Geometry_Arena geometry {};
+
+    auto model = Load_Model("models/test_model.obj", textures, All_Cores);
     for (Mesh& mesh : model) {
-        GL::Allocate_Mesh(mesh);
+        Set_Layout(mesh, Mesh::split); // positions in their own buffer
+        geometry.allocate(mesh);
     }
 
     //uint VBO, VAO;
     //GL::Create_Cube_Buffer(VBO, VAO);
 
-    auto [vertex_code, fragment_code] = File::ReadFull("shader/model_loading.vertex", "shader/model_loading.fragment" );
+    auto [vertex_code, fragment_code] = File::ReadFull(vertex_path, "shader/model_loading.fragment" );
+
+    Frame_Histogram frame_times {};
 
     u64 counter = 0;
+    u64 first_frame_allocations = 0; // growing the buffers of the renderer
+    u64 render_allocations = 0;      // of every other frame, should stay 0
     while (GL::Is_Open(window)) {
         counter++;
+        frame_times.frame();
 
         input.update(0.5f);
 
         // every so-and-so cycles reload the shader for live-editing
         if (counter % 100 == 1) {
-            auto[vertex_code_tmp, fragment_code_tmp] = File::ReadFull("shader/model_loading.vertex", "shader/model_loading.fragment");
+            auto[vertex_code_tmp, fragment_code_tmp] = File::ReadFull(vertex_path, "shader/model_loading.fragment");
             if (vertex_code != vertex_code_tmp || fragment_code != fragment_code_tmp) {
-                test_shader = GL::Shader{ "shader/model_loading.vertex", "shader/model_loading.fragment",{ "model" } };
+                test_shader = GL::Shader{ vertex_path, "shader/model_loading.fragment", {} };
             }
         }
 
+        textures.update();
+
         GL::Clear_Screen();
         GL::Close_On_Escape(window);
         //GL::Render_Test(test_shader, VAO, 36, input.position);
-        GL::Render_Meshes(model, test_shader);
+        frame.time = std::chrono::duration<float>(std::chrono::steady_clock::now() - start_time).count();
+        frame_block.update(frame);
+        std::optional<u64> const allocations_before = Allocation_Count();
+        renderer.render(model, test_shader, lod_view);
+        if (allocations_before) {
+            u64 const allocations = *Allocation_Count() - *allocations_before;
+            if (counter == 1) { first_frame_allocations = allocations; }
+            else { render_allocations += allocations; }
+        }
+        renderer.next_frame();
         GL::Poll_And_Swap(window);
 
         if (counter > 2000) { break; } // a real timed solution would be better...
     }
 
+    frame_times.print();
+    textures.print_stats();
+    geometry.print_stats();
+    GL::Print_State_Changes();
+    Program_Cache::Print_Stats();
+    if (Allocation_Count()) {
+        std::cout << "render allocations: " << first_frame_allocations << " in the first frame, " << render_allocations << " in the other " << counter - 1 << '\n';
+    }
+    else {
+        std::cout << "render allocations: not counted, build with COUNT_ALLOCATIONS or _DEBUG\n";
+    }
+
+    for (Mesh& mesh : model) {
+        geometry.free(mesh);
+    }
+    Free_Model(model, textures);
+
 
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -2,8 +2,15 @@
 
 // --------------------------------------------------
 // templated mathematical matrix
+// stored row by row (data[row][col]) and used with column vectors:
+// transformed = matrix * vector, the translation is the last column.
+// glsl expects columns first, so upload with transpose = GL_TRUE.
 // --------------------------------------------------
 
+#include "Vector.h"
+
+#include <cassert>
+#include <cmath>
 #include <cstddef>
 
 // generic base
@@ -32,6 +39,35 @@ struct Matrix<Type, 4, 4> {
     Type data[4][4];
 };
 
+// the rows live in simd registers, see the float44 operations at the end
+template <>
+struct alignas(16) Matrix<float, 4, 4> {
+
+    Matrix() : Matrix(0.0f)
+    {
+    }
+
+    Matrix(float value)
+    {
+        for (auto& row : rows) {
+            row = Simd::splat(value);
+        }
+    }
+
+    Matrix(float4 const& row0, float4 const& row1, float4 const& row2, float4 const& row3)
+    {
+        rows[0] = row0.simd;
+        rows[1] = row1.simd;
+        rows[2] = row2.simd;
+        rows[3] = row3.simd;
+    }
+
+    union {
+        float          data[4][4];
+        Simd::Register rows[4];
+    };
+};
+
 // typedefs for easier access
 using float44 = Matrix<float, 4, 4>;
 
@@ -65,7 +101,7 @@ bool operator != (Matrix<Type, Rows, Cols> const& a, Matrix<Type, Rows, Cols> co
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator + (Matrix<Type, Rows, Cols> const& a, Matrix<Type, Rows, Cols> const& b)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             result.data[row][col] = a.data[row][col] + b.data[row][col];
@@ -77,7 +113,7 @@ Matrix<Type, Rows, Cols> operator + (Matrix<Type, Rows, Cols> const& a, Matrix<T
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator - (Matrix<Type, Rows, Cols> const& a, Matrix<Type, Rows, Cols> const& b)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             result.data[row][col] = a.data[row][col] - b.data[row][col];
@@ -93,7 +129,7 @@ Matrix<Type, Rows, Cols> operator - (Matrix<Type, Rows, Cols> const& a, Matrix<T
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator * (Matrix<Type, Rows, Cols> const& mat, Type const& value)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             result.data[row][col] = mat.data[row][col] * value;
@@ -105,7 +141,7 @@ Matrix<Type, Rows, Cols> operator * (Matrix<Type, Rows, Cols> const& mat, Type c
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator * (Type const& value, Matrix<Type, Rows, Cols> const& mat)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             result.data[row][col] = mat.data[row][col] * value;
@@ -117,7 +153,7 @@ Matrix<Type, Rows, Cols> operator * (Type const& value, Matrix<Type, Rows, Cols>
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator / (Matrix<Type, Rows, Cols> const& mat, Type const& value)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             result.data[row][col] = mat.data[row][col] / value;
@@ -129,7 +165,7 @@ Matrix<Type, Rows, Cols> operator / (Matrix<Type, Rows, Cols> const& mat, Type c
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator + (Matrix<Type, Rows, Cols> const& mat, Type const& value)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             result.data[row][col] = mat.data[row][col] + value;
@@ -141,7 +177,7 @@ Matrix<Type, Rows, Cols> operator + (Matrix<Type, Rows, Cols> const& mat, Type c
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator + (Type const& value, Matrix<Type, Rows, Cols> const& mat)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             result.data[row][col] = mat.data[row][col] + value;
@@ -153,7 +189,7 @@ Matrix<Type, Rows, Cols> operator + (Type const& value, Matrix<Type, Rows, Cols>
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator - (Matrix<Type, Rows, Cols> const& mat, Type const& value)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             result.data[row][col] = mat.data[row][col] - value;
@@ -165,11 +201,45 @@ Matrix<Type, Rows, Cols> operator - (Matrix<Type, Rows, Cols> const& mat, Type c
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> operator - (Type const& value, Matrix<Type, Rows, Cols> const& mat)
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
-            result.data[row][col] = mat.data[row][col] - value;
+            result.data[row][col] = value - mat.data[row][col];
+        }
+    }
+    return result;
+}
+
+// --------------------------------------------------
+// matrix & matrix/vector products
+// --------------------------------------------------
+
+template <class Type, std::size_t Rows, std::size_t Inner, std::size_t Cols>
+Matrix<Type, Rows, Cols> operator * (Matrix<Type, Rows, Inner> const& a, Matrix<Type, Inner, Cols> const& b)
+{
+    Matrix<Type, Rows, Cols> result;
+    for (std::size_t row = 0; row < Rows; ++row) {
+        for (std::size_t col = 0; col < Cols; ++col) {
+            Type sum = Type(0);
+            for (std::size_t n = 0; n < Inner; ++n) {
+                sum += a.data[row][n] * b.data[n][col];
+            }
+            result.data[row][col] = sum;
+        }
+    }
+    return result;
+}
+
+template <class Type, std::size_t Rows, std::size_t Cols>
+Vector<Type, Rows> operator * (Matrix<Type, Rows, Cols> const& mat, Vector<Type, Cols> const& vec)
+{
+    Vector<Type, Rows> result;
+    for (std::size_t row = 0; row < Rows; ++row) {
+        Type sum = Type(0);
+        for (std::size_t col = 0; col < Cols; ++col) {
+            sum += mat.data[row][col] * vec.data[col];
         }
+        result.data[row] = sum;
     }
     return result;
 }
@@ -181,12 +251,242 @@ Matrix<Type, Rows, Cols> operator - (Type const& value, Matrix<Type, Rows, Cols>
 template <class Type, std::size_t Rows, std::size_t Cols>
 Matrix<Type, Rows, Cols> identity()
 {
-    Matrix<Type, Size> result;
+    Matrix<Type, Rows, Cols> result;
     for (std::size_t row = 0; row < Rows; ++row) {
         for (std::size_t col = 0; col < Cols; ++col) {
             const bool is_diagonal = row == col;
-            mat[row][col] = is_diagonal ? 1 : 0;
+            result.data[row][col] = is_diagonal ? Type(1) : Type(0);
+        }
+    }
+    return result;
+}
+
+template <class Type, std::size_t Rows, std::size_t Cols>
+Matrix<Type, Cols, Rows> transpose(Matrix<Type, Rows, Cols> const& mat)
+{
+    Matrix<Type, Cols, Rows> result;
+    for (std::size_t row = 0; row < Rows; ++row) {
+        for (std::size_t col = 0; col < Cols; ++col) {
+            result.data[col][row] = mat.data[row][col];
         }
     }
     return result;
-}
\ No newline at end of file
+}
+
+// --------------------------------------------------
+// simd float44 operations, picked over the generic templates
+// --------------------------------------------------
+
+inline float44 identity44()
+{
+    return { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } };
+}
+
+inline float44 operator * (float44 const& a, float44 const& b)
+{
+    // every result row is a weighted sum of the rows of b
+    float44 result;
+    for (int row = 0; row < 4; ++row) {
+        Simd::Register sum = Simd::mul(Simd::splat(a.data[row][0]), b.rows[0]);
+        sum = Simd::add(sum, Simd::mul(Simd::splat(a.data[row][1]), b.rows[1]));
+        sum = Simd::add(sum, Simd::mul(Simd::splat(a.data[row][2]), b.rows[2]));
+        sum = Simd::add(sum, Simd::mul(Simd::splat(a.data[row][3]), b.rows[3]));
+        result.rows[row] = sum;
+    }
+    return result;
+}
+
+inline float4 operator * (float44 const& mat, float4 const& vec)
+{
+    // one product per row, transposed so the 4 horizontal sums become 3 vertical adds
+    Simd::Register x = Simd::mul(mat.rows[0], vec.simd);
+    Simd::Register y = Simd::mul(mat.rows[1], vec.simd);
+    Simd::Register z = Simd::mul(mat.rows[2], vec.simd);
+    Simd::Register w = Simd::mul(mat.rows[3], vec.simd);
+    Simd::transpose(x, y, z, w);
+    return Simd::add(Simd::add(x, y), Simd::add(z, w));
+}
+
+inline float44 transpose(float44 const& mat)
+{
+    float44 result = mat;
+    Simd::transpose(result.rows[0], result.rows[1], result.rows[2], result.rows[3]);
+    return result;
+}
+
+// w = 1, without the perspective divide
+inline float3 transform_point(float44 const& mat, float3 const& point)
+{
+    float4 const result = mat * float4{ point, 1.0f };
+    return { result.x, result.y, result.z };
+}
+
+// w = 0, the translation is ignored. normals need the inverse transpose instead
+inline float3 transform_vector(float44 const& mat, float3 const& vec)
+{
+    float4 const result = mat * float4{ vec, 0.0f };
+    return { result.x, result.y, result.z };
+}
+
+// any invertible matrix, through the 2x2 sub determinants
+inline float44 inverse(float44 const& mat)
+{
+    auto const& a = mat.data;
+
+    float const s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+    float const s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+    float const s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+    float const s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+    float const s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+    float const s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+    float const c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+    float const c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+    float const c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+    float const c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+    float const c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+    float const c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+
+    float const determinant = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+    assert(determinant != 0.0f && "the matrix is not invertible");
+    if (determinant == 0.0f) {
+        return {};
+    }
+
+    float44 result{
+        {  a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3, -a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3,  a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3, -a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3 },
+        { -a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1,  a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1, -a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1,  a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1 },
+        {  a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0, -a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0,  a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0, -a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0 },
+        { -a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0,  a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0, -a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0,  a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0 },
+    };
+
+    Simd::Register const scale = Simd::splat(1.0f / determinant);
+    for (auto& row : result.rows) {
+        row = Simd::mul(row, scale);
+    }
+    return result;
+}
+
+// fast path for transforms whose last row is (0, 0, 0, 1): rotation, scale, shear and translation
+inline float44 inverse_affine(float44 const& mat)
+{
+    assert(mat.data[3][0] == 0.0f && mat.data[3][1] == 0.0f && mat.data[3][2] == 0.0f && mat.data[3][3] == 1.0f);
+
+    // the columns of the 3x3 part (4th lane 0) and the translation
+    Simd::Register c0 = mat.rows[0], c1 = mat.rows[1], c2 = mat.rows[2], translation = mat.rows[3];
+    Simd::transpose(c0, c1, c2, translation);
+
+    // the rows of the inverse 3x3 part are the cross products of its columns
+    float3a const row0 = cross_product(float3a{ c1 }, float3a{ c2 });
+    float3a const row1 = cross_product(float3a{ c2 }, float3a{ c0 });
+    float3a const row2 = cross_product(float3a{ c0 }, float3a{ c1 });
+
+    float const determinant = dot_product(float3a{ c0 }, row0);
+    assert(determinant != 0.0f && "the matrix is not invertible");
+    if (determinant == 0.0f) {
+        return {};
+    }
+
+    float44 result;
+    Simd::Register const scale = Simd::splat(1.0f / determinant);
+    result.rows[0] = Simd::mul(row0.simd, scale);
+    result.rows[1] = Simd::mul(row1.simd, scale);
+    result.rows[2] = Simd::mul(row2.simd, scale);
+    result.rows[3] = Simd::set(0.0f, 0.0f, 0.0f, 1.0f);
+
+    // new translation = -inverse(3x3) * translation, the 4th lane of the rows is still 0
+    for (int row = 0; row < 3; ++row) {
+        result.data[row][3] = -Simd::first(Simd::horizontal_sum(Simd::mul(result.rows[row], translation)));
+    }
+    return result;
+}
+
+// --------------------------------------------------
+// transform builders
+// --------------------------------------------------
+
+inline float44 translation(float3 const& offset)
+{
+    return { { 1, 0, 0, offset.x }, { 0, 1, 0, offset.y }, { 0, 0, 1, offset.z }, { 0, 0, 0, 1 } };
+}
+
+inline float44 scaling(float3 const& scale)
+{
+    return { { scale.x, 0, 0, 0 }, { 0, scale.y, 0, 0 }, { 0, 0, scale.z, 0 }, { 0, 0, 0, 1 } };
+}
+
+// unit quaternion (x, y, z, w) to a rotation matrix
+inline float44 rotation(float4 const& q)
+{
+    float const xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    float const xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    float const wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    return {
+        { 1 - 2 * (yy + zz),     2 * (xy - wz),     2 * (xz + wy), 0 },
+        {     2 * (xy + wz), 1 - 2 * (xx + zz),     2 * (yz - wx), 0 },
+        {     2 * (xz - wy),     2 * (yz + wx), 1 - 2 * (xx + yy), 0 },
+        {                 0,                 0,                 0, 1 },
+    };
+}
+
+// counter clockwise around the axis when looking against it, angle in radians
+inline float44 rotation(float3 const& axis, float angle)
+{
+    float3 const n = normalize(axis);
+    float const  s = std::sin(angle * 0.5f);
+    return rotation(float4{ n.x * s, n.y * s, n.z * s, std::cos(angle * 0.5f) });
+}
+
+// translation * rotation * scale, without the two matrix products
+inline float44 compose_trs(float3 const& offset, float4 const& q, float3 const& scale)
+{
+    float44 result = rotation(q);
+    Simd::Register const column_scale = Simd::set(scale.x, scale.y, scale.z, 1.0f);
+    for (int row = 0; row < 3; ++row) {
+        result.rows[row] = Simd::mul(result.rows[row], column_scale);
+    }
+    result.data[0][3] = offset.x;
+    result.data[1][3] = offset.y;
+    result.data[2][3] = offset.z;
+    return result;
+}
+
+// right handed view space looking down -z, like gluLookAt
+inline float44 look_at(float3 const& eye, float3 const& target, float3 const& up)
+{
+    float3 const forward = normalize(target - eye);
+    float3 const side    = normalize(cross_product(forward, up));
+    float3 const new_up  = cross_product(side, forward);
+
+    return {
+        {     side.x,     side.y,     side.z, -dot_product(side, eye) },
+        {   new_up.x,   new_up.y,   new_up.z, -dot_product(new_up, eye) },
+        { -forward.x, -forward.y, -forward.z,  dot_product(forward, eye) },
+        {          0,          0,          0,  1 },
+    };
+}
+
+// opengl clip space (depth -1..1), vertical field of view in radians
+inline float44 perspective(float fov_y, float aspect, float near_plane, float far_plane)
+{
+    float const f     = 1.0f / std::tan(fov_y * 0.5f);
+    float const depth = near_plane - far_plane;
+
+    return {
+        { f / aspect, 0,                                    0,                                        0 },
+        {          0, f,                                    0,                                        0 },
+        {          0, 0, (far_plane + near_plane) / depth, 2.0f * far_plane * near_plane / depth },
+        {          0, 0,                                   -1,                                        0 },
+    };
+}
+
+inline float44 orthographic(float left, float right, float bottom, float top, float near_plane, float far_plane)
+{
+    return {
+        { 2.0f / (right - left), 0, 0, -(right + left) / (right - left) },
+        { 0, 2.0f / (top - bottom), 0, -(top + bottom) / (top - bottom) },
+        { 0, 0, -2.0f / (far_plane - near_plane), -(far_plane + near_plane) / (far_plane - near_plane) },
+        { 0, 0, 0, 1 },
+    };
+}
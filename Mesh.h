@@ -2,21 +2,101 @@
 
 #include "Common.h"
 #include "Vertex.h"
+#include "Vertex_Packing.h"
 #include "Texture.h"
 
 #include <vector>
 
+// vertex counts up to this fit into 16 bit indices, which halves index memory & bandwidth
+constexpr std::size_t Max_16_Bit_Vertices = 65536;
+
+// one level of detail: a range of Mesh::indices, every level uses the same vertices
+struct Mesh_Lod {
+    u32   first_index = 0;
+    u32   index_count = 0;
+    float error       = 0.0f; // how far the surface moved, relative to Mesh::bounding_radius
+};
+
 struct Mesh {
 
+    // interleaved: one Vertex array and one VBO (what the loaders and the mesh cache produce)
+    // split:       positions and attributes in separate arrays and VBOs
+    // packed:      20 byte Packed_Vertex, needs a shader with the packed decode
+    //              (shader/model_loading_packed.vertex and its position_offset & position_scale uniforms)
+    enum Layout : u32 {
+        interleaved,
+        split,
+        packed
+    };
+
     // model specific data
-    Vertices vertices = {};
-    Indices  indices  = {};
-    Textures textures = {};
+    Layout          layout          = interleaved;
+    Vertices        vertices        = {}; // interleaved layout
+    Vertex_Streams  streams         = {}; // split layout
+    Packed_Vertices packed_vertices = {}; // packed layout
+    Indices         indices         = {}; // every level of detail, full detail first
+    Textures        textures        = {};
+
+    // no levels: one level with every index
+    std::vector<Mesh_Lod> lods            = {};
+    float3                bounding_center = {};
+    float                 bounding_radius = 0.0f;
 
     // render specific data
     uint VAO = 0;
-    uint VBO = 0;
+    uint VBO = 0; // split layout: only the positions
     uint EBO = 0;
+    uint attribute_VBO = 0; // split layout only
+    uint index_size    = sizeof(uint); // bytes per index in the EBO, 2 whenever the vertex count allows it
 
+    // GL::Geometry_Arena meshes share the VAO & buffers of their layout (VBO & EBO stay 0)
+    // and are ranges inside them
+    bool in_arena     = false;
+    u32  base_vertex  = 0; // added to every index by the draw
+    u64  index_offset = 0; // bytes from the start of the EBO to indices[0]
+
+    std::size_t vertex_count() const
+    {
+        switch (layout) {
+        case split:  return streams.size();
+        case packed: return packed_vertices.size();
+        default:     return vertices.size();
+        }
+    }
+
+    std::size_t lod_count() const { return lods.empty() ? 1 : lods.size(); }
+    Mesh_Lod    lod(std::size_t level) const
+    {
+        assert(level < lod_count());
+        return lods.empty() ? Mesh_Lod{ 0, u32(indices.size()), 0.0f } : lods[level];
+    }
 };
-using Meshes = std::vector<Mesh>;
\ No newline at end of file
+using Meshes = std::vector<Mesh>;
+
+// converts the cpu side vertex data, has to happen before GL::Allocate_Mesh.
+// packing is lossy, converting a packed mesh back gives the quantized values
+inline void Set_Layout(Mesh& mesh, Mesh::Layout layout)
+{
+    assert(mesh.VAO == 0 && "the gpu buffers still have the old layout");
+    if (mesh.layout == layout) {
+        return;
+    }
+
+    // always through the interleaved form
+    Vertices vertices{};
+    switch (mesh.layout) {
+    case Mesh::split:  vertices = Interleave_Vertices(mesh.streams); break;
+    case Mesh::packed: vertices = Vertex_Packing::Unpack(mesh.packed_vertices); break;
+    default:           vertices = std::move(mesh.vertices); break;
+    }
+    mesh.vertices        = {};
+    mesh.streams         = {};
+    mesh.packed_vertices = {};
+
+    switch (layout) {
+    case Mesh::split:  mesh.streams = Split_Vertices(vertices); break;
+    case Mesh::packed: mesh.packed_vertices = Vertex_Packing::Pack(vertices); break;
+    default:           mesh.vertices = std::move(vertices); break;
+    }
+    mesh.layout = layout;
+}
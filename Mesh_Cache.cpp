@@ -0,0 +1,280 @@
+#include "Mesh_Cache.h"
+#include "File.h"
+#include "Profiling.h"
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+// ---------------------------------------------
+// file layout
+// ---------------------------------------------
+// [Header][Entry * mesh_count][Texture_Entry * texture_count][Mesh_Lod * lod_count][path strings]
+// [vertices mesh 0][indices mesh 0][vertices mesh 1]...
+// every block starts at a multiple of Alignment, so the arrays can be used right from the mapping
+#pragma region "Layout"
+
+constexpr u64 Alignment = 16;
+constexpr char Magic[4] = { 'M', 'E', 'S', 'H' };
+
+struct Header {
+    char magic[4]      = {};
+    u32  version       = 0;
+    u32  vertex_size   = 0; // sizeof(Vertex) of the baking program
+    u32  import_flags  = 0;
+    u64  source_time   = 0;
+    u32  path_length   = 0; // the source path follows the texture table
+    u32  mesh_count    = 0;
+    u32  texture_count = 0;
+    u32  lod_count     = 0;
+    u64  file_size     = 0;
+};
+
+struct Entry {
+    u64   vertex_offset      = 0;
+    u64   index_offset       = 0;
+    u32   vertex_count       = 0;
+    u32   index_count        = 0; // every level of detail
+    u32   first_texture      = 0;
+    u32   texture_count      = 0;
+    u32   first_lod          = 0;
+    u32   lod_count          = 0;
+    u32   index_size         = 0; // 2 or 4 bytes, 16 bit whenever the vertex count allows it
+    u32   padding            = 0;
+    float bounding_center[3] = {};
+    float bounding_radius    = 0.0f;
+};
+
+struct Texture_Entry {
+    u32 type        = 0;
+    u32 path_offset = 0; // relative to the start of the string block
+    u32 path_length = 0;
+    u32 padding     = 0;
+};
+
+u64 Align(u64 offset)
+{
+    return (offset + Alignment - 1) & ~(Alignment - 1);
+}
+
+#pragma endregion
+
+Mesh_Cache::Key Mesh_Cache::Make_Key(std::string const& source_path, u32 import_flags)
+{
+    Key key{};
+    key.source_path  = source_path;
+    key.import_flags = import_flags;
+
+    std::error_code error{};
+    auto const time = std::filesystem::last_write_time(source_path, error);
+    if (!error) {
+        key.source_time = static_cast<u64>(time.time_since_epoch().count());
+    }
+    return key;
+}
+
+std::string Mesh_Cache::Cache_Path(std::string const& source_path)
+{
+    return source_path + ".mesh";
+}
+
+bool Mesh_Cache::Write(std::string const& cache_path, Key const& key, Meshes const& meshes)
+{
+    measure_time();
+
+    // collect the tables first, the offsets of the data blocks depend on their size
+    std::vector<Entry>         entries(meshes.size());
+    std::vector<Texture_Entry> textures{};
+    std::vector<Mesh_Lod>      lods{};
+    std::string                strings = key.source_path;
+
+    for_size (n, meshes) {
+        Mesh const& mesh = meshes[n];
+        assert(mesh.layout == Mesh::interleaved && "baked meshes are stored interleaved");
+        entries[n].vertex_count  = u32(mesh.vertices.size());
+        entries[n].index_count   = u32(mesh.indices.size());
+        entries[n].first_texture = u32(textures.size());
+        entries[n].texture_count = u32(mesh.textures.size());
+        entries[n].first_lod     = u32(lods.size());
+        entries[n].lod_count     = u32(mesh.lods.size());
+        entries[n].index_size    = u32(mesh.vertex_count() <= Max_16_Bit_Vertices ? sizeof(u16) : sizeof(uint));
+        std::memcpy(entries[n].bounding_center, mesh.bounding_center.data, sizeof(entries[n].bounding_center));
+        entries[n].bounding_radius = mesh.bounding_radius;
+        lods.insert(lods.end(), mesh.lods.begin(), mesh.lods.end());
+
+        for (Texture const& texture : mesh.textures) {
+            Texture_Entry t{};
+            t.type        = u32(texture.type);
+            t.path_offset = u32(strings.size());
+            t.path_length = u32(texture.path.size());
+            strings += texture.path;
+            textures.push_back(t);
+        }
+    }
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version       = Version;
+    header.vertex_size   = sizeof(Vertex);
+    header.import_flags  = key.import_flags;
+    header.source_time   = key.source_time;
+    header.path_length   = u32(key.source_path.size());
+    header.mesh_count    = u32(entries.size());
+    header.texture_count = u32(textures.size());
+    header.lod_count     = u32(lods.size());
+
+    u64 offset = sizeof(Header) + entries.size() * sizeof(Entry) + textures.size() * sizeof(Texture_Entry) + lods.size() * sizeof(Mesh_Lod) + strings.size();
+    for (Entry& entry : entries) {
+        entry.vertex_offset = offset = Align(offset);
+        offset += entry.vertex_count * sizeof(Vertex);
+        entry.index_offset = offset = Align(offset);
+        offset += u64(entry.index_count) * entry.index_size;
+    }
+    header.file_size = offset;
+
+    // write into a temporary file first, a crash while baking must never leave a broken cache behind
+    std::string const temp_path = cache_path + ".tmp";
+    bool written = false;
+    {
+        std::ofstream file{ temp_path, std::ios::binary | std::ios::trunc };
+
+        auto pad_to = [&file](u64 target) {
+            static constexpr char zeros[Alignment] = {};
+            u64 const current = u64(file.tellp());
+            file.write(zeros, std::streamsize(target - current));
+        };
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(Entry));
+        file.write(reinterpret_cast<const char*>(textures.data()), textures.size() * sizeof(Texture_Entry));
+        file.write(reinterpret_cast<const char*>(lods.data()), lods.size() * sizeof(Mesh_Lod));
+        file.write(strings.data(), strings.size());
+
+        for_size (n, meshes) {
+            pad_to(entries[n].vertex_offset);
+            file.write(reinterpret_cast<const char*>(meshes[n].vertices.data()), meshes[n].vertices.size() * sizeof(Vertex));
+            pad_to(entries[n].index_offset);
+            if (entries[n].index_size == sizeof(u16)) {
+                std::vector<u16> const indices(meshes[n].indices.begin(), meshes[n].indices.end());
+                file.write(reinterpret_cast<const char*>(indices.data()), indices.size() * sizeof(u16));
+            }
+            else {
+                file.write(reinterpret_cast<const char*>(meshes[n].indices.data()), meshes[n].indices.size() * sizeof(uint));
+            }
+        }
+
+        written = file.good();
+    }
+
+    std::error_code error{};
+    if (written) {
+        std::filesystem::rename(temp_path, cache_path, error);
+    }
+    if (!written || error) {
+        std::cerr << "Failed to write mesh cache " << cache_path << '\n';
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+std::optional<Meshes> Mesh_Cache::Read(std::string const& cache_path, Key const& key)
+{
+    measure_time();
+
+    // a missing cache is the normal case for a new asset, so no error message here
+    std::error_code error{};
+    if (!std::filesystem::exists(cache_path, error)) {
+        return {};
+    }
+
+    File::Mapped const file{ cache_path.c_str() };
+    if (!file.is_open() || file.size < sizeof(Header)) {
+        return {};
+    }
+
+    // anything that doesn't match exactly means a re-import
+    Header const& header = *reinterpret_cast<const Header*>(file.data);
+    bool const valid =
+        std::memcmp(header.magic, Magic, sizeof(Magic)) == 0 &&
+        header.version      == Version &&
+        header.vertex_size  == sizeof(Vertex) &&
+        header.import_flags == key.import_flags &&
+        header.source_time  == key.source_time &&
+        header.file_size    == file.size;
+    if (!valid) {
+        return {};
+    }
+
+    u64 const tables_size = sizeof(Header) + u64(header.mesh_count) * sizeof(Entry) + u64(header.texture_count) * sizeof(Texture_Entry) + u64(header.lod_count) * sizeof(Mesh_Lod);
+    if (tables_size + header.path_length > file.size) {
+        return {};
+    }
+
+    const Entry*         entries  = reinterpret_cast<const Entry*>(file.data + sizeof(Header));
+    const Texture_Entry* textures = reinterpret_cast<const Texture_Entry*>(entries + header.mesh_count);
+    const Mesh_Lod*      lods     = reinterpret_cast<const Mesh_Lod*>(textures + header.texture_count);
+    const char*          strings  = reinterpret_cast<const char*>(lods + header.lod_count);
+    u64 const            strings_size = file.size - tables_size;
+
+    if (std::string{ strings, header.path_length } != key.source_path) {
+        return {};
+    }
+
+    Meshes meshes(header.mesh_count);
+    for_size (n, meshes) {
+        Entry const& entry = entries[n];
+        bool const in_bounds =
+            (entry.index_size == sizeof(u16) || entry.index_size == sizeof(uint)) &&
+            entry.vertex_offset + u64(entry.vertex_count) * sizeof(Vertex)   <= file.size &&
+            entry.index_offset  + u64(entry.index_count) * entry.index_size <= file.size &&
+            u64(entry.first_texture) + entry.texture_count <= header.texture_count &&
+            u64(entry.first_lod) + entry.lod_count <= header.lod_count;
+        if (!in_bounds) {
+            return {};
+        }
+
+        // plain block copies out of the mapping, 16 bit indices are widened on the way
+        const Vertex* vertices = reinterpret_cast<const Vertex*>(file.data + entry.vertex_offset);
+        meshes[n].vertices.assign(vertices, vertices + entry.vertex_count);
+        if (entry.index_size == sizeof(u16)) {
+            const u16* indices = reinterpret_cast<const u16*>(file.data + entry.index_offset);
+            meshes[n].indices.assign(indices, indices + entry.index_count);
+        }
+        else {
+            const uint* indices = reinterpret_cast<const uint*>(file.data + entry.index_offset);
+            meshes[n].indices.assign(indices, indices + entry.index_count);
+        }
+
+        meshes[n].lods.assign(lods + entry.first_lod, lods + entry.first_lod + entry.lod_count);
+        std::memcpy(meshes[n].bounding_center.data, entry.bounding_center, sizeof(entry.bounding_center));
+        meshes[n].bounding_radius = entry.bounding_radius;
+        for (Mesh_Lod const& lod : meshes[n].lods) {
+            if (u64(lod.first_index) + lod.index_count > entry.index_count) {
+                return {};
+            }
+        }
+
+        // an index past the vertices would make the gpu fetch outside the vertex buffer
+        for (uint index : meshes[n].indices) {
+            if (index >= entry.vertex_count) {
+                return {};
+            }
+        }
+
+        meshes[n].textures.resize(entry.texture_count);
+        for (u32 t = 0; t < entry.texture_count; ++t) {
+            Texture_Entry const& texture = textures[entry.first_texture + t];
+            if (u64(texture.path_offset) + texture.path_length > strings_size || texture.type >= Texture_Type_Count) {
+                return {};
+            }
+
+            meshes[n].textures[t].id   = 0;
+            meshes[n].textures[t].type = Texture::Type(texture.type);
+            meshes[n].textures[t].path.assign(strings + texture.path_offset, texture.path_length);
+        }
+    }
+
+    return meshes;
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+// --------------------------------------------------
+// baked meshes: a versioned binary image of Meshes
+// that is loaded with a single mapping and no parsing
+// --------------------------------------------------
+
+#include "Common.h"
+#include "Mesh.h"
+
+#include <optional>
+#include <string>
+
+namespace Mesh_Cache {
+
+// bump whenever the file layout, the Vertex struct or the import result changes
+// 2: the import optimizes the index & vertex order
+// 3: levels of detail & bounding sphere
+// 4: 16 bit indices for meshes that allow them, large meshes are split
+// 5: the levels of detail of split meshes keep the cuts in place
+constexpr u32 Version = 5;
+
+// a baked file is only valid for exactly this source file state and these import settings
+struct Key {
+    std::string source_path  = {};
+    u64         source_time  = 0; // last write time of the source file
+    u32         import_flags = 0;
+};
+
+Key         Make_Key(std::string const& source_path, u32 import_flags);
+std::string Cache_Path(std::string const& source_path);
+
+bool Write(std::string const& cache_path, Key const& key, Meshes const& meshes);
+
+// the textures are only references (path & type), the caller has to load them
+std::optional<Meshes> Read(std::string const& cache_path, Key const& key);
+
+}
@@ -0,0 +1,442 @@
+#include "Mesh_Optimizer.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numeric>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+constexpr uint No_Vertex   = ~0u;
+constexpr uint No_Triangle = ~0u;
+
+// fifo cache in O(1): a vertex is still cached while less than cache_size misses happened since it was loaded
+struct Fifo_Cache {
+    std::vector<uint> loaded_at;
+    uint              time = 0;
+    uint              size = 0;
+
+    Fifo_Cache(std::size_t vertex_count, uint cache_size) : loaded_at(vertex_count, 0), size{ cache_size } {}
+
+    void reset() { time += size; } // everything in the cache is old enough to be gone
+
+    // true on a miss
+    bool access(uint vertex)
+    {
+        if (time - loaded_at[vertex] < size && loaded_at[vertex] != 0) {
+            return false;
+        }
+        loaded_at[vertex] = ++time;
+        return true;
+    }
+
+    uint misses(const uint* triangle) { return uint(access(triangle[0])) + access(triangle[1]) + access(triangle[2]); }
+};
+
+// Forsyth's scoring, tuned for a 32 entry lru cache
+constexpr int   Score_Cache_Size   = 32;
+constexpr float Cache_Decay_Power  = 1.5f;
+constexpr float Last_Triangle      = 0.75f;
+constexpr float Valence_Boost      = 2.0f;
+constexpr float Valence_Power      = 0.5f;
+constexpr uint  Max_Table_Valence  = 32;
+
+struct Score_Tables {
+    float cache[Score_Cache_Size]     = {};
+    float valence[Max_Table_Valence]  = {};
+
+    Score_Tables()
+    {
+        for (int n = 0; n < Score_Cache_Size; ++n) {
+            if (n < 3) {
+                // the last triangle gets a fixed score, no matter the order of its corners
+                cache[n] = Last_Triangle;
+            }
+            else {
+                float const scaler = 1.0f / (Score_Cache_Size - 3);
+                cache[n] = std::pow(1.0f - (n - 3) * scaler, Cache_Decay_Power);
+            }
+        }
+        for (uint n = 1; n < Max_Table_Valence; ++n) {
+            valence[n] = Valence_Boost * std::pow(float(n), -Valence_Power);
+        }
+    }
+
+    // few live triangles left: prefer the vertex, so it is done and can leave the cache
+    float score(int cache_position, uint live_triangles) const
+    {
+        if (live_triangles == 0) {
+            return -1.0f;
+        }
+        float result = cache_position >= 0 ? cache[cache_position] : 0.0f;
+        result += live_triangles < Max_Table_Valence ? valence[live_triangles] : Valence_Boost * std::pow(float(live_triangles), -Valence_Power);
+        return result;
+    }
+};
+
+struct Cluster {
+    uint  first_triangle = 0;
+    uint  triangle_count = 0;
+    float sort_key       = 0.0f;
+};
+
+// cut wherever the fifo starts over (all 3 corners missed), that is where the cache order
+// jumped to a new region anyway. inside those, cut as soon as the running miss ratio is
+// within threshold of the ratio of the whole piece
+std::vector<Cluster> Find_Clusters(Indices const& indices, std::size_t vertex_count, float threshold)
+{
+    uint const triangle_count = uint(indices.size() / 3);
+    Fifo_Cache cache{ vertex_count, Mesh_Optimizer::Fifo_Size };
+
+    std::vector<uint> hard_starts{};
+    for (uint t = 0; t < triangle_count; ++t) {
+        if (cache.misses(&indices[t * 3]) == 3) {
+            hard_starts.push_back(t);
+        }
+    }
+    if (hard_starts.empty() || hard_starts[0] != 0) {
+        hard_starts.insert(hard_starts.begin(), 0);
+    }
+    hard_starts.push_back(triangle_count);
+
+    std::vector<Cluster> clusters{};
+    for (std::size_t h = 0; h + 1 < hard_starts.size(); ++h) {
+        uint const start = hard_starts[h];
+        uint const end   = hard_starts[h + 1];
+
+        cache.reset();
+        uint misses = 0;
+        for (uint t = start; t < end; ++t) {
+            misses += cache.misses(&indices[t * 3]);
+        }
+        float const limit = threshold * float(misses) / float(end - start);
+
+        cache.reset();
+        uint cluster_start  = start;
+        uint running_misses = 0;
+        for (uint t = start; t < end; ++t) {
+            running_misses += cache.misses(&indices[t * 3]);
+
+            bool const last = t + 1 == end;
+            if (last || float(running_misses) / float(t + 1 - cluster_start) <= limit) {
+                clusters.push_back({ cluster_start, t + 1 - cluster_start, 0.0f });
+                cluster_start  = t + 1;
+                running_misses = 0;
+                cache.reset();
+            }
+        }
+    }
+    return clusters;
+}
+
+#pragma endregion
+
+Mesh_Optimizer::Cache_Statistics Mesh_Optimizer::Analyze_Vertex_Cache(Indices const& indices, std::size_t vertex_count, uint cache_size)
+{
+    Cache_Statistics statistics{};
+    std::size_t const triangle_count = indices.size() / 3;
+    if (triangle_count == 0) {
+        return statistics;
+    }
+
+    Fifo_Cache        cache{ vertex_count, cache_size };
+    std::vector<bool> used(vertex_count, false);
+
+    std::size_t transformed = 0;
+    std::size_t used_count  = 0;
+    for (uint index : indices) {
+        transformed += cache.access(index);
+        if (!used[index]) {
+            used[index] = true;
+            ++used_count;
+        }
+    }
+
+    statistics.acmr = float(transformed) / float(triangle_count);
+    statistics.atvr = float(transformed) / float(used_count);
+    return statistics;
+}
+
+void Mesh_Optimizer::Optimize_Vertex_Cache(Indices& indices, std::size_t vertex_count)
+{
+    measure_time();
+
+    static Score_Tables const tables{};
+
+    uint const triangle_count = uint(indices.size() / 3);
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // triangles per vertex, as one flat list (live triangles first, emitted ones are swapped behind them)
+    std::vector<uint> live(vertex_count, 0);
+    for (uint index : indices) {
+        ++live[index];
+    }
+    std::vector<uint> first(vertex_count + 1, 0);
+    std::partial_sum(live.begin(), live.end(), first.begin() + 1);
+
+    std::vector<uint> adjacency(indices.size());
+    {
+        std::vector<uint> filled(vertex_count, 0);
+        for (uint t = 0; t < triangle_count; ++t) {
+            for (int c = 0; c < 3; ++c) {
+                uint const v = indices[t * 3 + c];
+                adjacency[first[v] + filled[v]++] = t;
+            }
+        }
+    }
+
+    std::vector<int>   cache_position(vertex_count, -1);
+    std::vector<float> vertex_score(vertex_count, 0.0f);
+    for (std::size_t v = 0; v < vertex_count; ++v) {
+        vertex_score[v] = tables.score(-1, live[v]);
+    }
+
+    std::vector<float> triangle_score(triangle_count, 0.0f);
+    std::vector<bool>  emitted(triangle_count, false);
+    uint best = 0;
+    for (uint t = 0; t < triangle_count; ++t) {
+        triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] + vertex_score[indices[t * 3 + 2]];
+        if (triangle_score[t] > triangle_score[best]) {
+            best = t;
+        }
+    }
+
+    // 3 extra slots for the vertices pushed out by a new triangle
+    std::array<uint, Score_Cache_Size + 3> cache{};
+    std::array<uint, Score_Cache_Size + 3> next_cache{};
+    uint cache_count = 0;
+
+    Indices result{};
+    result.reserve(indices.size());
+    uint input_cursor = 0; // fallback when the cache runs dry: the next triangle in input order
+
+    for (uint emitted_count = 0; emitted_count < triangle_count; ++emitted_count) {
+        if (best == No_Triangle) {
+            while (emitted[input_cursor]) {
+                ++input_cursor;
+            }
+            best = input_cursor;
+        }
+
+        uint const* triangle = &indices[best * 3];
+        result.insert(result.end(), triangle, triangle + 3);
+        emitted[best] = true;
+
+        // the triangle is not live anymore for its corners
+        for (int c = 0; c < 3; ++c) {
+            uint const v = triangle[c];
+            uint* begin = &adjacency[first[v]];
+            uint* end   = begin + live[v];
+            std::iter_swap(std::find(begin, end, best), end - 1);
+            --live[v];
+        }
+
+        // the new triangle goes to the front, the old order follows
+        uint next_count = 0;
+        for (int c = 0; c < 3; ++c) {
+            if (std::find(next_cache.begin(), next_cache.begin() + next_count, triangle[c]) == next_cache.begin() + next_count) {
+                next_cache[next_count++] = triangle[c]; // degenerate triangles share corners
+            }
+        }
+        for (uint n = 0; n < cache_count; ++n) {
+            uint const v = cache[n];
+            if (v != triangle[0] && v != triangle[1] && v != triangle[2]) {
+                next_cache[next_count++] = v;
+            }
+        }
+        std::swap(cache, next_cache);
+        cache_count = next_count;
+
+        // new scores for everything in the cache and the vertices that just dropped out of it
+        best = No_Triangle;
+        float best_score = -1.0f;
+        for (uint n = 0; n < cache_count; ++n) {
+            uint const v = cache[n];
+            int const position = n < uint(Score_Cache_Size) ? int(n) : -1;
+            cache_position[v] = position;
+
+            float const score = tables.score(position, live[v]);
+            float const delta = score - vertex_score[v];
+            vertex_score[v] = score;
+
+            for (uint a = first[v]; a < first[v] + live[v]; ++a) {
+                uint const t = adjacency[a];
+                triangle_score[t] += delta;
+                if (triangle_score[t] > best_score) {
+                    best_score = triangle_score[t];
+                    best       = t;
+                }
+            }
+        }
+        cache_count = std::min(cache_count, uint(Score_Cache_Size));
+    }
+
+    indices = std::move(result);
+}
+
+void Mesh_Optimizer::Optimize_Overdraw(Indices& indices, Vertices const& vertices, float threshold)
+{
+    measure_time();
+
+    if (indices.size() < 3) {
+        return;
+    }
+    std::vector<Cluster> clusters = Find_Clusters(indices, vertices.size(), threshold);
+
+    // area weighted centroid and normal of every cluster and of the whole mesh
+    std::vector<float3> centroids(clusters.size());
+    std::vector<float3> normals(clusters.size());
+    float3 mesh_centroid{};
+    float  mesh_area = 0.0f;
+
+    for_size (c, clusters) {
+        float3 centroid{};
+        float3 normal{};
+        float  area = 0.0f;
+        for (uint t = clusters[c].first_triangle; t < clusters[c].first_triangle + clusters[c].triangle_count; ++t) {
+            float3 const& a = vertices[indices[t * 3 + 0]].position;
+            float3 const& b = vertices[indices[t * 3 + 1]].position;
+            float3 const& d = vertices[indices[t * 3 + 2]].position;
+
+            float3 const cross = cross_product(b - a, d - a); // length = 2 * area
+            float const  twice = length(cross);
+
+            centroid += (a + b + d) * (twice / 3.0f);
+            normal   += cross;
+            area     += twice;
+        }
+        mesh_centroid += centroid;
+        mesh_area     += area;
+
+        centroids[c] = area > 0.0f ? centroid / area : centroid;
+        normals[c]   = length(normal) > 0.0f ? normalize(normal) : normal;
+    }
+    if (mesh_area > 0.0f) {
+        mesh_centroid = mesh_centroid / mesh_area;
+    }
+
+    // clusters facing away from the center are the ones most likely to be in front, draw them first
+    for_size (c, clusters) {
+        clusters[c].sort_key = dot_product(centroids[c] - mesh_centroid, normals[c]);
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](Cluster const& a, Cluster const& b) { return a.sort_key > b.sort_key; });
+
+    Indices result{};
+    result.reserve(indices.size());
+    for (Cluster const& cluster : clusters) {
+        auto const begin = indices.begin() + std::size_t(cluster.first_triangle) * 3;
+        result.insert(result.end(), begin, begin + std::size_t(cluster.triangle_count) * 3);
+    }
+    indices = std::move(result);
+}
+
+void Mesh_Optimizer::Optimize_Vertex_Fetch(Vertices& vertices, Indices& indices)
+{
+    measure_time();
+
+    std::vector<uint> remap(vertices.size(), No_Vertex);
+    uint next = 0;
+    for (uint& index : indices) {
+        if (remap[index] == No_Vertex) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    Vertices result(next);
+    for_size (v, vertices) {
+        if (remap[v] != No_Vertex) {
+            result[remap[v]] = vertices[v];
+        }
+    }
+    vertices = std::move(result);
+}
+
+Mesh_Optimizer::Report Mesh_Optimizer::Optimize(Mesh& mesh)
+{
+    Report report{};
+    report.before = report.after = Analyze_Vertex_Cache(mesh.indices, mesh.vertices.size());
+
+    // points & lines, already converted meshes or ones with levels of detail
+    if (mesh.layout != Mesh::interleaved || mesh.indices.size() % 3 != 0 || !mesh.lods.empty()) {
+        return report;
+    }
+
+    Optimize_Vertex_Cache(mesh.indices, mesh.vertices.size());
+    Optimize_Overdraw(mesh.indices, mesh.vertices);
+    Optimize_Vertex_Fetch(mesh.vertices, mesh.indices);
+
+    report.after = Analyze_Vertex_Cache(mesh.indices, mesh.vertices.size());
+    return report;
+}
+
+Meshes Mesh_Optimizer::Split_Mesh(Mesh&& mesh, std::size_t max_vertices, std::vector<std::vector<bool>>* cut_vertices)
+{
+    Meshes pieces{};
+    if (mesh.vertex_count() <= max_vertices || mesh.layout != Mesh::interleaved || mesh.indices.size() % 3 != 0 || !mesh.lods.empty() || max_vertices < 3) {
+        pieces.push_back(std::move(mesh));
+        if (cut_vertices) {
+            cut_vertices->emplace_back();
+        }
+        return pieces;
+    }
+
+    measure_time();
+
+    // the triangles are already in cache & overdraw order, cutting that order into runs keeps both
+    // and the vertices of a piece come out in the order of their first use
+    std::vector<uint>              remap(mesh.vertices.size(), No_Vertex);
+    std::vector<uint>              used{};                                // the original vertices of the current piece
+    std::vector<uint>              piece_count(mesh.vertices.size(), 0); // how many pieces use each original vertex
+    std::vector<std::vector<uint>> originals{};                           // the original vertices of every piece
+    Mesh piece{};
+    for (std::size_t i = 0; i < mesh.indices.size(); i += 3) {
+        uint const* corners = &mesh.indices[i];
+
+        std::size_t new_vertices = 0;
+        for (std::size_t c = 0; c < 3; ++c) {
+            bool const repeated = (c > 0 && corners[c] == corners[0]) || (c > 1 && corners[c] == corners[1]);
+            new_vertices += remap[corners[c]] == No_Vertex && !repeated;
+        }
+        if (piece.vertices.size() + new_vertices > max_vertices) {
+            // only the vertices of this piece are mapped, so only those have to be reset
+            for (uint const vertex : used) {
+                remap[vertex] = No_Vertex;
+            }
+            originals.push_back(std::move(used));
+            used.clear();
+            pieces.push_back(std::move(piece));
+            piece = Mesh{};
+        }
+
+        for (std::size_t c = 0; c < 3; ++c) {
+            uint& local = remap[corners[c]];
+            if (local == No_Vertex) {
+                local = uint(piece.vertices.size());
+                piece.vertices.push_back(mesh.vertices[corners[c]]);
+                used.push_back(corners[c]);
+                ++piece_count[corners[c]];
+            }
+            piece.indices.push_back(local);
+        }
+    }
+    originals.push_back(std::move(used));
+    pieces.push_back(std::move(piece));
+
+    for_size (n, pieces) {
+        pieces[n].textures = mesh.textures;
+        if (cut_vertices) {
+            std::vector<bool>& cut = cut_vertices->emplace_back(pieces[n].vertices.size(), false);
+            for_size (local, originals[n]) {
+                cut[local] = piece_count[originals[n][local]] > 1;
+            }
+        }
+    }
+    return pieces;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+// --------------------------------------------------
+// import time index & vertex reordering for the gpu:
+//   1. vertex cache: Forsyth's greedy triangle order (linear speed vertex cache optimisation)
+//   2. overdraw:     the cache friendly order is cut into clusters, outward facing clusters
+//                    are drawn first (Sander et al., fast triangle reordering)
+//   3. vertex fetch: vertices in the order of their first use, unused ones are dropped
+//   4. splitting:    meshes with too many vertices for 16 bit indices are cut into pieces
+// only the order changes, never the triangles themselves
+// --------------------------------------------------
+
+#include "Common.h"
+#include "Mesh.h"
+
+namespace Mesh_Optimizer {
+
+// the simulated post transform cache, a fifo like most hardware
+constexpr uint Fifo_Size = 16;
+
+struct Cache_Statistics {
+    float acmr = 0.0f; // average cache miss ratio: transformed vertices per triangle, 0.5 - 3
+    float atvr = 0.0f; // average transformed vertex ratio: transformed per used vertex, 1 is ideal
+};
+
+struct Report {
+    Cache_Statistics before = {};
+    Cache_Statistics after  = {};
+};
+
+Cache_Statistics Analyze_Vertex_Cache(Indices const& indices, std::size_t vertex_count, uint cache_size = Fifo_Size);
+
+void Optimize_Vertex_Cache(Indices& indices, std::size_t vertex_count);
+
+// threshold: how much worse than the cache order a cluster may get (1.05 = 5% more vertex shading)
+void Optimize_Overdraw(Indices& indices, Vertices const& vertices, float threshold = 1.05f);
+
+void Optimize_Vertex_Fetch(Vertices& vertices, Indices& indices);
+
+// all 3 steps, for interleaved triangle meshes without levels of detail (anything else is left alone)
+Report Optimize(Mesh& mesh);
+
+// consecutive runs of triangles with at most max_vertices vertices each, in the original order,
+// every piece keeps the textures. Small meshes, meshes with levels of detail & non triangle meshes stay whole.
+// cut_vertices gets one entry appended per piece: which of its vertices other pieces use as well (empty if
+// none), Mesh_Simplifier has to keep those in place or the levels of neighbouring pieces crack apart
+Meshes Split_Mesh(Mesh&& mesh, std::size_t max_vertices = Max_16_Bit_Vertices, std::vector<std::vector<bool>>* cut_vertices = nullptr);
+
+}
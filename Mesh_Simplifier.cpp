@@ -0,0 +1,467 @@
+#include "Mesh_Simplifier.h"
+#include "Mesh_Optimizer.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+constexpr uint No_Vertex = ~0u;
+
+// open borders get planes along them, so they keep their shape when they collapse
+constexpr double Border_Weight = 10.0;
+
+// an edge between vertices with different normals / tex coords costs as if the
+// surface moved by the edge length times the attribute difference
+constexpr float Attribute_Weight = 1.0f;
+
+// symmetric 4x4 of the planes, in double: sums over many planes lose too much in float
+struct Quadric {
+    double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0; // n * n^T
+    double b0  = 0.0, b1  = 0.0, b2  = 0.0;                                   // d * n
+    double c   = 0.0;                                                        // d^2
+    double weight = 0.0;
+
+    // unit normal n, plane n.p + d = 0
+    void add_plane(float3 n, double d, double w)
+    {
+        a00 += w * n.x * n.x; a01 += w * n.x * n.y; a02 += w * n.x * n.z;
+        a11 += w * n.y * n.y; a12 += w * n.y * n.z; a22 += w * n.z * n.z;
+        b0  += w * d * n.x;   b1  += w * d * n.y;   b2  += w * d * n.z;
+        c   += w * d * d;
+        weight += w;
+    }
+
+    void add(Quadric const& q)
+    {
+        a00 += q.a00; a01 += q.a01; a02 += q.a02; a11 += q.a11; a12 += q.a12; a22 += q.a22;
+        b0  += q.b0;  b1  += q.b1;  b2  += q.b2;
+        c   += q.c;
+        weight += q.weight;
+    }
+
+    // weighted mean of the squared distances to the planes
+    double error(float3 p) const
+    {
+        double const x = p.x, y = p.y, z = p.z;
+        double const sum =
+            a00 * x * x + a11 * y * y + a22 * z * z +
+            2.0 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+            2.0 * (b0 * x + b1 * y + b2 * z) + c;
+        return weight > 0.0 ? std::max(sum, 0.0) / weight : 0.0;
+    }
+};
+
+enum Kind : u8 {
+    manifold, // collapses into any neighbour
+    border,   // on one open border, collapses only along it
+    locked    // seams, corners of several borders
+};
+
+// the half edges of the original triangles, grouped by their start vertex
+struct Edges {
+    std::vector<uint> first;   // vertex_count + 1
+    std::vector<uint> targets;
+
+    Edges(Indices const& indices, std::size_t vertex_count) : first(vertex_count + 1, 0), targets(indices.size())
+    {
+        for (uint index : indices) {
+            ++first[index + 1];
+        }
+        std::partial_sum(first.begin(), first.end(), first.begin());
+
+        std::vector<uint> filled(vertex_count, 0);
+        for (std::size_t t = 0; t < indices.size(); t += 3) {
+            for (int c = 0; c < 3; ++c) {
+                uint const a = indices[t + c];
+                uint const b = indices[t + (c + 1) % 3];
+                targets[first[a] + filled[a]++] = b;
+            }
+        }
+    }
+
+    bool has(uint a, uint b) const
+    {
+        return std::find(targets.begin() + first[a], targets.begin() + first[a + 1], b) != targets.begin() + first[a + 1];
+    }
+};
+
+struct Position_Hash {
+    std::size_t operator()(float3 const& p) const
+    {
+        u32 bits[3];
+        std::memcpy(bits, p.data, sizeof(bits));
+        return (bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u);
+    }
+};
+
+struct Position_Equal {
+    bool operator()(float3 const& a, float3 const& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+};
+
+struct Topology {
+    std::vector<Kind> kinds;
+    std::vector<uint> border_next; // along the open border, in triangle winding
+    std::vector<uint> border_prev;
+};
+
+Topology Classify_Vertices(Vertices const& vertices, Indices const& indices, std::vector<bool> const& locked_vertices)
+{
+    std::size_t const vertex_count = vertices.size();
+    Edges const edges{ indices, vertex_count };
+
+    Topology topology{};
+    topology.kinds.assign(vertex_count, manifold);
+    topology.border_next.assign(vertex_count, No_Vertex);
+    topology.border_prev.assign(vertex_count, No_Vertex);
+
+    // an edge without its opposite is open
+    std::vector<u8> open_out(vertex_count, 0);
+    std::vector<u8> open_in(vertex_count, 0);
+    for (uint a = 0; a < vertex_count; ++a) {
+        for (uint e = edges.first[a]; e < edges.first[a + 1]; ++e) {
+            uint const b = edges.targets[e];
+            if (!edges.has(b, a)) {
+                open_out[a] = u8(std::min(open_out[a] + 1, 255));
+                open_in[b]  = u8(std::min(open_in[b] + 1, 255));
+                topology.border_next[a] = b;
+                topology.border_prev[b] = a;
+            }
+        }
+    }
+
+    // vertices that share a position are seams, moving one side alone would tear a hole
+    std::unordered_map<float3, uint, Position_Hash, Position_Equal> positions{};
+    positions.reserve(vertex_count);
+    std::vector<bool> seam(vertex_count, false);
+    for (uint v = 0; v < vertex_count; ++v) {
+        auto const [it, inserted] = positions.emplace(vertices[v].position, v);
+        if (!inserted) {
+            seam[v] = seam[it->second] = true;
+        }
+    }
+
+    for (uint v = 0; v < vertex_count; ++v) {
+        if (seam[v] || (!locked_vertices.empty() && locked_vertices[v])) {
+            topology.kinds[v] = locked;
+        }
+        else if (open_out[v] == 1 && open_in[v] == 1) {
+            topology.kinds[v] = border;
+        }
+        else if (open_out[v] != 0 || open_in[v] != 0) {
+            topology.kinds[v] = locked;
+        }
+    }
+    return topology;
+}
+
+std::vector<Quadric> Make_Quadrics(Vertices const& vertices, Indices const& indices, Topology const& topology)
+{
+    std::vector<Quadric> quadrics(vertices.size());
+    for (std::size_t t = 0; t < indices.size(); t += 3) {
+        uint const   corners[3] = { indices[t], indices[t + 1], indices[t + 2] };
+        float3 const p0 = vertices[corners[0]].position;
+        float3 const p1 = vertices[corners[1]].position;
+        float3 const p2 = vertices[corners[2]].position;
+
+        float3 normal = cross_product(p1 - p0, p2 - p0);
+        float const twice_area = length(normal);
+        if (twice_area == 0.0f) {
+            continue;
+        }
+        normal = normal / twice_area;
+
+        double const d = -dot_product(normal, p0);
+        for (uint corner : corners) {
+            quadrics[corner].add_plane(normal, d, 0.5 * twice_area);
+        }
+
+        // a plane through every open edge, perpendicular to the triangle
+        for (int c = 0; c < 3; ++c) {
+            uint const a = corners[c];
+            uint const b = corners[(c + 1) % 3];
+            if (topology.border_next[a] != b) {
+                continue;
+            }
+
+            float3 const edge = vertices[b].position - vertices[a].position;
+            float3 side = cross_product(edge, normal);
+            float const side_length = length(side);
+            if (side_length == 0.0f) {
+                continue;
+            }
+            side = side / side_length;
+
+            double const side_d = -dot_product(side, vertices[a].position);
+            double const weight = Border_Weight * squared_length(edge);
+            quadrics[a].add_plane(side, side_d, weight);
+            quadrics[b].add_plane(side, side_d, weight);
+        }
+    }
+    return quadrics;
+}
+
+bool Can_Collapse(Topology const& topology, uint from, uint to)
+{
+    switch (topology.kinds[from]) {
+    case manifold: return true;
+    case border:   return topology.border_next[from] == to || topology.border_prev[from] == to;
+    default:       return false;
+    }
+}
+
+float Collapse_Cost(Vertices const& vertices, std::vector<Quadric> const& quadrics, uint from, uint to)
+{
+    Vertex const& a = vertices[from];
+    Vertex const& b = vertices[to];
+
+    float const attributes = squared_length(a.normal - b.normal) * 0.25f + squared_length(a.tex_coord - b.tex_coord);
+    return float(quadrics[from].error(b.position)) + Attribute_Weight * attributes * squared_length(a.position - b.position);
+}
+
+// moving from to the position of to must not turn any of its other triangles around
+bool Flips(Vertices const& vertices, Indices const& indices, const uint* triangles, uint triangle_count, uint from, uint to)
+{
+    float3 const target = vertices[to].position;
+    for (uint n = 0; n < triangle_count; ++n) {
+        const uint* corners = &indices[std::size_t(triangles[n]) * 3];
+        if (corners[0] == to || corners[1] == to || corners[2] == to) {
+            continue; // collapses to nothing
+        }
+
+        float3 before[3], after[3];
+        for (int c = 0; c < 3; ++c) {
+            before[c] = vertices[corners[c]].position;
+            after[c]  = corners[c] == from ? target : before[c];
+        }
+        float3 const normal_before = cross_product(before[1] - before[0], before[2] - before[0]);
+        float3 const normal_after  = cross_product(after[1] - after[0], after[2] - after[0]);
+        if (dot_product(normal_before, normal_after) <= 0.0f) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#pragma endregion
+
+Mesh_Simplifier::Sphere Mesh_Simplifier::Bounding_Sphere(Vertices const& vertices)
+{
+    Sphere sphere{};
+    if (vertices.empty()) {
+        return sphere;
+    }
+
+    float3 low{ FLT_MAX, FLT_MAX, FLT_MAX };
+    float3 high{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (Vertex const& v : vertices) {
+        for (int c = 0; c < 3; ++c) {
+            low.data[c]  = std::min(low.data[c], v.position.data[c]);
+            high.data[c] = std::max(high.data[c], v.position.data[c]);
+        }
+    }
+    sphere.center = (low + high) * 0.5f;
+
+    float squared_radius = 0.0f;
+    for (Vertex const& v : vertices) {
+        squared_radius = std::max(squared_radius, squared_length(v.position - sphere.center));
+    }
+    sphere.radius = std::sqrt(squared_radius);
+    return sphere;
+}
+
+Indices Mesh_Simplifier::Simplify(Vertices const& vertices, Indices const& indices, std::size_t target_index_count, float target_error, float* result_error,
+                                  std::vector<bool> const& locked_vertices)
+{
+    measure_time();
+
+    assert(indices.size() % 3 == 0);
+    assert(locked_vertices.empty() || locked_vertices.size() == vertices.size());
+    std::size_t const vertex_count = vertices.size();
+
+    float const radius      = Bounding_Sphere(vertices).radius;
+    float const error_limit = (target_error * radius) * (target_error * radius);
+    float       max_cost    = 0.0f;
+
+    Topology             topology = Classify_Vertices(vertices, indices, locked_vertices);
+    std::vector<Quadric> quadrics = Make_Quadrics(vertices, indices, topology);
+
+    Indices result = indices;
+
+    std::vector<uint>  remap(vertex_count);
+    std::vector<uint>  best_target(vertex_count);
+    std::vector<float> best_cost(vertex_count);
+    std::vector<bool>  touched(vertex_count);
+    std::vector<uint>  candidates{};
+
+    std::vector<uint> first_triangle(vertex_count + 1);
+    std::vector<uint> triangles{};
+
+    while (result.size() > target_index_count) {
+        // the triangles around every vertex
+        std::fill(first_triangle.begin(), first_triangle.end(), 0);
+        for (uint index : result) {
+            ++first_triangle[index + 1];
+        }
+        std::partial_sum(first_triangle.begin(), first_triangle.end(), first_triangle.begin());
+        triangles.resize(result.size());
+        {
+            std::vector<uint> filled(first_triangle.begin(), first_triangle.end() - 1);
+            for (std::size_t n = 0; n < result.size(); ++n) {
+                triangles[filled[result[n]]++] = uint(n / 3);
+            }
+        }
+
+        // the cheapest allowed collapse of every vertex
+        std::fill(best_target.begin(), best_target.end(), No_Vertex);
+        std::fill(best_cost.begin(), best_cost.end(), FLT_MAX);
+        for (std::size_t t = 0; t < result.size(); t += 3) {
+            for (int c = 0; c < 3; ++c) {
+                uint const edge[2] = { result[t + c], result[t + (c + 1) % 3] };
+                for (int direction = 0; direction < 2; ++direction) {
+                    uint const from = edge[direction];
+                    uint const to   = edge[1 - direction];
+                    if (!Can_Collapse(topology, from, to)) {
+                        continue;
+                    }
+                    float const cost = Collapse_Cost(vertices, quadrics, from, to);
+                    if (cost < best_cost[from]) {
+                        best_cost[from]   = cost;
+                        best_target[from] = to;
+                    }
+                }
+            }
+        }
+
+        candidates.clear();
+        for (uint v = 0; v < vertex_count; ++v) {
+            if (best_target[v] != No_Vertex && best_cost[v] <= error_limit) {
+                candidates.push_back(v);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [&](uint a, uint b) { return best_cost[a] < best_cost[b]; });
+
+        // cheapest first, a vertex and its neighbours take part in only one collapse per pass
+        std::iota(remap.begin(), remap.end(), 0u);
+        std::fill(touched.begin(), touched.end(), false);
+
+        std::size_t const needed_triangles  = (result.size() - target_index_count + 2) / 3;
+        std::size_t       removed_triangles = 0;
+        std::size_t       collapses         = 0;
+
+        for (uint from : candidates) {
+            if (removed_triangles >= needed_triangles) {
+                break;
+            }
+            uint const to = best_target[from];
+            if (touched[from] || touched[to]) {
+                continue;
+            }
+
+            const uint* around = &triangles[first_triangle[from]];
+            uint const  count  = first_triangle[from + 1] - first_triangle[from];
+            if (Flips(vertices, result, around, count, from, to)) {
+                continue;
+            }
+
+            remap[from] = to;
+            quadrics[to].add(quadrics[from]);
+            max_cost = std::max(max_cost, best_cost[from]);
+            ++collapses;
+
+            for (uint n = 0; n < count; ++n) {
+                const uint* corners = &result[std::size_t(around[n]) * 3];
+                removed_triangles += corners[0] == to || corners[1] == to || corners[2] == to;
+                touched[corners[0]] = touched[corners[1]] = touched[corners[2]] = true;
+            }
+
+            // the border goes around the removed vertex now
+            if (topology.kinds[from] == border) {
+                uint const prev = topology.border_prev[from];
+                uint const next = topology.border_next[from];
+                if (to == next) {
+                    topology.border_next[prev] = to;
+                    topology.border_prev[to]   = prev;
+                }
+                else {
+                    topology.border_prev[next] = to;
+                    topology.border_next[to]   = next;
+                }
+            }
+        }
+
+        if (collapses == 0) {
+            break;
+        }
+
+        // apply and drop the triangles that collapsed to a line
+        std::size_t kept = 0;
+        for (std::size_t t = 0; t < result.size(); t += 3) {
+            uint const a = remap[result[t]];
+            uint const b = remap[result[t + 1]];
+            uint const c = remap[result[t + 2]];
+            if (a == b || b == c || c == a) {
+                continue;
+            }
+            result[kept++] = a;
+            result[kept++] = b;
+            result[kept++] = c;
+        }
+        result.resize(kept);
+    }
+
+    if (result_error) {
+        *result_error = radius > 0.0f ? std::sqrt(max_cost) / radius : 0.0f;
+    }
+    return result;
+}
+
+void Mesh_Simplifier::Build_Lods(Mesh& mesh, uint max_lods, float max_error, std::vector<bool> const& locked_vertices)
+{
+    measure_time();
+
+    assert(mesh.layout == Mesh::interleaved && mesh.lods.empty());
+
+    Sphere const sphere  = Bounding_Sphere(mesh.vertices);
+    mesh.bounding_center = sphere.center;
+    mesh.bounding_radius = sphere.radius;
+
+    if (mesh.indices.empty() || mesh.indices.size() % 3 != 0) {
+        return;
+    }
+
+    mesh.lods.push_back({ 0, u32(mesh.indices.size()), 0.0f });
+
+    // every level starts from the one before, so the errors add up
+    Indices level = mesh.indices;
+    float   error = 0.0f;
+    while (mesh.lods.size() < max_lods) {
+        float       level_error = 0.0f;
+        std::size_t target      = level.size() / 6 * 3;
+        Indices     next        = Simplify(mesh.vertices, level, target, max_error - error, &level_error, locked_vertices);
+
+        // less than a quarter gone: the error limit or the locked vertices stop it, more levels would look the same
+        if (next.empty() || next.size() > level.size() * 3 / 4) {
+            break;
+        }
+
+        Mesh_Optimizer::Optimize_Vertex_Cache(next, mesh.vertices.size());
+        error += level_error;
+        mesh.lods.push_back({ u32(mesh.indices.size()), u32(next.size()), error });
+        mesh.indices.insert(mesh.indices.end(), next.begin(), next.end());
+        level = std::move(next);
+    }
+
+    // only the full detail, no need for a table
+    if (mesh.lods.size() == 1) {
+        mesh.lods.clear();
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+// --------------------------------------------------
+// quadric error edge collapse (Garland & Heckbert) for the level of detail chain.
+// vertices only ever collapse into a neighbour, so every level indexes into the
+// original vertex array. open borders only move along themselves, uv & normal seams
+// (vertices that share a position) never move, and the attribute difference along
+// an edge is part of its cost
+// --------------------------------------------------
+
+#include "Common.h"
+#include "Mesh.h"
+
+namespace Mesh_Simplifier {
+
+// levels per mesh, including the full detail one
+constexpr uint Max_Lods = 5;
+
+// how far the surface of the coarsest level may move, relative to the bounding radius
+constexpr float Max_Error = 0.05f;
+
+struct Sphere {
+    float3 center = {};
+    float  radius = 0.0f;
+};
+
+// center of the bounding box, radius to the farthest vertex
+Sphere Bounding_Sphere(Vertices const& vertices);
+
+// collapses edges until at most target_index_count indices are left or the next collapse would
+// move the surface further than target_error (relative to the bounding radius).
+// result_error: the largest error of the collapses that were done, relative to the bounding radius.
+// locked_vertices: empty or one flag per vertex, flagged ones never move (the cuts of Split_Mesh)
+Indices Simplify(Vertices const& vertices, Indices const& indices, std::size_t target_index_count, float target_error, float* result_error = nullptr,
+                 std::vector<bool> const& locked_vertices = {});
+
+// appends levels with about half the triangles of the one before (at most max_lods in total),
+// until the error limit or no more progress. the full detail indices stay at the front
+void Build_Lods(Mesh& mesh, uint max_lods = Max_Lods, float max_error = Max_Error, std::vector<bool> const& locked_vertices = {});
+
+}
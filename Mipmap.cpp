@@ -0,0 +1,327 @@
+#include "Mipmap.h"
+#include "Cpu.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined(CPU_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+constexpr int Max_Taps = 8;
+constexpr int Padding  = 4; // replicated border pixels on both sides of a decoded row
+
+// weights of the source pixels 2x + first ... 2x + first + taps - 1 for the target pixel x,
+// the same in both directions
+struct Kernel {
+    int   first = 0;
+    int   taps  = 0;
+    float weights[Max_Taps] = {};
+};
+
+// modified bessel function of the first kind, order 0
+double Bessel_I0(double x)
+{
+    double sum = 1.0, term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+Kernel Make_Kernel(Mipmap::Filter filter)
+{
+    Kernel kernel{};
+    if (filter == Mipmap::box) {
+        kernel.first = 0;
+        kernel.taps  = 2;
+        kernel.weights[0] = kernel.weights[1] = 0.5f;
+        return kernel;
+    }
+
+    // sinc with the cutoff of the target resolution, windowed over 2 target pixels to each side
+    constexpr double Pi     = 3.14159265358979323846;
+    constexpr double Alpha  = 4.0;
+    constexpr double Radius = 2.0;
+
+    kernel.first = -3;
+    kernel.taps  = 8;
+
+    double weights[Max_Taps];
+    double sum = 0.0;
+    for (int k = 0; k < kernel.taps; ++k) {
+        double const distance = (kernel.first + k + 0.5 - 1.0) / 2.0; // in target pixels, the center lies between 2x and 2x + 1
+        double const sinc     = std::sin(Pi * distance) / (Pi * distance);
+        double const ratio    = distance / Radius;
+        double const window   = Bessel_I0(Alpha * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / Bessel_I0(Alpha);
+        weights[k] = sinc * window;
+        sum += weights[k];
+    }
+    for (int k = 0; k < kernel.taps; ++k) {
+        kernel.weights[k] = float(weights[k] / sum);
+    }
+    return kernel;
+}
+
+// srgb <-> linear, the encode table is fine enough to round to the nearest 8 bit value
+struct Conversion_Tables {
+    static constexpr int Steps = 1 << 16;
+
+    float srgb_to_linear[256];
+    float unorm_to_float[256];
+    uchar linear_to_srgb[Steps + 1];
+
+    Conversion_Tables()
+    {
+        for (int n = 0; n < 256; ++n) {
+            double const value = n / 255.0;
+            srgb_to_linear[n] = float(value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4));
+            unorm_to_float[n] = float(value);
+        }
+        for (int n = 0; n <= Steps; ++n) {
+            double const value = double(n) / Steps;
+            double const srgb  = value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055;
+            linear_to_srgb[n] = uchar(std::lround(srgb * 255.0));
+        }
+    }
+};
+
+Conversion_Tables const& Tables()
+{
+    static Conversion_Tables const tables{};
+    return tables;
+}
+
+// one row into padded rgba floats, unused channels are 0
+void Decode_Row(const uchar* in, int width, int channels, bool srgb, float* out)
+{
+    Conversion_Tables const& tables = Tables();
+
+    float* row = out + Padding * 4;
+    for (int c = 0; c < 4; ++c) {
+        if (c >= channels) {
+            for (int x = 0; x < width; ++x) { row[x * 4 + c] = 0.0f; }
+            continue;
+        }
+        const float* table = srgb && c < 3 ? tables.srgb_to_linear : tables.unorm_to_float;
+        for (int x = 0; x < width; ++x) {
+            row[x * 4 + c] = table[in[x * channels + c]];
+        }
+    }
+
+    for (int n = 0; n < Padding; ++n) {
+        std::copy(row, row + 4, out + n * 4);
+        std::copy(row + (width - 1) * 4, row + width * 4, row + (width + n) * 4);
+    }
+}
+
+void Encode_Row(const float* in, int width, int channels, bool srgb, uchar* out)
+{
+    Conversion_Tables const& tables = Tables();
+
+    // the kaiser lobes can over/undershoot, so everything is clamped
+    for (int c = 0; c < channels; ++c) {
+        if (srgb && c < 3) {
+            for (int x = 0; x < width; ++x) {
+                float const value = std::min(std::max(in[x * 4 + c], 0.0f), 1.0f);
+                out[x * channels + c] = tables.linear_to_srgb[int(value * Conversion_Tables::Steps + 0.5f)];
+            }
+        }
+        else {
+            for (int x = 0; x < width; ++x) {
+                float const value = std::min(std::max(in[x * 4 + c], 0.0f), 1.0f);
+                out[x * channels + c] = uchar(value * 255.0f + 0.5f);
+            }
+        }
+    }
+}
+
+// ---------------------------------------------
+// filter kernels, one version per instruction set.
+// all of them sum in the same order, so they give bit identical results
+// ---------------------------------------------
+
+// horizontal: a padded decoded row into target_width rgba pixels
+using Filter_Row = void (*)(const float* in, int target_width, Kernel const& kernel, float* out);
+
+// vertical: weighted sum of kernel.taps rows, count floats each
+using Blend_Rows = void (*)(const float* const* rows, int count, Kernel const& kernel, float* out);
+
+void Filter_Row_Scalar(const float* in, int target_width, Kernel const& kernel, float* out)
+{
+    for (int x = 0; x < target_width; ++x) {
+        const float* source = in + (Padding + 2 * x + kernel.first) * 4;
+        for (int c = 0; c < 4; ++c) {
+            float sum = 0.0f;
+            for (int k = 0; k < kernel.taps; ++k) {
+                sum = sum + kernel.weights[k] * source[k * 4 + c];
+            }
+            out[x * 4 + c] = sum;
+        }
+    }
+}
+
+void Blend_Rows_Scalar(const float* const* rows, int count, Kernel const& kernel, float* out)
+{
+    for (int n = 0; n < count; ++n) {
+        float sum = 0.0f;
+        for (int k = 0; k < kernel.taps; ++k) {
+            sum = sum + kernel.weights[k] * rows[k][n];
+        }
+        out[n] = sum;
+    }
+}
+
+#if defined(CPU_SSE2)
+// one rgba pixel per register
+void Filter_Row_SSE2(const float* in, int target_width, Kernel const& kernel, float* out)
+{
+    for (int x = 0; x < target_width; ++x) {
+        const float* source = in + (Padding + 2 * x + kernel.first) * 4;
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < kernel.taps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[k]), _mm_loadu_ps(source + k * 4)));
+        }
+        _mm_storeu_ps(out + x * 4, sum);
+    }
+}
+
+// count is always a multiple of 4 (whole rgba pixels)
+void Blend_Rows_SSE2(const float* const* rows, int count, Kernel const& kernel, float* out)
+{
+    for (int n = 0; n < count; n += 4) {
+        __m128 sum = _mm_setzero_ps();
+        for (int k = 0; k < kernel.taps; ++k) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(kernel.weights[k]), _mm_loadu_ps(rows[k] + n)));
+        }
+        _mm_storeu_ps(out + n, sum);
+    }
+}
+#endif
+
+#if defined(CPU_X86)
+// two rgba pixels per register, the sources of neighboring target pixels are 2 pixels apart
+TARGET_AVX2 void Filter_Row_AVX2(const float* in, int target_width, Kernel const& kernel, float* out)
+{
+    int x = 0;
+    for (; x + 2 <= target_width; x += 2) {
+        const float* source = in + (Padding + 2 * x + kernel.first) * 4;
+        __m256 sum = _mm256_setzero_ps();
+        for (int k = 0; k < kernel.taps; ++k) {
+            __m256 const pixels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(source + k * 4)), _mm_loadu_ps(source + k * 4 + 8), 1);
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel.weights[k]), pixels));
+        }
+        _mm256_storeu_ps(out + x * 4, sum);
+    }
+    if (x < target_width) {
+        Filter_Row_SSE2(in + 2 * x * 4, 1, kernel, out + x * 4);
+    }
+}
+
+TARGET_AVX2 void Blend_Rows_AVX2(const float* const* rows, int count, Kernel const& kernel, float* out)
+{
+    int n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m256 sum = _mm256_setzero_ps();
+        for (int k = 0; k < kernel.taps; ++k) {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_set1_ps(kernel.weights[k]), _mm256_loadu_ps(rows[k] + n)));
+        }
+        _mm256_storeu_ps(out + n, sum);
+    }
+    if (n < count) {
+        const float* rest[Max_Taps];
+        for (int k = 0; k < kernel.taps; ++k) { rest[k] = rows[k] + n; }
+        Blend_Rows_SSE2(rest, count - n, kernel, out + n);
+    }
+}
+#endif
+
+struct Filter_Functions {
+    Filter_Row filter_row = Filter_Row_Scalar;
+    Blend_Rows blend_rows = Blend_Rows_Scalar;
+};
+
+Filter_Functions Select_Functions(Mipmap::Path path)
+{
+    if (path == Mipmap::scalar) {
+        return {};
+    }
+#if defined(CPU_X86) && defined(CPU_SSE2)
+    if (path != Mipmap::sse2 && Get_Cpu_Features().avx2) {
+        return { Filter_Row_AVX2, Blend_Rows_AVX2 };
+    }
+#endif
+#if defined(CPU_SSE2)
+    return { Filter_Row_SSE2, Blend_Rows_SSE2 };
+#else
+    return {};
+#endif
+}
+
+// separable: every source row is filtered horizontally once and kept in a small ring,
+// the rows of one target row are always inside a window of Max_Taps source rows
+Mipmap::Level Downsample(const uchar* pixels, int width, int height, int channels, bool srgb, Kernel const& kernel, Filter_Functions const& functions)
+{
+    Mipmap::Level level{};
+    level.width  = std::max(1, width / 2);
+    level.height = std::max(1, height / 2);
+    level.pixels.resize(std::size_t(level.width) * level.height * channels);
+
+    std::size_t const row_floats = std::size_t(level.width) * 4;
+
+    std::vector<float> decoded((width + 2 * Padding) * 4);
+    std::vector<float> filtered(Max_Taps * row_floats);
+    std::vector<float> blended(row_floats);
+    int filtered_row[Max_Taps];
+    std::fill(filtered_row, filtered_row + Max_Taps, -1);
+
+    for (int y = 0; y < level.height; ++y) {
+        const float* rows[Max_Taps];
+        for (int k = 0; k < kernel.taps; ++k) {
+            int const source_row = std::clamp(2 * y + kernel.first + k, 0, height - 1);
+            int const slot       = source_row % Max_Taps;
+            if (filtered_row[slot] != source_row) {
+                Decode_Row(pixels + std::size_t(source_row) * width * channels, width, channels, srgb, decoded.data());
+                functions.filter_row(decoded.data(), level.width, kernel, filtered.data() + slot * row_floats);
+                filtered_row[slot] = source_row;
+            }
+            rows[k] = filtered.data() + slot * row_floats;
+        }
+
+        functions.blend_rows(rows, int(row_floats), kernel, blended.data());
+        Encode_Row(blended.data(), level.width, channels, srgb, level.pixels.data() + std::size_t(y) * level.width * channels);
+    }
+
+    return level;
+}
+
+#pragma endregion
+
+std::vector<Mipmap::Level> Mipmap::Generate(const uchar* pixels, int width, int height, int channels, bool gamma, Filter filter, Path path)
+{
+    measure_time();
+    assert(pixels != nullptr && width > 0 && height > 0 && channels >= 1 && channels <= 4);
+
+    Kernel const           kernel    = Make_Kernel(filter);
+    Filter_Functions const functions = Select_Functions(path);
+    bool const             srgb      = gamma && channels >= 3;
+
+    std::vector<Level> levels{};
+    while (width > 1 || height > 1) {
+        levels.push_back(Downsample(pixels, width, height, channels, srgb, kernel, functions));
+        pixels = levels.back().pixels.data();
+        width  = levels.back().width;
+        height = levels.back().height;
+    }
+    return levels;
+}
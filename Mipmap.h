@@ -0,0 +1,37 @@
+#pragma once
+
+#include "Common.h"
+
+#include <vector>
+
+// --------------------------------------------------
+// cpu mip chain generation, so neither the asset bake nor the streamer
+// depend on glGenerateMipmap. the filters work in linear light: srgb
+// color channels are decoded before filtering and encoded again after,
+// alpha is always linear. every level is made from the one above it.
+// --------------------------------------------------
+namespace Mipmap {
+
+enum Filter : u32 {
+    box,    // 2x2 average, cheap
+    kaiser  // 8x8 kaiser windowed sinc, sharper and without aliasing
+};
+
+enum Path : u32 {
+    best,   // the widest simd instruction set of this cpu
+    scalar, // reference implementation
+    sse2,   // this instruction set or the next narrower one the cpu has,
+    avx2    // to compare the paths against each other
+};
+
+struct Level {
+    Bytes pixels = {}; // same channel count as the source, rows without padding
+    int   width  = 0;
+    int   height = 0;
+};
+
+// the levels below the given image, down to 1x1 (empty for a 1x1 image).
+// gamma: the color channels of 3 and 4 channel images are srgb
+std::vector<Level> Generate(const uchar* pixels, int width, int height, int channels, bool gamma, Filter filter = box, Path path = best);
+
+}
@@ -1,242 +1,73 @@
 #include "Model.h"
+#include "Graphics.h"
+#include "Mesh_Cache.h"
+#include "Mesh_Optimizer.h"
+#include "Mesh_Simplifier.h"
+#include "Parallel.h"
 #include "Profiling.h"
+#include "Texture_Manager.h"
 
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
-#include <glad/glad.h>
-#include <stb/stb_image.h>
-
-#include <fstream>
 #include <string>
-#include <sstream>
 #include <array>
 #include <set>
+#include <cstring>
+#include <optional>
 
-using Tokens = std::vector<std::string>;
-using Triplet   = std::array<int, 3>;
-
-constexpr std::size_t V  = 0;
-constexpr std::size_t UV = 1;
-constexpr std::size_t VT = 2;
-
-Tokens split(std::string text, char const delimiter)
-{
-    std::stringstream ss { text };
-    std::vector<std::string> tokens {};
-
-    for (std::string token{}; std::getline(ss, token, delimiter);/**/) {
-        if (token.empty()) {
-            return {};
-        }
-        tokens.push_back(token);
-    }
-
-    return std::move(tokens);
-}
-
-float3 to_vec3(Tokens const& tokens)
-{
-    assert(tokens.size() == 4);
-    float const x = std::stof(tokens[1].c_str());
-    float const y = std::stof(tokens[2].c_str());
-    float const z = std::stof(tokens[3].c_str());
-    return { x, y, z };
-}
-
-float2 to_vec2(Tokens const& tokens)
-{
-    assert(tokens.size() == 3);
-    float const x = std::stof(tokens[1].c_str());
-    float const y = std::stof(tokens[2].c_str());
-    return { x, y };
-}
-
-Triplet to_triplet(std::string line)
-{
-    auto tokens = split(line, '/');
-    assert(tokens.size() == 3);
-    return {
-        std::atoi(tokens[0].c_str()),
-        std::atoi(tokens[1].c_str()),
-        std::atoi(tokens[2].c_str())
-    };
-}
-
-
-OBJ Load_OBJ(const char* file_name)
-{
-    measure_time();
-
-    std::ifstream file{ file_name };
-    assert(file.is_open());
-
-    // obj format uses indices to address positions, normals etc.
-    // this way the information can be reduced...
-    // example: a cube with 36 vertices can be saved with only 8 vertices (because of the overlapp @ the corners!)
-    Indices v_i, uv_i, vt_i;
-    std::vector<float3> temp_vertices, temp_normals;
-    std::vector<float2> temp_tex;
-
-    for (std::string line{}; std::getline(file, line);/**/) {
-
-        if (line.empty()) { continue; }
-
-        Tokens      const tokens = split(line, ' ');
-        std::string const type{ tokens[0] };
-
-        // skip comments
-        if (type == "#") { continue; }
-
-        if (type == "v") {
-            float3 const vertex = to_vec3(tokens);
-            temp_vertices.push_back(vertex);
-            continue;
-        }
-
-        if (type == "vn") {
-            float3 const normal = to_vec3(tokens);
-            temp_normals.push_back(normal);
-            continue;
-        }
-
-        if (type == "vt") {
-            float2 const tex = to_vec2(tokens);
-            temp_tex.push_back(tex);
-            continue;
-        }
-
-        if (type == "f") {
-            // format: v/uv/vt ...
-            Triplet a = to_triplet(tokens[1]);
-            Triplet b = to_triplet(tokens[2]);
-            Triplet c = to_triplet(tokens[3]);
-
-            v_i.push_back(a[V]);
-            v_i.push_back(b[V]);
-            v_i.push_back(c[V]);
-
-            uv_i.push_back(a[UV]);
-            uv_i.push_back(b[UV]);
-            uv_i.push_back(c[UV]);
-
-            vt_i.push_back(c[VT]);
-            vt_i.push_back(c[VT]);
-            vt_i.push_back(c[VT]);
-        }
-    }
-
-    // sanity check, the triples have to add up
-    assert(v_i.size() == vt_i.size());
-    assert(v_i.size() == uv_i.size());
-
-    // process the index data and create the OBJ struct
-    OBJ obj{};
-    obj.name = file_name;
-
-    for_size (n, v_i) {
-        int    const vertex_index = v_i[n];
-        float3 const vertex = temp_vertices[vertex_index - 1]; // obj starts index with 1, c++ with 0!
-        obj.vertices.push_back(vertex);
-
-        int    const normal_index = vt_i[n];
-        float3 const normal = temp_normals[normal_index - 1]; // obj starts index with 1, c++ with 0!
-        obj.normals.push_back(normal);
-
-        int    const tex_index = uv_i[n];
-        float2 const tex_coord = temp_tex[tex_index - 1]; // obj starts index with 1, c++ with 0!
-        obj.tex_coords.push_back(tex_coord);
-    }
-
-    return obj;
-}
-
-
+// ---------------------------------------------
 // Assimp import
+// ---------------------------------------------
 
-uint Texture_From_File(char const* path, std::string const& directory, bool gamma = false)
-{
-    const std::string filename = directory + '/' + std::string{ path };
+// changing these invalidates every baked mesh (they are part of the cache key)
+constexpr u32 Import_Flags = aiProcess_Triangulate | aiProcess_FlipUVs;
 
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+// cut meshes with more than Max_16_Bit_Vertices vertices into pieces that can use 16 bit indices,
+// otherwise they keep 32 bit ones. Not part of the cache key, changing it needs a Mesh_Cache::Version bump
+constexpr bool Split_Large_Meshes = true;
 
-    int width, height, component_count;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &component_count, 0);
-    if (data) {
-        GLenum format;
-        if (component_count == 1) {
-            format = GL_RED;
-        }
-        else if (component_count == 3) {
-            format = GL_RGB;
-        }
-        else if (component_count == 4) {
-            format = GL_RGBA;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-    }
-    else {
-        std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
-    }
-
-    return textureID;
-}
-
-// the required info is returned as a Texture struct.
-Textures Load_Texture(aiMaterial *mat, aiTextureType type, Texture::Type ttype, std::string const& directory)
+// the texture references of a material, the images themselves are loaded by Load_Textures
+Textures Collect_Textures(aiMaterial *mat, aiTextureType type, Texture::Type ttype)
 {
-    static std::vector<Texture> texture_cache;
     Textures textures;
 
     for (uint i = 0; i < mat->GetTextureCount(type); i++) {
         aiString str;
         mat->GetTexture(type, i, &str);
-        // check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-        bool skip = false;
-        const std::string current_tex { str.C_Str() };
-        for (uint j = 0; j < texture_cache.size(); j++) {
-            const std::string cached_tex{ texture_cache[j].path.data() };
-            if (cached_tex == current_tex) {
-                textures.push_back(texture_cache[j]);
-                skip = true; // a texture with the same filepath has already been loaded, continue to next one. (optimization)
-                break;
-            }
-        }
-        if (!skip) {
-            // if texture hasn't been loaded already, load it
-            Texture texture;
-            texture.id = Texture_From_File(str.C_Str(), directory);
-            texture.type = ttype;
-            texture.path = str.C_Str();
-            textures.push_back(texture);
-            texture_cache.push_back(texture);  // store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-        }
+
+        Texture texture;
+        texture.id = 0; // not loaded yet
+        texture.type = ttype;
+        texture.path = str.C_Str();
+        textures.push_back(texture);
     }
     return textures;
 }
 
+// needs a gl context, the manager makes sure every image file is only loaded once
+void Load_Textures(Meshes& meshes, std::string const& directory, GL::Texture_Manager& texture_manager)
+{
+    for (Mesh& mesh : meshes) {
+        for (Texture& texture : mesh.textures) {
+            // only color is authored in srgb, specular/normal/height maps are data
+            texture.id = texture_manager.acquire(directory + '/' + texture.path, texture.type == Texture::diffuse);
+        }
+    }
+}
 
-Mesh Process_Mesh(aiMesh *mesh, aiScene const* scene, std::string const& directory)
+
+// geometry only, touches nothing but the aiMesh and the result - safe to run for many meshes in parallel
+void Process_Mesh(Mesh& result, aiMesh const* mesh)
 {
-    Vertices vertices {};
-    Indices  indices  {};
-    Textures textures {};
+    Vertices& vertices = result.vertices;
+    Indices&  indices  = result.indices;
+
+    vertices.resize(mesh->mNumVertices); // zero initialized, missing attributes stay 0,0,0
 
     for (uint i = 0; i < mesh->mNumVertices; i++) {
-        Vertex vertex {};
+        Vertex& vertex = vertices[i];
 
         // positions
         vertex.position.x = mesh->mVertices[i].x;
@@ -244,9 +75,11 @@ Mesh Process_Mesh(aiMesh *mesh, aiScene const* scene, std::string const& directo
         vertex.position.z = mesh->mVertices[i].z;
 
         // normals
-        vertex.normal.x = mesh->mNormals[i].x;
-        vertex.normal.y = mesh->mNormals[i].y;
-        vertex.normal.z = mesh->mNormals[i].z;
+        if (mesh->mNormals != nullptr) {
+            vertex.normal.x = mesh->mNormals[i].x;
+            vertex.normal.y = mesh->mNormals[i].y;
+            vertex.normal.z = mesh->mNormals[i].z;
+        }
 
         // texture coordinates
         if (mesh->mTextureCoords[0]) { // does the mesh contain texture coordinates?
@@ -255,9 +88,6 @@ Mesh Process_Mesh(aiMesh *mesh, aiScene const* scene, std::string const& directo
             vertex.tex_coord.x = mesh->mTextureCoords[0][i].x;
             vertex.tex_coord.y = mesh->mTextureCoords[0][i].y;
         }
-        else {
-            vertex.tex_coord = {};
-        }
 
         // tangent
         if (mesh->mTangents != nullptr) {
@@ -265,9 +95,6 @@ Mesh Process_Mesh(aiMesh *mesh, aiScene const* scene, std::string const& directo
             vertex.tangent.y = mesh->mTangents[i].y;
             vertex.tangent.z = mesh->mTangents[i].z;
         }
-        else {
-            vertex.tangent = {}; // default to 0,0,0
-        }
 
         // bitangent
         if (mesh->mBitangents != nullptr) {
@@ -275,22 +102,25 @@ Mesh Process_Mesh(aiMesh *mesh, aiScene const* scene, std::string const& directo
             vertex.bitangent.y = mesh->mBitangents[i].y;
             vertex.bitangent.z = mesh->mBitangents[i].z;
         }
-        else {
-            vertex.bitangent = {}; // default to 0,0,0
-        }
-
-        vertices.push_back(vertex);
     }
 
     // process indices
+    std::size_t index_count = 0;
     for (uint n = 0; n < mesh->mNumFaces; ++n) {
-        aiFace face = mesh->mFaces[n];
-        for (uint i = 0; i < face.mNumIndices; ++i) {
-            indices.push_back(face.mIndices[i]);
-        }
+        index_count += mesh->mFaces[n].mNumIndices;
+    }
+    indices.reserve(index_count);
+
+    for (uint n = 0; n < mesh->mNumFaces; ++n) {
+        aiFace const& face = mesh->mFaces[n];
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
     }
+}
+
+void Process_Material(Mesh& result, aiMesh const* mesh, aiScene const* scene)
+{
+    Textures& textures = result.textures;
 
-    // process material
     aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
     // naming convention:
     // diffuse: texture_diffuseN
@@ -298,46 +128,184 @@ Mesh Process_Mesh(aiMesh *mesh, aiScene const* scene, std::string const& directo
     // normal: texture_normalN
     // N is a number between 1 and MAX_SAMPLER_NUMBER
 
-    Textures diffuseMaps = Load_Texture(material, aiTextureType_DIFFUSE, Texture::diffuse, directory);
+    Textures diffuseMaps = Collect_Textures(material, aiTextureType_DIFFUSE, Texture::diffuse);
     textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
 
-    Textures specularMaps = Load_Texture(material, aiTextureType_SPECULAR, Texture::specular, directory);
+    Textures specularMaps = Collect_Textures(material, aiTextureType_SPECULAR, Texture::specular);
     textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
 
-    Textures normalMaps = Load_Texture(material, aiTextureType_HEIGHT, Texture::normal, directory);
+    Textures normalMaps = Collect_Textures(material, aiTextureType_HEIGHT, Texture::normal);
     textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
 
-    Textures heightMaps = Load_Texture(material, aiTextureType_AMBIENT, Texture::height, directory);
+    Textures heightMaps = Collect_Textures(material, aiTextureType_AMBIENT, Texture::height);
     textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
-    return Mesh { vertices, indices, textures };
 }
 
-void Process_Node(Meshes& meshes, aiNode* node, aiScene const* scene, std::string const& directory)
+// flatten the node tree into a list of mesh references (depth first, the order of the model file)
+void Process_Node(std::vector<aiMesh const*>& meshes, aiNode const* node, aiScene const* scene)
 {
-    // process all the node's meshes (if any)
+    // collect all the node's meshes (if any)
     for (uint n = 0; n < node->mNumMeshes; n++) {
-        aiMesh *mesh = scene->mMeshes[node->mMeshes[n]];
-        meshes.push_back(Process_Mesh(mesh, scene, directory));
+        meshes.push_back(scene->mMeshes[node->mMeshes[n]]);
     }
     // then do the same for each of its children
     for (uint n = 0; n < node->mNumChildren; n++) {
-        Process_Node(meshes, node->mChildren[n], scene, directory);
+        Process_Node(meshes, node->mChildren[n], scene);
     }
 }
 
-Generic_Model Load_Model(std::string const& path)
+// geometry and texture references of every mesh, works without a gl context
+Meshes Import_Model(std::string const& path, uint thread_count)
 {
+    measure_time();
+
     Assimp::Importer import;
-    const aiScene *scene = import.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs);
+    const aiScene *scene = import.ReadFile(path, Import_Flags);
 
     if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
         std::cerr << "ERROR::ASSIMP::" << import.GetErrorString() << '\n';
         return {};
     }
-    std::string directory = path.substr(0, path.find_last_of('/'));
 
-    Meshes meshes {};
-    Process_Node(meshes, scene->mRootNode, scene, directory);
+    std::vector<aiMesh const*> references {};
+    Process_Node(references, scene->mRootNode, scene);
+
+    // every mesh is converted into its own pre-allocated slot, the result doesn't depend on the thread count
+    Meshes meshes(references.size());
+    std::vector<Mesh_Optimizer::Report> reports(references.size());
+    Parallel_For(references.size(), thread_count, [&](std::size_t n) {
+        Process_Mesh(meshes[n], references[n]);
+        reports[n] = Mesh_Optimizer::Optimize(meshes[n]);
+    });
+
+#if defined(_DEBUG)
+    // simulated fifo cache, weighted by the triangle count of every mesh
+    Mesh_Optimizer::Report total{};
+    std::size_t triangle_count = 0;
+    for_size (n, meshes) {
+        float const triangles = float(meshes[n].indices.size() / 3);
+        total.before.acmr += reports[n].before.acmr * triangles;
+        total.after.acmr  += reports[n].after.acmr * triangles;
+        total.before.atvr += reports[n].before.atvr * triangles;
+        total.after.atvr  += reports[n].after.atvr * triangles;
+        triangle_count    += meshes[n].indices.size() / 3;
+    }
+    if (triangle_count > 0) {
+        float const scale = 1.0f / float(triangle_count);
+        std::cout << path << ": acmr " << total.before.acmr * scale << " -> " << total.after.acmr * scale
+                  << ", atvr " << total.before.atvr * scale << " -> " << total.after.atvr * scale << '\n';
+    }
+#endif
+
+    // materials are cheap, no need to spread them
+    for_size (n, references) {
+        Process_Material(meshes[n], references[n], scene);
+    }
+
+    // pieces that fit 16 bit indices, each one gets its own levels of detail. the vertices on the
+    // cuts stay in place in every level, so neighbouring pieces still meet whichever levels they draw
+    std::vector<std::vector<bool>> cut_vertices(meshes.size());
+    if (Split_Large_Meshes) {
+        Meshes pieces{};
+        cut_vertices.clear();
+        for (Mesh& mesh : meshes) {
+            for (Mesh& piece : Mesh_Optimizer::Split_Mesh(std::move(mesh), Max_16_Bit_Vertices, &cut_vertices)) {
+                pieces.push_back(std::move(piece));
+            }
+        }
+        meshes = std::move(pieces);
+    }
+
+    Parallel_For(meshes.size(), thread_count, [&](std::size_t n) {
+        Mesh_Simplifier::Build_Lods(meshes[n], Mesh_Simplifier::Max_Lods, Mesh_Simplifier::Max_Error, cut_vertices[n]);
+    });
+
     return meshes;
 }
+
+bool Is_Same_Mesh(Mesh const& a, Mesh const& b)
+{
+    if (a.vertices.size() != b.vertices.size() || a.indices != b.indices || a.textures.size() != b.textures.size()) {
+        return false;
+    }
+    if (a.lods.size() != b.lods.size() || a.bounding_center != b.bounding_center || a.bounding_radius != b.bounding_radius) {
+        return false;
+    }
+    for_size (n, a.lods) {
+        if (a.lods[n].first_index != b.lods[n].first_index || a.lods[n].index_count != b.lods[n].index_count || a.lods[n].error != b.lods[n].error) {
+            return false;
+        }
+    }
+    if (std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Vertex)) != 0) {
+        return false;
+    }
+    for_size (n, a.textures) {
+        if (a.textures[n].path != b.textures[n].path || a.textures[n].type != b.textures[n].type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+Generic_Model Load_Model(std::string const& path, GL::Texture_Manager& texture_manager, uint thread_count)
+{
+    measure_time();
+
+    std::string const directory = path.substr(0, path.find_last_of('/'));
+    std::string const cache_path = Mesh_Cache::Cache_Path(path);
+    Mesh_Cache::Key const key = Mesh_Cache::Make_Key(path, Import_Flags);
+
+    // the baked file is only used if it was made from this exact source file state
+    std::optional<Meshes> meshes = Mesh_Cache::Read(cache_path, key);
+    if (!meshes) {
+        meshes = Import_Model(path, thread_count);
+        if (!meshes->empty()) {
+            Mesh_Cache::Write(cache_path, key, *meshes);
+        }
+    }
+
+    Load_Textures(*meshes, directory, texture_manager);
+    return std::move(*meshes);
+}
+
+void Free_Model(Generic_Model& model, GL::Texture_Manager& texture_manager)
+{
+    for (Mesh& mesh : model) {
+        for (Texture const& texture : mesh.textures) {
+            texture_manager.release(texture.id);
+        }
+        GL::Free_Mesh(mesh);
+    }
+    model.clear();
+}
+
+bool Bake_Model(std::string const& path, uint thread_count)
+{
+    measure_time();
+
+    Meshes const meshes = Import_Model(path, thread_count);
+    if (meshes.empty()) {
+        return false;
+    }
+
+    std::string const cache_path = Mesh_Cache::Cache_Path(path);
+    Mesh_Cache::Key const key = Mesh_Cache::Make_Key(path, Import_Flags);
+    if (!Mesh_Cache::Write(cache_path, key, meshes)) {
+        return false;
+    }
+
+    // read the baked file back, it has to match the fresh import exactly
+    std::optional<Meshes> const baked = Mesh_Cache::Read(cache_path, key);
+    bool identical = baked.has_value() && baked->size() == meshes.size();
+    for (std::size_t n = 0; identical && n < meshes.size(); ++n) {
+        identical = Is_Same_Mesh((*baked)[n], meshes[n]);
+    }
+    if (!identical) {
+        std::cerr << "Baked meshes differ from the import of " << path << '\n';
+        assert(false);
+        return false;
+    }
+
+    std::cout << "Baked " << path << " -> " << cache_path << '\n';
+    return true;
+}
@@ -3,22 +3,23 @@
 #include "Common.h"
 #include "Vector.h"
 #include "Mesh.h"
+#include "Parallel.h"
 
 #include <vector>
 
-
-// data for OBJ format
-struct OBJ {
-    const char* name = nullptr;
-    std::vector<float3> vertices   {};   // v
-    std::vector<float3> normals    {};    // vn
-    std::vector<float2> tex_coords {}; // vt
-};
-
-OBJ Load_OBJ(const char* file_name);
-
+namespace GL { struct Texture_Manager; }
 
 
 // this model data representation should work with every format and is created/imported with Assimp
+// a baked copy (path + ".mesh") is used instead of Assimp as long as the source file is unchanged,
+// the meshes of an import are converted, reordered for the gpu and get their levels of detail
+// on up to thread_count threads (All_Cores = every hardware thread),
+// the textures are shared through the manager (and streamed in the background if it has a streamer)
 using Generic_Model = Meshes;
-Generic_Model Load_Model(std::string const& path);
\ No newline at end of file
+Generic_Model Load_Model(std::string const& path, GL::Texture_Manager& texture_manager, uint thread_count = 1);
+
+// gives the textures back to the manager and frees the gpu buffers
+void Free_Model(Generic_Model& model, GL::Texture_Manager& texture_manager);
+
+// offline step: import with Assimp and write the baked copy, doesn't need a gl context
+bool Bake_Model(std::string const& path, uint thread_count = 1);
\ No newline at end of file
@@ -0,0 +1,415 @@
+#include "OBJ.h"
+#include "File.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+constexpr std::size_t V  = 0;
+constexpr std::size_t VT = 1;
+constexpr std::size_t VN = 2;
+
+// the tokenizer works directly on the mapped file: no per line strings, streams or allocations
+inline bool Is_Space(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+inline bool Is_Digit(char c) { return c >= '0' && c <= '9'; }
+
+void Skip_Spaces(const char*& at, const char* end)
+{
+    while (at < end && Is_Space(*at)) { ++at; }
+}
+
+// moves behind the next line break
+void Skip_Line(const char*& at, const char* end)
+{
+    while (at < end && *at != '\n') { ++at; }
+    if (at < end) { ++at; }
+}
+
+// true if the line starts with the keyword followed by a space, the cursor is moved behind the keyword
+bool Read_Keyword(const char*& at, const char* end, const char* keyword)
+{
+    const char* cursor = at;
+    for (/**/; *keyword != '\0'; ++keyword, ++cursor) {
+        if (cursor == end || *cursor != *keyword) { return false; }
+    }
+    if (cursor == end || !Is_Space(*cursor)) { return false; }
+
+    at = cursor;
+    return true;
+}
+
+// fallback for everything the fast path can't handle exactly (very long mantissas, big exponents, nan, inf...)
+float Parse_Float_Slow(const char*& at, const char* end)
+{
+    std::array<char, 64> buffer = {};
+    std::size_t length = 0;
+    while (at + length < end && length + 1 < buffer.size() && !Is_Space(at[length]) && at[length] != '\n') {
+        buffer[length] = at[length];
+        ++length;
+    }
+
+    char* parsed_end = nullptr;
+    float const value = std::strtof(buffer.data(), &parsed_end);
+    at += parsed_end - buffer.data();
+    return value;
+}
+
+float Parse_Float(const char*& at, const char* end)
+{
+    // every power of ten up to 10^10 is exactly representable as a float
+    static constexpr float powers_of_ten[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+
+    Skip_Spaces(at, end);
+    const char* const start = at;
+
+    bool const negative = at < end && *at == '-';
+    if (at < end && (*at == '-' || *at == '+')) { ++at; }
+
+    u64 mantissa = 0;
+    int digits   = 0;
+    int exponent = 0;
+    for (/**/; at < end && Is_Digit(*at); ++at, ++digits) {
+        mantissa = mantissa * 10 + u64(*at - '0');
+    }
+    if (at < end && *at == '.') {
+        for (++at; at < end && Is_Digit(*at); ++at, ++digits, --exponent) {
+            mantissa = mantissa * 10 + u64(*at - '0');
+        }
+    }
+    if (at < end && (*at == 'e' || *at == 'E')) {
+        ++at;
+        bool const negative_exponent = at < end && *at == '-';
+        if (at < end && (*at == '-' || *at == '+')) { ++at; }
+
+        int value = 0;
+        for (/**/; at < end && Is_Digit(*at) && value < 10000; ++at) {
+            value = value * 10 + (*at - '0');
+        }
+        exponent += negative_exponent ? -value : value;
+    }
+
+    // fast path: mantissa and power of ten are both exact floats,
+    // so a single multiplication/division gives the correctly rounded result (same as std::stof)
+    bool const exact = digits > 0 && digits <= 19 && mantissa <= (u64(1) << 24) && exponent >= -10 && exponent <= 10;
+    if (!exact) {
+        at = start;
+        return Parse_Float_Slow(at, end);
+    }
+
+    float value = float(mantissa);
+    value = exponent < 0 ? value / powers_of_ten[-exponent] : value * powers_of_ten[exponent];
+    return negative ? -value : value;
+}
+
+int Parse_Int(const char*& at, const char* end)
+{
+    bool const negative = at < end && *at == '-';
+    if (negative) { ++at; }
+
+    int value = 0;
+    for (/**/; at < end && Is_Digit(*at); ++at) {
+        value = value * 10 + (*at - '0');
+    }
+    return negative ? -value : value;
+}
+
+void Parse_OBJ_Records(const char* at, const char* end, OBJ_Records& records)
+{
+    while (at < end) {
+        Skip_Spaces(at, end);
+
+        if (Read_Keyword(at, end, "v")) {
+            float const x = Parse_Float(at, end);
+            float const y = Parse_Float(at, end);
+            float const z = Parse_Float(at, end);
+            records.positions.push_back({ x, y, z });
+        }
+        else if (Read_Keyword(at, end, "vn")) {
+            float const x = Parse_Float(at, end);
+            float const y = Parse_Float(at, end);
+            float const z = Parse_Float(at, end);
+            records.normals.push_back({ x, y, z });
+        }
+        else if (Read_Keyword(at, end, "vt")) {
+            float const x = Parse_Float(at, end);
+            float const y = Parse_Float(at, end);
+            records.tex_coords.push_back({ x, y });
+        }
+        else if (Read_Keyword(at, end, "f")) {
+            // polygons are triangulated as a fan around the first corner
+            Skip_Spaces(at, end);
+            Triplet const first = Parse_Triplet(at, end);
+            Skip_Spaces(at, end);
+            Triplet previous = Parse_Triplet(at, end);
+            Skip_Spaces(at, end);
+            while (at < end && Is_Digit(*at)) {
+                Triplet const current = Parse_Triplet(at, end);
+                records.corners.push_back(first);
+                records.corners.push_back(previous);
+                records.corners.push_back(current);
+                previous = current;
+                Skip_Spaces(at, end);
+            }
+        }
+
+        // everything else (comments, groups, materials...) is ignored
+        Skip_Line(at, end);
+    }
+}
+
+// cut the file into pieces of roughly equal size, every piece starts at the beginning of a line
+std::vector<const char*> Split_At_Lines(const char* begin, const char* end, std::size_t piece_count)
+{
+    std::size_t const size = end - begin;
+
+    std::vector<const char*> bounds { begin };
+    for (std::size_t n = 1; n < piece_count; ++n) {
+        const char* at = std::max(begin + size * n / piece_count, bounds.back());
+        if (at > begin && at[-1] != '\n') { Skip_Line(at, end); }
+        bounds.push_back(at);
+    }
+    bounds.push_back(end);
+    return bounds;
+}
+
+// obj indices address the records of the whole file, so the pieces have to be concatenated in file order
+OBJ_Records Merge_Records(std::vector<OBJ_Records>& pieces, uint thread_count)
+{
+    if (pieces.size() == 1) {
+        return std::move(pieces.front());
+    }
+
+    struct Offsets { std::size_t positions, normals, tex_coords, corners; };
+    std::vector<Offsets> offsets(pieces.size());
+
+    Offsets total = {};
+    for_size (n, pieces) {
+        offsets[n] = total;
+        total.positions  += pieces[n].positions.size();
+        total.normals    += pieces[n].normals.size();
+        total.tex_coords += pieces[n].tex_coords.size();
+        total.corners    += pieces[n].corners.size();
+    }
+
+    OBJ_Records merged {};
+    merged.positions.resize(total.positions);
+    merged.normals.resize(total.normals);
+    merged.tex_coords.resize(total.tex_coords);
+    merged.corners.resize(total.corners);
+
+    Parallel_For(pieces.size(), thread_count, [&](std::size_t n) {
+        OBJ_Records& piece = pieces[n];
+        std::copy(piece.positions.begin(),  piece.positions.end(),  merged.positions.begin()  + offsets[n].positions);
+        std::copy(piece.normals.begin(),    piece.normals.end(),    merged.normals.begin()    + offsets[n].normals);
+        std::copy(piece.tex_coords.begin(), piece.tex_coords.end(), merged.tex_coords.begin() + offsets[n].tex_coords);
+        std::copy(piece.corners.begin(),    piece.corners.end(),    merged.corners.begin()    + offsets[n].corners);
+        piece = {}; // free the memory early, the merged copy is all that's needed from here on
+    });
+
+    return merged;
+}
+
+// open addressing hash set of the unique corners, the slots store (vertex index + 1), 0 marks a free slot
+struct Corner_Table {
+
+    Corner_Table(std::size_t expected_count)
+    {
+        std::size_t capacity = 1024;
+        while (capacity < expected_count * 2) { capacity *= 2; }
+        slots.resize(capacity);
+    }
+
+    static u64 hash(Triplet const& t)
+    {
+        // murmur3 finalizer over the packed triplet
+        u64 h = (u64(u32(t[V])) << 32) ^ (u64(u32(t[VT])) << 16) ^ u64(u32(t[VN])) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 33; h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    // returns the index of the corner, new corners get the next free index
+    uint insert(Triplet const& corner)
+    {
+        // keep the load factor below 0.5, probe sequences stay short
+        if ((unique.size() + 1) * 2 > slots.size()) { grow(); }
+
+        std::size_t const mask = slots.size() - 1;
+        for (std::size_t slot = hash(corner) & mask; /**/; slot = (slot + 1) & mask) {
+            uint const entry = slots[slot];
+            if (entry == 0) {
+                unique.push_back(corner);
+                slots[slot] = uint(unique.size());
+                return uint(unique.size() - 1);
+            }
+            if (unique[entry - 1] == corner) {
+                return entry - 1;
+            }
+        }
+    }
+
+    void grow()
+    {
+        slots.assign(slots.size() * 2, 0);
+        std::size_t const mask = slots.size() - 1;
+        for_size (n, unique) {
+            std::size_t slot = hash(unique[n]) & mask;
+            while (slots[slot] != 0) { slot = (slot + 1) & mask; }
+            slots[slot] = n + 1;
+        }
+    }
+
+    std::vector<uint>    slots  {};
+    std::vector<Triplet> unique {};
+};
+
+#pragma endregion
+
+Triplet Parse_Triplet(const char*& at, const char* end)
+{
+    Triplet triplet = {};
+    triplet[V] = Parse_Int(at, end);
+    if (at < end && *at == '/') {
+        ++at;
+        if (at < end && *at != '/') { triplet[VT] = Parse_Int(at, end); }
+        if (at < end && *at == '/') {
+            ++at;
+            triplet[VN] = Parse_Int(at, end);
+        }
+    }
+
+    // relative (negative) indices are not supported
+    assert(triplet[V] > 0 && triplet[VT] >= 0 && triplet[VN] >= 0);
+    return triplet;
+}
+
+OBJ_Records Read_OBJ_Records(const char* begin, const char* end, uint thread_count, std::size_t piece_count)
+{
+    // small files aren't worth the thread startup
+    constexpr std::size_t min_piece_size = 1 << 20;
+
+    // a few more pieces than threads evens out pieces with more expensive lines (faces vs. comments)
+    uint        const worker_count = Worker_Count(thread_count);
+    std::size_t const max_pieces   = worker_count > 1 ? worker_count * 4 : 1;
+    if (piece_count == 0) {
+        piece_count = std::clamp<std::size_t>((end - begin) / min_piece_size, 1, max_pieces);
+    }
+
+    std::vector<const char*> const bounds = Split_At_Lines(begin, end, piece_count);
+    std::vector<OBJ_Records> pieces(piece_count);
+
+    Parallel_For(piece_count, worker_count, [&](std::size_t n) {
+        Parse_OBJ_Records(bounds[n], bounds[n + 1], pieces[n]);
+    });
+
+    return Merge_Records(pieces, worker_count);
+}
+
+void Resolve_Corners(OBJ_Records const& records, OBJ& obj, std::size_t first, std::size_t last)
+{
+    for (std::size_t n = first; n < last; ++n) {
+        Triplet const& corner = records.corners[n];
+
+        assert(std::size_t(corner[V]) <= records.positions.size());
+        obj.vertices[n] = records.positions[corner[V] - 1]; // obj starts index with 1, c++ with 0!
+
+        if (corner[VN] != 0) {
+            assert(std::size_t(corner[VN]) <= records.normals.size());
+            obj.normals[n] = records.normals[corner[VN] - 1];
+        }
+
+        if (corner[VT] != 0) {
+            assert(std::size_t(corner[VT]) <= records.tex_coords.size());
+            obj.tex_coords[n] = records.tex_coords[corner[VT] - 1];
+        }
+    }
+}
+
+void Deduplicate_Corners(OBJ_Records const& records, Mesh& mesh)
+{
+    measure_time();
+
+    // closed meshes share most corners, the position count is a good first guess for the unique count
+    Corner_Table table{ records.positions.size() };
+    table.unique.reserve(records.positions.size());
+
+    mesh.indices.resize(records.corners.size());
+    for_size (n, records.corners) {
+        mesh.indices[n] = table.insert(records.corners[n]);
+    }
+
+    mesh.vertices.resize(table.unique.size());
+    for_size (n, table.unique) {
+        Triplet const& corner = table.unique[n];
+        Vertex& vertex = mesh.vertices[n];
+
+        assert(std::size_t(corner[V]) <= records.positions.size());
+        vertex.position = records.positions[corner[V] - 1]; // obj starts index with 1, c++ with 0!
+
+        if (corner[VN] != 0) {
+            assert(std::size_t(corner[VN]) <= records.normals.size());
+            vertex.normal = records.normals[corner[VN] - 1];
+        }
+
+        if (corner[VT] != 0) {
+            assert(std::size_t(corner[VT]) <= records.tex_coords.size());
+            vertex.tex_coord = records.tex_coords[corner[VT] - 1];
+        }
+    }
+}
+
+OBJ Load_OBJ(const char* file_name, uint thread_count)
+{
+    measure_time();
+
+    File::Mapped const file{ file_name };
+    if (!file.is_open()) {
+        return {};
+    }
+
+    // obj format uses indices to address positions, normals etc.
+    // this way the information can be reduced...
+    // example: a cube with 36 vertices can be saved with only 8 vertices (because of the overlapp @ the corners!)
+    OBJ_Records const records = Read_OBJ_Records(file.data, file.data + file.size, thread_count);
+
+    // process the index data and create the OBJ struct
+    OBJ obj{};
+    obj.name = file_name;
+    obj.vertices.resize(records.corners.size());
+    obj.normals.resize(records.corners.size());
+    obj.tex_coords.resize(records.corners.size());
+
+    // every corner is resolved independently, so the result doesn't depend on the thread count
+    constexpr std::size_t corners_per_task = 1 << 16;
+    std::size_t const task_count = (records.corners.size() + corners_per_task - 1) / corners_per_task;
+    Parallel_For(task_count, thread_count, [&](std::size_t n) {
+        std::size_t const first = n * corners_per_task;
+        std::size_t const last  = std::min(first + corners_per_task, records.corners.size());
+        Resolve_Corners(records, obj, first, last);
+    });
+
+    return obj;
+}
+
+Mesh Load_OBJ_Mesh(const char* file_name, uint thread_count)
+{
+    measure_time();
+
+    File::Mapped const file{ file_name };
+    if (!file.is_open()) {
+        return {};
+    }
+
+    OBJ_Records const records = Read_OBJ_Records(file.data, file.data + file.size, thread_count);
+
+    Mesh mesh{};
+    Deduplicate_Corners(records, mesh);
+
+    return mesh;
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+// --------------------------------------------------
+// wavefront obj loading straight from a mapped file,
+// no gl context and no assimp needed
+// --------------------------------------------------
+
+#include "Common.h"
+#include "Vector.h"
+#include "Mesh.h"
+#include "Parallel.h"
+
+#include <array>
+#include <vector>
+
+// data for OBJ format
+struct OBJ {
+    const char* name = nullptr;
+    std::vector<float3> vertices   {};   // v
+    std::vector<float3> normals    {};    // vn
+    std::vector<float2> tex_coords {}; // vt
+};
+
+// the file is parsed in pieces on up to thread_count threads (All_Cores = every hardware thread),
+// the result is identical for every thread count
+OBJ Load_OBJ(const char* file_name, uint thread_count = 1);
+
+// same parser, but shared corners (same v/vt/vn) are merged into one vertex and the faces become indices
+Mesh Load_OBJ_Mesh(const char* file_name, uint thread_count = 1);
+
+
+// ---------------------------------------------
+// the steps of both loaders, usable on any text in memory
+// ---------------------------------------------
+
+// one corner of a face, format: v/vt/vn (obj indices start with 1, 0 = not present)
+using Triplet = std::array<int, 3>;
+
+// the raw content of an obj file, the corners still index into the v/vt/vn arrays
+struct OBJ_Records {
+    std::vector<float3>  positions  {}; // v
+    std::vector<float3>  normals    {}; // vn
+    std::vector<float2>  tex_coords {}; // vt
+    std::vector<Triplet> corners    {}; // f, 3 per triangle
+};
+
+// format: v, v/vt, v//vn or v/vt/vn, the cursor is moved behind the corner
+Triplet Parse_Triplet(const char*& at, const char* end);
+
+// parse (and merge) the records of a whole file, cut into piece_count pieces at line starts
+// (0 = as many as the size and thread count make worth it)
+OBJ_Records Read_OBJ_Records(const char* begin, const char* end, uint thread_count = 1, std::size_t piece_count = 0);
+
+// turn the corners [first, last) into the flat (one entry per corner) OBJ representation,
+// the arrays of obj have to hold every corner already
+void Resolve_Corners(OBJ_Records const& records, OBJ& obj, std::size_t first, std::size_t last);
+
+// every unique v/vt/vn corner becomes one vertex, the faces index into them
+void Deduplicate_Corners(OBJ_Records const& records, Mesh& mesh);
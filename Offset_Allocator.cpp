@@ -0,0 +1,142 @@
+#include "Offset_Allocator.h"
+
+#include <cassert>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+u64 Align_Up(u64 offset, u64 alignment)
+{
+    return (offset + alignment - 1) / alignment * alignment;
+}
+
+#pragma endregion
+
+Offset_Allocator::Offset_Allocator(u64 capacity)
+{
+    grow(capacity);
+}
+
+std::optional<u64> Offset_Allocator::allocate(u64 size, u64 alignment)
+{
+    assert(size > 0 && alignment > 0);
+
+    // the smallest block that still fits, the alignment padding can skip a few candidates
+    for (auto candidate = by_size.lower_bound({ size, 0 }); candidate != by_size.end(); ++candidate) {
+        u64 const block_offset = candidate->second;
+        u64 const block_size   = candidate->first;
+        u64 const offset       = Align_Up(block_offset, alignment);
+        if (offset - block_offset + size > block_size) {
+            continue;
+        }
+
+        remove_free(free_blocks.find(block_offset));
+        if (offset > block_offset) {
+            add_free(block_offset, offset - block_offset);
+        }
+        if (offset + size < block_offset + block_size) {
+            add_free(offset + size, block_offset + block_size - offset - size);
+        }
+
+        allocations[offset] = { size, alignment };
+        in_use += size;
+        return offset;
+    }
+    return {};
+}
+
+void Offset_Allocator::free(u64 offset)
+{
+    auto const allocation = allocations.find(offset);
+    assert(allocation != allocations.end() && "not an allocation of this allocator");
+    if (allocation == allocations.end()) {
+        return;
+    }
+
+    u64 size = allocation->second.size;
+    in_use -= size;
+    allocations.erase(allocation);
+
+    // merge with the free neighbours
+    auto next = free_blocks.lower_bound(offset);
+    if (next != free_blocks.end() && next->first == offset + size) {
+        size += next->second;
+        remove_free(next);
+    }
+    auto previous = free_blocks.lower_bound(offset);
+    if (previous != free_blocks.begin()) {
+        --previous;
+        if (previous->first + previous->second == offset) {
+            offset = previous->first;
+            size += previous->second;
+            remove_free(previous);
+        }
+    }
+    add_free(offset, size);
+}
+
+void Offset_Allocator::grow(u64 new_capacity)
+{
+    if (new_capacity <= total) {
+        return;
+    }
+
+    u64 offset = total;
+    u64 size   = new_capacity - total;
+    total = new_capacity;
+
+    // the last free block reaches up to the old end
+    if (!free_blocks.empty()) {
+        auto const last = std::prev(free_blocks.end());
+        if (last->first + last->second == offset) {
+            offset = last->first;
+            size += last->second;
+            remove_free(last);
+        }
+    }
+    add_free(offset, size);
+}
+
+std::vector<Offset_Allocator::Move> Offset_Allocator::defragment()
+{
+    std::vector<Move> moves{};
+    moves.reserve(allocations.size());
+
+    std::map<u64, Allocation>        packed{};
+    std::vector<std::pair<u64, u64>> padding{}; // the alignment gaps stay usable
+    u64 end = 0;
+    for (auto const& [offset, allocation] : allocations) {
+        u64 const to = Align_Up(end, allocation.alignment);
+        if (to > end) {
+            padding.push_back({ end, to - end });
+        }
+        moves.push_back({ offset, to, allocation.size });
+        packed.emplace_hint(packed.end(), to, allocation);
+        end = to + allocation.size;
+    }
+    allocations = std::move(packed);
+
+    free_blocks.clear();
+    by_size.clear();
+    for (auto const& [offset, size] : padding) {
+        add_free(offset, size);
+    }
+    if (end < total) {
+        add_free(end, total - end);
+    }
+    return moves;
+}
+
+void Offset_Allocator::add_free(u64 offset, u64 size)
+{
+    free_blocks.emplace(offset, size);
+    by_size.emplace(size, offset);
+}
+
+void Offset_Allocator::remove_free(std::map<u64, u64>::iterator block)
+{
+    by_size.erase({ block->second, block->first });
+    free_blocks.erase(block);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "Common.h"
+
+#include <map>
+#include <optional>
+#include <set>
+#include <utility>
+#include <vector>
+
+// --------------------------------------------------
+// hands out ranges of a linear space (a gpu buffer, but nothing here
+// knows about gl): best fit out of the free blocks, neighbouring free
+// blocks are merged again on free. the unit is up to the user (bytes,
+// vertices, ...), every offset & size is in that unit
+// --------------------------------------------------
+struct Offset_Allocator {
+
+    // where an allocation was and where defragment() put it
+    struct Move {
+        u64 from = 0;
+        u64 to   = 0;
+        u64 size = 0;
+    };
+
+    Offset_Allocator(u64 capacity = 0);
+
+    // nothing if there is no free block big enough, the caller can grow() and try again
+    std::optional<u64> allocate(u64 size, u64 alignment = 1);
+    void               free(u64 offset);
+
+    // more space at the end, never less
+    void grow(u64 new_capacity);
+
+    // packs every allocation to the front (keeping their order & alignment), afterwards only the
+    // alignment gaps and one block at the end are free. returns every allocation in offset order,
+    // to <= from, so copying the data in that order never overwrites anything that still has to move
+    std::vector<Move> defragment();
+
+    u64         capacity() const { return total; }
+    u64         used() const { return in_use; }
+    u64         largest_free() const { return by_size.empty() ? 0 : by_size.rbegin()->first; }
+    std::size_t free_block_count() const { return free_blocks.size(); }
+    std::size_t allocation_count() const { return allocations.size(); }
+
+private:
+    struct Allocation {
+        u64 size      = 0;
+        u64 alignment = 1;
+    };
+
+    void add_free(u64 offset, u64 size);
+    void remove_free(std::map<u64, u64>::iterator block);
+
+    u64 total  = 0;
+    u64 in_use = 0;
+
+    std::map<u64, u64>            free_blocks = {}; // offset -> size, never adjacent to each other
+    std::set<std::pair<u64, u64>> by_size     = {}; // (size, offset) of every free block, for the best fit
+    std::map<u64, Allocation>     allocations = {}; // by offset
+};
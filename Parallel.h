@@ -0,0 +1,47 @@
+#pragma once
+
+// --------------------------------------------------
+// minimal helpers to spread work over the cpu cores
+// --------------------------------------------------
+
+#include "Common.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// pass as thread count to use every hardware thread
+constexpr uint All_Cores = 0;
+
+inline uint Worker_Count(uint requested)
+{
+    if (requested != All_Cores) { return requested; }
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// calls task(index) for every index in [0, count) and returns when all of them are done,
+// the calling thread works as well - a thread count of 1 runs everything in order on the caller
+template <class Task>
+void Parallel_For(std::size_t count, uint thread_count, Task&& task)
+{
+    std::size_t const worker_count = std::min<std::size_t>(Worker_Count(thread_count), count);
+    if (worker_count <= 1) {
+        for (std::size_t n = 0; n < count; ++n) { task(n); }
+        return;
+    }
+
+    // tasks are handed out one by one, so uneven task sizes still keep every thread busy
+    std::atomic<std::size_t> next { 0 };
+    auto work = [&]() {
+        for (std::size_t n = next++; n < count; n = next++) { task(n); }
+    };
+
+    std::vector<std::thread> workers {};
+    workers.reserve(worker_count - 1);
+    for (std::size_t n = 1; n < worker_count; ++n) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) { worker.join(); }
+}
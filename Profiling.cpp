@@ -0,0 +1,47 @@
+#include "Profiling.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+#if defined(ALLOCATION_COUNTING)
+std::atomic<u64> Allocations{ 0 }; // the loader allocates from several threads
+#endif
+
+#pragma endregion
+
+std::optional<u64> Allocation_Count()
+{
+#if defined(ALLOCATION_COUNTING)
+    return Allocations.load(std::memory_order_relaxed);
+#else
+    return std::nullopt;
+#endif
+}
+
+#if defined(ALLOCATION_COUNTING)
+// the array & nothrow versions end up here as well
+void* operator new(std::size_t size)
+{
+    Allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size != 0 ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc{};
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+#endif
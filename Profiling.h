@@ -2,15 +2,27 @@
 
 #include "Common.h"
 
+#include <array>
 #include <chrono>
 #include <iostream>
+#include <optional>
 
 #if defined(_DEBUG)
 #define measure_time() Scope_Timer make_unique_name(timer_){__func__}
 #else
-#define PROFILE()
+#define measure_time()
 #endif
 
+// the counter replaces the global operator new & delete, which every allocation of the
+// program pays for. only in debug builds or with COUNT_ALLOCATIONS defined
+#if defined(_DEBUG) || defined(COUNT_ALLOCATIONS)
+#define ALLOCATION_COUNTING
+#endif
+
+// every operator new of the program so far (replaced in Profiling.cpp), the difference
+// around a piece of code is what it allocated. empty without ALLOCATION_COUNTING
+std::optional<u64> Allocation_Count();
+
 // start timer on construction, stop and publish to std::cout in destructor
 struct Scope_Timer {
     using Clock = std::chrono::steady_clock;
@@ -38,4 +50,51 @@ struct Scope_Timer {
     no_copy_and_assign(Scope_Timer);
     no_move_and_assign(Scope_Timer);
 
-};
\ No newline at end of file
+};
+
+// collects the time between two frame() calls, print() shows the distribution (spikes stand out in the tail)
+struct Frame_Histogram {
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr double      Bucket_Width = 0.5; // ms
+    static constexpr std::size_t Bucket_Count = 100; // the last bucket takes everything slower
+
+    std::array<u64, Bucket_Count> buckets = {};
+    u64               frame_count = 0;
+    double            worst_ms    = 0.0;
+    Clock::time_point last        = Clock::now();
+
+    void frame()
+    {
+        auto const now = Clock::now();
+        double const ms = std::chrono::duration<double, std::milli>(now - last).count();
+        last = now;
+
+        std::size_t const bucket = std::size_t(ms / Bucket_Width);
+        buckets[bucket < Bucket_Count ? bucket : Bucket_Count - 1]++;
+        frame_count++;
+        worst_ms = ms > worst_ms ? ms : worst_ms;
+    }
+
+    // upper bound of the bucket that contains the given fraction of all frames
+    double percentile(double fraction) const
+    {
+        u64 const target = u64(fraction * frame_count);
+        u64 count = 0;
+        for_size (n, buckets) {
+            count += buckets[n];
+            if (count > target) { return (n + 1) * Bucket_Width; }
+        }
+        return worst_ms;
+    }
+
+    void print() const
+    {
+        std::cout << "frames: " << frame_count << ", p50 < " << percentile(0.5) << " ms, p99 < " << percentile(0.99)
+                  << " ms, worst: " << worst_ms << " ms\n";
+        for_size (n, buckets) {
+            if (buckets[n] == 0) { continue; }
+            std::cout << "  " << n * Bucket_Width << " - " << (n + 1) * Bucket_Width << " ms: " << buckets[n] << '\n';
+        }
+    }
+};
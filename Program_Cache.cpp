@@ -0,0 +1,188 @@
+#include "Program_Cache.h"
+#include "File.h"
+#include "GL_Extensions.h"
+#include "Hash.h"
+#include "Profiling.h"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#include <glad/glad.h>
+
+// ---------------------------------------------
+// file layout
+// ---------------------------------------------
+// [Header][program binary]
+#pragma region "Layout"
+
+constexpr char Magic[4] = { 'P', 'R', 'O', 'G' };
+
+struct Header {
+    char   magic[4]    = {};
+    u32    version     = 0;
+    u64    key         = 0;
+    u32    format      = 0; // the binary format the driver reported
+    u32    binary_size = 0;
+    double compile_ms  = 0.0; // what the miss cost, a hit saves that
+};
+
+#pragma endregion
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+struct Stats {
+    u64    hits     = 0;
+    u64    misses   = 0;
+    u64    rejected = 0; // the driver didn't take the binary (driver update, other gpu)
+    double load_ms  = 0.0;
+    double saved_ms = 0.0;
+};
+Stats Cache_Stats{};
+
+std::string Driver_String()
+{
+    std::string driver{};
+    for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION }) {
+        auto const text = reinterpret_cast<const char*>(glGetString(name));
+        driver += text ? text : "";
+        driver += '\n';
+    }
+    return driver;
+}
+
+#pragma endregion
+
+u64 Program_Cache::Make_Key(std::string const& vertex_code, std::string const& fragment_code)
+{
+    std::string const driver = Driver_String();
+
+    u64 key = Hash_Bytes(vertex_code.data(), vertex_code.size(), Version);
+    key = Hash_Bytes(fragment_code.data(), fragment_code.size(), key);
+    key = Hash_Bytes(driver.data(), driver.size(), key);
+    return key;
+}
+
+std::string Program_Cache::Cache_Path(u64 key)
+{
+    char name[17] = {};
+    for (int n = 0; n < 16; ++n) {
+        name[n] = "0123456789abcdef"[(key >> (60 - 4 * n)) & 0xf];
+    }
+    return std::string{ "shader/cache/" } + name + ".program";
+}
+
+Shader_ID Program_Cache::Load(u64 key)
+{
+    measure_time();
+
+    if (!GL::Get_Extensions().program_binary) {
+        return Bad_Shader;
+    }
+
+    // a missing binary is the normal case for a changed shader, so no error message here
+    std::string const path = Cache_Path(key);
+    std::error_code   error{};
+    if (!std::filesystem::exists(path, error)) {
+        Cache_Stats.misses++;
+        return Bad_Shader;
+    }
+
+    auto const start = std::chrono::steady_clock::now();
+    Shader_ID  program_id = Bad_Shader;
+    {
+        File::Mapped const file{ path.c_str() };
+        Header const* header = file.is_open() && file.size >= sizeof(Header) ? reinterpret_cast<const Header*>(file.data) : nullptr;
+        bool const valid =
+            header != nullptr &&
+            std::memcmp(header->magic, Magic, sizeof(Magic)) == 0 &&
+            header->version == Version &&
+            header->key     == key &&
+            sizeof(Header) + u64(header->binary_size) == file.size;
+
+        if (valid) {
+            program_id = glCreateProgram();
+            glProgramBinary(program_id, header->format, file.data + sizeof(Header), GLsizei(header->binary_size));
+
+            GLint success = GL_FALSE;
+            glGetProgramiv(program_id, GL_LINK_STATUS, &success);
+            if (success == GL_TRUE) {
+                double const load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                Cache_Stats.hits++;
+                Cache_Stats.load_ms += load_ms;
+                Cache_Stats.saved_ms += header->compile_ms - load_ms;
+                return program_id;
+            }
+            glDeleteProgram(program_id);
+        }
+    }
+
+    // the next Store writes a fresh one
+    Cache_Stats.rejected++;
+    Cache_Stats.misses++;
+    std::filesystem::remove(path, error);
+    return Bad_Shader;
+}
+
+bool Program_Cache::Store(u64 key, Shader_ID program_id, double compile_ms)
+{
+    measure_time();
+
+    if (!GL::Get_Extensions().program_binary || program_id == Bad_Shader) {
+        return false;
+    }
+
+    GLint length = 0;
+    glGetProgramiv(program_id, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return false; // the driver has nothing to save for this program
+    }
+
+    std::vector<char> binary(std::size_t(length), '\0');
+    GLenum format = 0;
+    glGetProgramBinary(program_id, length, &length, &format, binary.data());
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version     = Version;
+    header.key         = key;
+    header.format      = u32(format);
+    header.binary_size = u32(length);
+    header.compile_ms  = compile_ms;
+
+    // write into a temporary file first, a crash while writing must never leave a broken binary behind
+    std::string const path      = Cache_Path(key);
+    std::string const temp_path = path + ".tmp";
+    std::error_code   error{};
+    std::filesystem::create_directories(std::filesystem::path{ path }.parent_path(), error);
+
+    bool written = false;
+    {
+        std::ofstream file{ temp_path, std::ios::binary | std::ios::trunc };
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), header.binary_size);
+        written = file.good();
+    }
+
+    if (written) {
+        std::filesystem::rename(temp_path, path, error);
+    }
+    if (!written || error) {
+        std::cerr << "Failed to write program binary " << path << '\n';
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+void Program_Cache::Print_Stats()
+{
+    std::cout << "program cache: " << Cache_Stats.hits << " hits (" << Cache_Stats.load_ms << " ms loading, " << Cache_Stats.saved_ms
+              << " ms of compiling saved), " << Cache_Stats.misses << " misses, " << Cache_Stats.rejected << " rejected\n";
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+// --------------------------------------------------
+// linked shader programs saved as driver binaries
+// (glGetProgramBinary), a launch or reload with the same
+// sources loads them with glProgramBinary instead of compiling
+// --------------------------------------------------
+
+#include "Common.h"
+#include "Graphics.h"
+
+#include <string>
+
+namespace Program_Cache {
+
+// bump whenever the file layout changes
+constexpr u32 Version = 1;
+
+// a binary is only valid for exactly these sources and this driver (vendor, renderer & version string)
+u64         Make_Key(std::string const& vertex_code, std::string const& fragment_code);
+std::string Cache_Path(u64 key);
+
+// Bad_Shader on a miss or if the driver rejects the binary (then the file is removed), needs a context
+Shader_ID Load(u64 key);
+bool      Store(u64 key, Shader_ID program_id, double compile_ms); // the program needs GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+
+// hits, misses and the compile time the hits saved
+void Print_Stats();
+
+}
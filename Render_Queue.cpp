@@ -0,0 +1,110 @@
+#include "Render_Queue.h"
+#include "Draw_Keys.h"
+
+#include <iostream>
+
+#include <glad/glad.h>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+static_assert(GL::Render_Queue::transparent <= 1, "the keys have one pass bit");
+
+// the same texture types in the same units, the sampler uniforms stay valid
+bool Same_Texture_Types(Textures const& a, Textures const& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for_size (n, a) {
+        if (a[n].type != b[n].type) {
+            return false;
+        }
+    }
+    return true;
+}
+
+#pragma endregion
+
+void GL::Render_Queue::clear()
+{
+    draws.clear();
+    keys.clear();
+}
+
+void GL::Render_Queue::add(Mesh const& mesh, Shader const& shader, std::size_t level, float depth, Pass pass, float44 const* model)
+{
+    if (draws.size() == Draw_Keys::Max_Draws) {
+        std::cerr << "Render_Queue: more than " << Draw_Keys::Max_Draws << " draws\n";
+        assert(false);
+        return;
+    }
+    keys.push_back(Draw_Keys::Make(pass, pass == transparent, uint(shader.program_id), mesh.textures, mesh.VAO, depth, u32(draws.size())));
+
+    // filled in place, copying a temporary that was written field by field stalls on the store forwarding
+    Draw& draw  = draws.emplace_back();
+    draw.mesh   = &mesh;
+    draw.shader = &shader;
+    draw.level  = level;
+    draw.model  = model;
+}
+
+void GL::Render_Queue::sort()
+{
+    Draw_Keys::Sort(keys, scratch, histograms);
+}
+
+void GL::Render_Queue::submit()
+{
+    State_Changes& changes = Get_State_Changes();
+
+    Shader const*  bound_shader   = nullptr;
+    uint           bound_VAO      = 0;
+    Mesh const*    textured_mesh  = nullptr; // the textures of this one are bound
+    float44 const* uploaded_model = nullptr; // to the model uniform of the bound program
+    for (u64 key : keys) {
+        Draw const& draw = draws[Draw_Keys::Draw(key)];
+        Mesh const& mesh = *draw.mesh;
+
+        if (draw.shader != bound_shader) {
+            draw.shader->apply();
+            bound_shader   = draw.shader;
+            textured_mesh  = nullptr; // the sampler uniforms belong to the program
+            uploaded_model = nullptr; // and so does the model matrix
+        }
+        if (draw.model && draw.model != uploaded_model) {
+            glUniformMatrix4fv(draw.shader->model_location, 1, GL_TRUE, &draw.model->data[0][0]);
+            uploaded_model = draw.model;
+        }
+        if (mesh.VAO != bound_VAO) {
+            glBindVertexArray(mesh.VAO);
+            bound_VAO = mesh.VAO;
+            changes.vertex_arrays++;
+        }
+
+        if (!textured_mesh || !Same_Texture_Types(textured_mesh->textures, mesh.textures)) {
+            Bind_Textures(mesh, *draw.shader);
+        }
+        else {
+            // same units & samplers, only the textures that differ
+            bool changed = false;
+            for_size (unit, mesh.textures) {
+                if (mesh.textures[unit].id != textured_mesh->textures[unit].id) {
+                    glActiveTexture(GL_TEXTURE0 + unit);
+                    glBindTexture(GL_TEXTURE_2D, mesh.textures[unit].id);
+                    changes.textures++;
+                    changed = true;
+                }
+            }
+            if (changed) {
+                glActiveTexture(GL_TEXTURE0);
+            }
+        }
+        textured_mesh = &mesh;
+
+        Draw_Mesh(mesh, *draw.shader, draw.level);
+    }
+    glBindVertexArray(0);
+}
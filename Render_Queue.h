@@ -0,0 +1,58 @@
+#pragma once
+
+#include "Common.h"
+#include "Graphics.h"
+
+#include <vector>
+
+namespace GL {
+
+// --------------------------------------------------
+// the draws of a frame, submitted in the order of a 64 bit key so that
+// neighbouring draws share as much gl state as possible (the keys and
+// their sort are in Draw_Keys.h, without gl). a collision of the
+// truncated ids only costs a state change, submit() compares the real
+// state and only changes what differs (counted in Get_State_Changes()).
+// at most Draw_Keys::Max_Draws draws.
+//
+// measured (tests/Test_Render_Queue --bench, one core of a shared
+// virtual xeon) 100k draws take ~1-1.5 ms to add and ~2 ms to sort, 4
+// radix passes at ~0.5 ms each. that is half the time of the 16 byte
+// key & index entries before, but not yet the 1 ms for both together.
+// --------------------------------------------------
+struct Render_Queue {
+
+    enum Pass : u32 {
+        opaque,     // front to back, the depth test rejects what is behind
+        transparent // back to front
+    };
+
+    void clear();
+
+    // the shader & mesh have to live until submit(), depth is the distance to the camera (only orders equal state).
+    // model: nullptr or the matrix for the model uniform of the shader, also has to live until submit()
+    void add(Mesh const& mesh, Shader const& shader, std::size_t level = 0, float depth = 0.0f, Pass pass = opaque, float44 const* model = nullptr);
+
+    // radix sort of the keys, stable: equal state stays in the order it was added
+    void sort();
+
+    // binds the programs, uploads the model matrices once per program & matrix. the VAO is unbound afterwards
+    void submit();
+
+    std::size_t size() const { return draws.size(); }
+
+private:
+    struct Draw {
+        Mesh const*    mesh   = nullptr;
+        Shader const*  shader = nullptr;
+        std::size_t    level  = 0;
+        float44 const* model  = nullptr;
+    };
+
+    std::vector<Draw> draws      = {};
+    std::vector<u64>  keys       = {}; // one per draw with its index in the low bits, sorted after sort()
+    std::vector<u64>  scratch    = {};
+    std::vector<u32>  histograms = {}; // of every radix pass
+};
+
+}
@@ -17,6 +17,22 @@ struct Texture {
 };
 using Textures = std::vector<Texture>;
 
+constexpr std::size_t Texture_Type_Count = Texture::height + 1;
+
+// the same gl textures in the same units (the paths don't matter once they are loaded)
+inline bool Same_Textures(Textures const& a, Textures const& b)
+{
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for_size (n, a) {
+        if (a[n].id != b[n].id || a[n].type != b[n].type) {
+            return false;
+        }
+    }
+    return true;
+}
+
 namespace std {
 inline std::string to_string(Texture::Type type)
 {
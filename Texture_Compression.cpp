@@ -0,0 +1,425 @@
+#include "Texture_Compression.h"
+#include "File.h"
+#include "Graphics.h"
+#include "Mipmap.h"
+#include "Profiling.h"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <iostream>
+
+#include <glad/glad.h>
+
+// ---------------------------------------------
+// dds layout
+// ---------------------------------------------
+// "DDS " [DDS_Header][DDS_Header_DX10][level 0][level 1]...
+// the levels are tightly packed rows of blocks
+#pragma region "Layout"
+
+constexpr char DDS_Magic[4] = { 'D', 'D', 'S', ' ' };
+
+constexpr u32 Four_CC(const char (&code)[5])
+{
+    return u32(u8(code[0])) | (u32(u8(code[1])) << 8) | (u32(u8(code[2])) << 16) | (u32(u8(code[3])) << 24);
+}
+
+struct DDS_Pixel_Format {
+    u32 size          = 32;
+    u32 flags         = 0;
+    u32 four_cc       = 0;
+    u32 rgb_bit_count = 0;
+    u32 r_mask        = 0;
+    u32 g_mask        = 0;
+    u32 b_mask        = 0;
+    u32 a_mask        = 0;
+};
+
+struct DDS_Header {
+    u32 size                 = 124;
+    u32 flags                = 0;
+    u32 height               = 0;
+    u32 width                = 0;
+    u32 pitch_or_linear_size = 0;
+    u32 depth                = 0;
+    u32 mip_map_count        = 0;
+    u32 reserved1[11]        = {};
+    DDS_Pixel_Format pixel_format = {};
+    u32 caps                 = 0;
+    u32 caps2                = 0;
+    u32 caps3                = 0;
+    u32 caps4                = 0;
+    u32 reserved2            = 0;
+};
+static_assert(sizeof(DDS_Header) == 124, "the dds header is 124 bytes");
+
+struct DDS_Header_DX10 {
+    u32 dxgi_format        = 0;
+    u32 resource_dimension = 3; // texture 2d
+    u32 misc_flag          = 0;
+    u32 array_size         = 1;
+    u32 misc_flags2        = 0;
+};
+
+constexpr u32 DDSD_Caps         = 0x1;
+constexpr u32 DDSD_Height       = 0x2;
+constexpr u32 DDSD_Width        = 0x4;
+constexpr u32 DDSD_Pixel_Format = 0x1000;
+constexpr u32 DDSD_Mip_Count    = 0x20000;
+constexpr u32 DDSD_Linear_Size  = 0x80000;
+constexpr u32 DDPF_Four_CC      = 0x4;
+constexpr u32 DDSCAPS_Complex   = 0x8;
+constexpr u32 DDSCAPS_Texture   = 0x1000;
+constexpr u32 DDSCAPS_Mipmap    = 0x400000;
+
+// the dxgi formats for the unorm and the srgb variant
+struct DXGI_Formats {
+    Block_Format format;
+    u32          linear;
+    u32          srgb;
+};
+
+constexpr DXGI_Formats DXGI_Table[] = {
+    { bc1, 71, 72 },
+    { bc3, 77, 78 },
+    { bc5, 83, 83 },
+    { bc7, 98, 99 },
+};
+
+#pragma endregion
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+// not part of the loaded gl 4.0 core headers
+constexpr GLenum GL_Compressed_RGBA_S3TC_DXT1       = 0x83F1;
+constexpr GLenum GL_Compressed_RGBA_S3TC_DXT5       = 0x83F3;
+constexpr GLenum GL_Compressed_SRGB_Alpha_S3TC_DXT1 = 0x8C4D;
+constexpr GLenum GL_Compressed_SRGB_Alpha_S3TC_DXT5 = 0x8C4F;
+constexpr GLenum GL_Compressed_RGBA_BPTC            = 0x8E8C;
+constexpr GLenum GL_Compressed_SRGB_Alpha_BPTC      = 0x8E8D;
+
+std::size_t Level_Size(Block_Format format, int width, int height)
+{
+    return std::size_t(Block_Count(width)) * Block_Count(height) * Block_Bytes(format);
+}
+
+Bytes To_RGBA(Decoded_Image const& image)
+{
+    Bytes rgba(std::size_t(image.x) * image.y * 4);
+    for (std::size_t n = 0; n < rgba.size() / 4; ++n) {
+        const uchar* in  = image.pixels + n * image.channels;
+        Byte*        out = rgba.data() + n * 4;
+        switch (image.channels) {
+        case 1: out[0] = out[1] = out[2] = in[0]; out[3] = 255;   break;
+        case 2: out[0] = out[1] = out[2] = in[0]; out[3] = in[1]; break;
+        case 3: std::memcpy(out, in, 3);          out[3] = 255;   break;
+        default: std::memcpy(out, in, 4);                         break;
+        }
+    }
+    return rgba;
+}
+
+// level 0 converted to rgba, the others filtered in linear light
+std::vector<Mipmap::Level> Build_Mip_Chain(Decoded_Image const& image, bool gamma)
+{
+    std::vector<Mipmap::Level> chain{};
+    chain.push_back({ To_RGBA(image), image.x, image.y });
+
+    std::vector<Mipmap::Level> mips = Mipmap::Generate(chain[0].pixels.data(), image.x, image.y, 4, gamma, Mipmap::kaiser, Mipmap::best);
+    std::move(mips.begin(), mips.end(), std::back_inserter(chain));
+    return chain;
+}
+
+Compressed_Texture Compress_Chain(std::vector<Mipmap::Level> const& chain, Block_Format format, bool gamma, uint thread_count)
+{
+    Compressed_Texture texture{};
+    texture.format = format;
+    texture.gamma  = gamma && format != bc5;
+    texture.width  = chain[0].width;
+    texture.height = chain[0].height;
+
+    for (Mipmap::Level const& level : chain) {
+        texture.levels.push_back(Compress_Image(format, level.pixels.data(), level.width, level.height, thread_count));
+    }
+    return texture;
+}
+
+// only the channels the format stores are compared
+double PSNR(Block_Format format, Bytes const& original, Bytes const& decoded)
+{
+    int const channels = format == bc1 ? 3 : format == bc5 ? 2 : 4;
+
+    double squared_error = 0.0;
+    for (std::size_t n = 0; n < original.size(); n += 4) {
+        for (int c = 0; c < channels; ++c) {
+            double const d = double(original[n + c]) - double(decoded[n + c]);
+            squared_error += d * d;
+        }
+    }
+
+    double const mean = squared_error / (double(original.size() / 4) * channels);
+    return mean > 0.0 ? 10.0 * std::log10(255.0 * 255.0 / mean) : INFINITY;
+}
+
+bool Is_Supported(Block_Format format)
+{
+    switch (format) {
+    case bc1:
+    case bc3:
+        return GL::Has_Extension("GL_EXT_texture_compression_s3tc");
+    case bc5:
+        return true; // rgtc is core since 3.0
+    case bc7:
+        return GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 2) || GL::Has_Extension("GL_ARB_texture_compression_bptc");
+    }
+    return false;
+}
+
+GLenum Internal_Format(Block_Format format, bool gamma)
+{
+    switch (format) {
+    case bc1: return gamma ? GL_Compressed_SRGB_Alpha_S3TC_DXT1 : GL_Compressed_RGBA_S3TC_DXT1;
+    case bc3: return gamma ? GL_Compressed_SRGB_Alpha_S3TC_DXT5 : GL_Compressed_RGBA_S3TC_DXT5;
+    case bc5: return GL_COMPRESSED_RG_RGTC2;
+    case bc7: return gamma ? GL_Compressed_SRGB_Alpha_BPTC : GL_Compressed_RGBA_BPTC;
+    }
+    return 0;
+}
+
+#pragma endregion
+
+std::size_t Compressed_Texture::size() const
+{
+    std::size_t total = 0;
+    for (Bytes const& level : levels) {
+        total += level.size();
+    }
+    return total;
+}
+
+std::optional<Block_Format> Texture_Compression::Parse_Format(std::string const& name)
+{
+    if (name == "bc1") { return bc1; }
+    if (name == "bc3") { return bc3; }
+    if (name == "bc5") { return bc5; }
+    if (name == "bc7") { return bc7; }
+    return std::nullopt;
+}
+
+Compressed_Texture Texture_Compression::Compress(Decoded_Image const& image, Block_Format format, bool gamma, uint thread_count)
+{
+    measure_time();
+    return Compress_Chain(Build_Mip_Chain(image, gamma && format != bc5), format, gamma, thread_count);
+}
+
+bool Texture_Compression::Is_DDS(std::string const& file_path)
+{
+    return file_path.size() >= 4 && file_path.compare(file_path.size() - 4, 4, ".dds") == 0;
+}
+
+bool Texture_Compression::Write_DDS(std::string const& file_path, Compressed_Texture const& texture)
+{
+    measure_time();
+
+    DDS_Header header{};
+    header.flags                = DDSD_Caps | DDSD_Height | DDSD_Width | DDSD_Pixel_Format | DDSD_Mip_Count | DDSD_Linear_Size;
+    header.height               = u32(texture.height);
+    header.width                = u32(texture.width);
+    header.pitch_or_linear_size = texture.levels.empty() ? 0 : u32(texture.levels[0].size());
+    header.mip_map_count        = u32(texture.levels.size());
+    header.pixel_format.flags   = DDPF_Four_CC;
+    header.pixel_format.four_cc = Four_CC("DX10");
+    header.caps                 = DDSCAPS_Texture | (texture.levels.size() > 1 ? DDSCAPS_Complex | DDSCAPS_Mipmap : 0);
+
+    DDS_Header_DX10 header_dx10{};
+    for (DXGI_Formats const& entry : DXGI_Table) {
+        if (entry.format == texture.format) {
+            header_dx10.dxgi_format = texture.gamma ? entry.srgb : entry.linear;
+        }
+    }
+
+    // same as the mesh cache: never leave a half written file behind
+    std::string const temp_path = file_path + ".tmp";
+    bool written = false;
+    {
+        std::ofstream file{ temp_path, std::ios::binary | std::ios::trunc };
+        file.write(DDS_Magic, sizeof(DDS_Magic));
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(&header_dx10), sizeof(header_dx10));
+        for (Bytes const& level : texture.levels) {
+            file.write(reinterpret_cast<const char*>(level.data()), level.size());
+        }
+        written = file.good();
+    }
+
+    std::error_code error{};
+    if (written) {
+        std::filesystem::rename(temp_path, file_path, error);
+    }
+    if (!written || error) {
+        std::cerr << "Failed to write the texture " << file_path << '\n';
+        std::filesystem::remove(temp_path, error);
+        return false;
+    }
+    return true;
+}
+
+std::optional<Compressed_Texture> Texture_Compression::Read_DDS(std::string const& file_path)
+{
+    measure_time();
+
+    File::Mapped const file{ file_path.c_str() };
+    if (!file.is_open()) {
+        return std::nullopt;
+    }
+
+    auto corrupt = [&file_path]() -> std::optional<Compressed_Texture> {
+        std::cerr << "Invalid or unsupported dds file " << file_path << '\n';
+        return std::nullopt;
+    };
+
+    std::size_t offset = sizeof(DDS_Magic) + sizeof(DDS_Header);
+    if (file.size < offset || std::memcmp(file.data, DDS_Magic, sizeof(DDS_Magic)) != 0) {
+        return corrupt();
+    }
+
+    DDS_Header header;
+    std::memcpy(&header, file.data + sizeof(DDS_Magic), sizeof(header));
+    if (header.size != sizeof(DDS_Header) || !(header.pixel_format.flags & DDPF_Four_CC)) {
+        return corrupt();
+    }
+
+    Compressed_Texture texture{};
+    texture.width  = int(header.width);
+    texture.height = int(header.height);
+
+    // the legacy four cc codes of other tools are read as well
+    u32 const four_cc = header.pixel_format.four_cc;
+    if (four_cc == Four_CC("DXT1")) {
+        texture.format = bc1;
+    }
+    else if (four_cc == Four_CC("DXT5")) {
+        texture.format = bc3;
+    }
+    else if (four_cc == Four_CC("ATI2") || four_cc == Four_CC("BC5U")) {
+        texture.format = bc5;
+    }
+    else if (four_cc == Four_CC("DX10") && file.size >= offset + sizeof(DDS_Header_DX10)) {
+        DDS_Header_DX10 header_dx10;
+        std::memcpy(&header_dx10, file.data + offset, sizeof(header_dx10));
+        offset += sizeof(header_dx10);
+        if (header_dx10.resource_dimension != 3 || header_dx10.array_size != 1) {
+            return corrupt();
+        }
+
+        bool known = false;
+        for (DXGI_Formats const& entry : DXGI_Table) {
+            if (header_dx10.dxgi_format == entry.linear || header_dx10.dxgi_format == entry.srgb) {
+                texture.format = entry.format;
+                texture.gamma  = header_dx10.dxgi_format == entry.srgb && entry.srgb != entry.linear;
+                known = true;
+            }
+        }
+        if (!known) {
+            return corrupt();
+        }
+    }
+    else {
+        return corrupt();
+    }
+
+    u32 const level_count = (header.flags & DDSD_Mip_Count) ? std::max(1u, header.mip_map_count) : 1u;
+    if (texture.width <= 0 || texture.height <= 0 || level_count > 32) {
+        return corrupt();
+    }
+
+    for (u32 level = 0; level < level_count; ++level) {
+        std::size_t const size = Level_Size(texture.format, texture.level_width(level), texture.level_height(level));
+        if (file.size - offset < size) {
+            return corrupt();
+        }
+        texture.levels.emplace_back(file.data + offset, file.data + offset + size);
+        offset += size;
+    }
+
+    return texture;
+}
+
+bool Texture_Compression::Compress_File(std::string const& source_path, std::string const& target_path, Block_Format format, bool gamma, uint thread_count)
+{
+    measure_time();
+
+    Shared_Image const image = Image_Cache::Load(source_path);
+    if (!image) {
+        std::cerr << "Failed to load the image " << source_path << '\n';
+        return false;
+    }
+
+    std::vector<Mipmap::Level> const chain = Build_Mip_Chain(*image, gamma && format != bc5);
+    Compressed_Texture const texture = Compress_Chain(chain, format, gamma, thread_count);
+
+    if (!Write_DDS(target_path, texture)) {
+        return false;
+    }
+
+    // read the file back and decode every level with the reference decoder
+    std::optional<Compressed_Texture> const written = Read_DDS(target_path);
+    if (!written || written->levels != texture.levels || written->format != texture.format || written->gamma != texture.gamma) {
+        std::cerr << "Compressed texture differs after reading back " << target_path << '\n';
+        assert(false);
+        return false;
+    }
+
+    std::cout << "Compressed " << source_path << " -> " << target_path << " (" << texture.size() / 1024 << " KB)\n";
+    for_size (n, chain) {
+        Bytes decoded(chain[n].pixels.size());
+        Decompress_Image(format, written->levels[n].data(), chain[n].width, chain[n].height, decoded.data());
+        std::cout << "  level " << n << ": " << chain[n].width << "x" << chain[n].height
+                  << ", psnr " << PSNR(format, chain[n].pixels, decoded) << " dB\n";
+    }
+    return true;
+}
+
+uint GL::Allocate_Compressed_Texture(Compressed_Texture const& texture)
+{
+    measure_time();
+
+    uint texture_id = 0;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+
+    if (Is_Supported(texture.format)) {
+        GLenum const internal_format = Internal_Format(texture.format, texture.gamma);
+        for_size (level, texture.levels) {
+            glCompressedTexImage2D(GL_TEXTURE_2D, GLint(level), internal_format, texture.level_width(level), texture.level_height(level),
+                                   0, GLsizei(texture.levels[level].size()), texture.levels[level].data());
+        }
+    }
+    else {
+        // costs 4-8x the memory, but still looks the same
+        GLenum const internal_format = texture.format == bc5 ? GL_RG8 : texture.gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        for_size (level, texture.levels) {
+            int const width  = texture.level_width(level);
+            int const height = texture.level_height(level);
+            Bytes pixels(std::size_t(width) * height * 4);
+            Decompress_Image(texture.format, texture.levels[level].data(), width, height, pixels.data());
+            glTexImage2D(GL_TEXTURE_2D, GLint(level), internal_format, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+        }
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    }
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(texture.levels.size()) - 1);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    return texture_id;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "Common.h"
+#include "Block_Compression.h"
+#include "Image_Cache.h"
+
+#include <algorithm>
+#include <optional>
+#include <string>
+#include <vector>
+
+// a block compressed texture with its whole mip chain, the in memory form of a .dds file
+struct Compressed_Texture {
+    Block_Format       format = bc1;
+    bool               gamma  = false; // srgb color data (not used by bc5)
+    int                width  = 0;
+    int                height = 0;
+    std::vector<Bytes> levels = {}; // largest first, down to 1x1
+
+    int level_width(std::size_t level) const  { return std::max(1, width >> level); }
+    int level_height(std::size_t level) const { return std::max(1, height >> level); }
+
+    std::size_t size() const;
+};
+
+// --------------------------------------------------
+// offline texture compression: images are compressed once into .dds files
+// (dx10 header, bc1/bc3/bc5/bc7 + mip chain) that are uploaded as they are.
+// --------------------------------------------------
+namespace Texture_Compression {
+
+std::optional<Block_Format> Parse_Format(std::string const& name); // "bc1", "bc3", "bc5" or "bc7"
+
+// the mip chain is built with the kaiser filter, in linear light for srgb images
+Compressed_Texture Compress(Decoded_Image const& image, Block_Format format, bool gamma, uint thread_count = 1);
+
+bool Is_DDS(std::string const& file_path);
+bool Write_DDS(std::string const& file_path, Compressed_Texture const& texture);
+std::optional<Compressed_Texture> Read_DDS(std::string const& file_path);
+
+// the offline step: compresses an image file into a .dds file and
+// checks every level with the reference decoder (prints the psnr)
+bool Compress_File(std::string const& source_path, std::string const& target_path, Block_Format format, bool gamma, uint thread_count = 1);
+
+}
+
+namespace GL {
+
+// uploads all levels with glCompressedTexImage2D, if the driver lacks
+// the format the blocks are decoded on the cpu and uploaded as rgba8
+uint Allocate_Compressed_Texture(Compressed_Texture const& texture);
+
+}
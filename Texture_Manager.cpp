@@ -0,0 +1,220 @@
+#include "Texture_Manager.h"
+#include "Texture_Streamer.h"
+#include "Profiling.h"
+
+#include <iostream>
+
+#include "Image_Cache.h"
+#include "Mipmap.h"
+#include "Texture_Compression.h"
+
+#include <glad/glad.h>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+struct Loaded_Texture {
+    uint        id    = 0;
+    std::size_t bytes = 0;
+};
+
+// synchronous fallback if there is no streamer
+Loaded_Texture Texture_From_File(std::string const& file_path, bool gamma)
+{
+    measure_time();
+
+    Loaded_Texture texture{};
+    glGenTextures(1, &texture.id);
+
+    Shared_Image const image = Image_Cache::Load(file_path);
+    if (image) {
+        int const width           = image->x;
+        int const height          = image->y;
+        int const component_count = image->channels;
+
+        GLenum format = GL_RGBA;
+        if (component_count == 1) {
+            format = GL_RED;
+        }
+        else if (component_count == 2) {
+            format = GL_RG;
+        }
+        else if (component_count == 3) {
+            format = GL_RGB;
+        }
+
+        GLenum internal_format = format;
+        if (gamma && component_count >= 3) {
+            internal_format = component_count == 3 ? GL_SRGB8 : GL_SRGB8_ALPHA8;
+        }
+
+        std::vector<Mipmap::Level> const mips = Mipmap::Generate(image->pixels, width, height, component_count, gamma, Mipmap::box);
+
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, texture.id);
+        glTexImage2D(GL_TEXTURE_2D, 0, internal_format, width, height, 0, format, GL_UNSIGNED_BYTE, image->pixels);
+        texture.bytes = image->size();
+        for_size (n, mips) {
+            glTexImage2D(GL_TEXTURE_2D, GLint(n + 1), internal_format, mips[n].width, mips[n].height, 0, format, GL_UNSIGNED_BYTE, mips[n].pixels.data());
+            texture.bytes += mips[n].pixels.size();
+        }
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(mips.size()));
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    }
+    else {
+        std::cout << "Texture failed to load at path: " << file_path << std::endl;
+    }
+
+    return texture;
+}
+
+// compressed offline with the whole mip chain, uploaded as it is
+Loaded_Texture Texture_From_DDS(std::string const& file_path)
+{
+    Loaded_Texture texture{};
+
+    std::optional<Compressed_Texture> const compressed = Texture_Compression::Read_DDS(file_path);
+    if (compressed) {
+        texture.id    = GL::Allocate_Compressed_Texture(*compressed);
+        texture.bytes = compressed->size();
+    }
+    else {
+        std::cout << "Texture failed to load at path: " << file_path << std::endl;
+        glGenTextures(1, &texture.id);
+    }
+
+    return texture;
+}
+
+#pragma endregion
+
+GL::Texture_Manager::Texture_Manager(std::size_t vram_budget, Texture_Streamer* streamer) : vram_budget{ vram_budget }, streamer{ streamer }
+{
+}
+
+GL::Texture_Manager::~Texture_Manager()
+{
+    // the streamer may still upload into these ids, so it has to outlive the manager
+    for (auto& [path, entry] : by_path) {
+        glDeleteTextures(1, &entry.id);
+    }
+}
+
+uint GL::Texture_Manager::acquire(std::string const& file_path, bool gamma)
+{
+    auto found = by_path.find(file_path);
+    if (found != by_path.end()) {
+        Entry& entry = found->second;
+        if (entry.references == 0) {
+            unused.erase(entry.unused_position);
+        }
+        entry.references++;
+        statistics.hits++;
+        return entry.id;
+    }
+
+    statistics.misses++;
+
+    Entry& entry = by_path[file_path];
+    entry.path       = &by_path.find(file_path)->first;
+    entry.references = 1;
+
+    if (Texture_Compression::Is_DDS(file_path)) {
+        // nothing to decode, not worth a trip through the streamer
+        Loaded_Texture const loaded = Texture_From_DDS(file_path);
+        entry.id    = loaded.id;
+        entry.bytes = loaded.bytes;
+    }
+    else if (streamer) {
+        // the real size is only known after the upload, see update()
+        entry.id    = streamer->request(file_path, gamma);
+        entry.bytes = 4;
+    }
+    else {
+        Loaded_Texture const loaded = Texture_From_File(file_path, gamma);
+        entry.id    = loaded.id;
+        entry.bytes = loaded.bytes;
+    }
+
+    by_id[entry.id] = &entry;
+    statistics.bytes_resident += entry.bytes;
+    statistics.texture_count++;
+
+    evict_unused();
+    return entry.id;
+}
+
+void GL::Texture_Manager::release(uint texture_id)
+{
+    auto found = by_id.find(texture_id);
+    assert(found != by_id.end());
+    if (found == by_id.end()) { return; }
+
+    Entry& entry = *found->second;
+    assert(entry.references > 0);
+    if (--entry.references > 0) { return; }
+
+    // keep it around as long as the budget allows, somebody might need it again soon
+    entry.unused_position = unused.insert(unused.end(), &entry);
+    evict_unused();
+}
+
+void GL::Texture_Manager::update()
+{
+    if (!streamer) { return; }
+
+    streamer->update();
+
+    for (auto const& [texture_id, bytes] : streamer->take_uploaded()) {
+        auto found = by_id.find(texture_id);
+        if (found == by_id.end()) { continue; }
+
+        Entry& entry = *found->second;
+        statistics.bytes_resident -= entry.bytes;
+        statistics.bytes_resident += bytes;
+        entry.bytes = bytes;
+    }
+
+    evict_unused();
+}
+
+void GL::Texture_Manager::print_stats() const
+{
+    std::cout << "textures: " << statistics.texture_count << " resident, " << statistics.bytes_resident / 1024 << " KB, "
+              << statistics.hits << " hits, " << statistics.misses << " misses, " << statistics.evictions << " evictions\n";
+}
+
+void GL::Texture_Manager::evict_unused()
+{
+    for (auto at = unused.begin(); at != unused.end() && statistics.bytes_resident > vram_budget; /**/) {
+        Entry& entry = **at;
+
+        // deleting a texture the streamer still uploads into would hand its id to the next texture
+        if (streamer && !streamer->is_resident(entry.id)) {
+            ++at;
+            continue;
+        }
+
+        at = unused.erase(at);
+        statistics.evictions++;
+        destroy(entry);
+    }
+}
+
+void GL::Texture_Manager::destroy(Entry& entry)
+{
+    glDeleteTextures(1, &entry.id);
+
+    statistics.bytes_resident -= entry.bytes;
+    statistics.texture_count--;
+
+    by_id.erase(entry.id);
+    by_path.erase(by_path.find(*entry.path)); // entry is gone after this
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "Common.h"
+
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace GL {
+
+struct Texture_Streamer;
+
+struct Texture_Stats {
+    u64         hits           = 0;
+    u64         misses         = 0;
+    u64         evictions      = 0;
+    std::size_t bytes_resident = 0; // estimated gpu memory incl. mip chain
+    std::size_t texture_count  = 0;
+};
+
+// --------------------------------------------------
+// owns every texture loaded from a file: one gl texture per file path,
+// shared by reference count. textures nobody references anymore stay
+// resident as a cache until the vram budget is exceeded, then the least
+// recently used ones are deleted first.
+// --------------------------------------------------
+struct Texture_Manager {
+
+    // without a streamer the files are loaded synchronously
+    Texture_Manager(std::size_t vram_budget = std::size_t(512) << 20, Texture_Streamer* streamer = nullptr);
+    ~Texture_Manager();
+
+    // every acquire needs a matching release
+    uint acquire(std::string const& file_path, bool gamma = false);
+    void release(uint texture_id);
+
+    // render thread, once per frame (drives the streamer if there is one)
+    void update();
+
+    Texture_Stats stats() const { return statistics; }
+    void          print_stats() const;
+
+    no_copy_and_assign(Texture_Manager);
+    no_move_and_assign(Texture_Manager);
+
+private:
+    struct Entry {
+        std::string const* path       = nullptr; // the key of this entry in the path map
+        uint               id         = 0;
+        uint               references = 0;
+        std::size_t        bytes      = 0;
+        std::list<Entry*>::iterator unused_position = {}; // only valid while references == 0
+    };
+
+    void evict_unused();
+    void destroy(Entry& entry);
+
+    std::size_t       vram_budget = 0;
+    Texture_Streamer* streamer    = nullptr;
+
+    std::unordered_map<std::string, Entry> by_path = {};
+    std::unordered_map<uint, Entry*>       by_id   = {};
+    std::list<Entry*>                      unused  = {}; // least recently used first
+
+    Texture_Stats statistics = {};
+};
+
+}
@@ -0,0 +1,237 @@
+#include "Texture_Streamer.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include <glad/glad.h>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+GLenum Pixel_Format(int channels)
+{
+    switch (channels) {
+    case 1:  return GL_RED;
+    case 2:  return GL_RG;
+    case 3:  return GL_RGB;
+    default: return GL_RGBA;
+    }
+}
+
+GLenum Internal_Format(int channels, bool gamma)
+{
+    // only color data is stored in srgb, single/dual channel textures are always linear data
+    switch (channels) {
+    case 1:  return GL_R8;
+    case 2:  return GL_RG8;
+    case 3:  return gamma ? GL_SRGB8 : GL_RGB8;
+    default: return gamma ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+    }
+}
+
+// the level data of an image one after another, as it is laid out in the pixel buffer
+void Copy_Levels(Decoded_Image const& decoded, std::vector<Mipmap::Level> const& mips, std::size_t offset, std::size_t size, Byte* target)
+{
+    auto copy = [&](const Byte* data, std::size_t level_size) {
+        if (offset >= level_size) {
+            offset -= level_size;
+            return;
+        }
+        std::size_t const chunk = std::min(size, level_size - offset);
+        std::memcpy(target, data + offset, chunk);
+        target += chunk;
+        size   -= chunk;
+        offset  = 0;
+    };
+
+    copy(decoded.pixels, decoded.size());
+    for (Mipmap::Level const& level : mips) {
+        copy(level.pixels.data(), level.pixels.size());
+    }
+}
+
+#pragma endregion
+
+GL::Texture_Streamer::Texture_Streamer(uint worker_count, std::size_t bytes_per_frame) : bytes_per_frame{ bytes_per_frame }
+{
+    assert(worker_count > 0 && bytes_per_frame > 0);
+
+    glGenBuffers(1, &pixel_buffer);
+
+    for (uint n = 0; n < worker_count; ++n) {
+        workers.emplace_back([this]() { decode_loop(); });
+    }
+}
+
+GL::Texture_Streamer::~Texture_Streamer()
+{
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& worker : workers) { worker.join(); }
+
+    glDeleteBuffers(1, &pixel_buffer);
+}
+
+uint GL::Texture_Streamer::request(std::string const& file_path, bool gamma)
+{
+    // the placeholder is a single grey pixel, so the texture is complete and can be sampled right away
+    static constexpr uchar placeholder[4] = { 128, 128, 128, 255 };
+
+    uint texture_id = 0;
+    glGenTextures(1, &texture_id);
+    glBindTexture(GL_TEXTURE_2D, texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, placeholder);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+    pending.insert(texture_id);
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        jobs.push_back({ texture_id, file_path, gamma });
+    }
+    wake.notify_one();
+
+    return texture_id;
+}
+
+void GL::Texture_Streamer::update()
+{
+    if (pending.empty()) { return; }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixel_buffer);
+    on_exit(glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0));
+
+    // copy into the pixel buffer until the budget is used up, the transfer to the texture itself
+    // is done asynchronous by the driver once a whole image is staged
+    std::size_t budget = bytes_per_frame;
+    while (budget > 0) {
+        if (!current && !start_upload()) {
+            break;
+        }
+
+        std::size_t const chunk = std::min(budget, current->size - current->staged);
+        void* target = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, current->staged, chunk, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        if (target == nullptr) {
+            std::cerr << "Failed to map the texture upload buffer\n";
+            assert(false);
+            break;
+        }
+        Copy_Levels(*current->image.decoded, current->image.mips, current->staged, chunk, static_cast<Byte*>(target));
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        current->staged += chunk;
+        budget -= chunk;
+
+        if (current->staged == current->size) {
+            finish_upload();
+        }
+    }
+}
+
+bool GL::Texture_Streamer::is_resident(uint texture_id) const
+{
+    return pending.count(texture_id) == 0;
+}
+
+void GL::Texture_Streamer::decode_loop()
+{
+    for (;;) {
+        Job job{};
+        {
+            std::unique_lock<std::mutex> lock{ mutex };
+            wake.wait(lock, [this]() { return stopping || !jobs.empty(); });
+            if (stopping) { return; }
+
+            job = std::move(jobs.front());
+            jobs.pop_front();
+        }
+
+        Image image{};
+        image.texture_id = job.texture_id;
+        image.gamma      = job.gamma;
+        image.decoded    = Image_Cache::Load(job.file_path);
+        if (image.decoded == nullptr) {
+            std::cerr << "Texture failed to load at path: " << job.file_path << '\n';
+        }
+        else {
+            Decoded_Image const& pixels = *image.decoded;
+            image.mips = Mipmap::Generate(pixels.pixels, pixels.x, pixels.y, pixels.channels, image.gamma, Mipmap::box);
+        }
+
+        std::lock_guard<std::mutex> lock{ mutex };
+        decoded.push_back(std::move(image));
+    }
+}
+
+bool GL::Texture_Streamer::start_upload()
+{
+    Image image{};
+    {
+        std::lock_guard<std::mutex> lock{ mutex };
+        if (decoded.empty()) { return false; }
+
+        image = std::move(decoded.front());
+        decoded.pop_front();
+    }
+
+    // a broken file keeps its placeholder
+    if (image.decoded == nullptr) {
+        pending.erase(image.texture_id);
+        return true;
+    }
+
+    Upload upload{};
+    upload.size = image.decoded->size();
+    for (Mipmap::Level const& level : image.mips) {
+        upload.size += level.pixels.size();
+    }
+    upload.image = std::move(image);
+    current = std::move(upload);
+
+    // orphan the old storage, the driver may still read the previous image from it
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, current->size, nullptr, GL_STREAM_DRAW);
+    return true;
+}
+
+void GL::Texture_Streamer::finish_upload()
+{
+    measure_time();
+
+    Image const&         image   = current->image;
+    Decoded_Image const& decoded = *image.decoded;
+
+    // rows of rgb/single channel images are not 4 byte aligned
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    GLenum const internal_format = Internal_Format(decoded.channels, image.gamma);
+    GLenum const pixel_format    = Pixel_Format(decoded.channels);
+
+    // reads from the bound pixel buffer, the levels follow each other
+    glBindTexture(GL_TEXTURE_2D, image.texture_id);
+    glTexImage2D(GL_TEXTURE_2D, 0, internal_format, decoded.x, decoded.y, 0, pixel_format, GL_UNSIGNED_BYTE, nullptr);
+
+    std::size_t offset = decoded.size();
+    for_size (n, image.mips) {
+        Mipmap::Level const& level = image.mips[n];
+        glTexImage2D(GL_TEXTURE_2D, GLint(n + 1), internal_format, level.width, level.height, 0, pixel_format, GL_UNSIGNED_BYTE, reinterpret_cast<const void*>(offset));
+        offset += level.pixels.size();
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(image.mips.size()));
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+    uploaded.emplace_back(image.texture_id, current->size);
+
+    pending.erase(image.texture_id);
+    current.reset();
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Common.h"
+#include "Image_Cache.h"
+#include "Mipmap.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace GL {
+
+// --------------------------------------------------
+// texture streaming: images are decoded (and their mip chain built) on
+// worker threads and uploaded on the render thread through a pixel buffer object, never more than
+// bytes_per_frame per frame. until then a texture shows a 1x1 placeholder,
+// its id stays the same, so meshes can use it right away.
+// --------------------------------------------------
+struct Texture_Streamer {
+
+    Texture_Streamer(uint worker_count = 2, std::size_t bytes_per_frame = 4 << 20);
+    ~Texture_Streamer();
+
+    // needs a gl context, returns immediately with a usable (placeholder) texture
+    uint request(std::string const& file_path, bool gamma = false);
+
+    // render thread only, once per frame
+    void update();
+
+    bool        is_resident(uint texture_id) const;
+    std::size_t pending_count() const { return pending.size(); }
+
+    // every texture that became resident since the last call, with its gpu size (incl. mip chain)
+    using Uploaded = std::vector<std::pair<uint, std::size_t>>;
+    Uploaded take_uploaded() { return std::exchange(uploaded, {}); }
+
+    no_copy_and_assign(Texture_Streamer);
+    no_move_and_assign(Texture_Streamer);
+
+private:
+    struct Job {
+        uint        texture_id = 0;
+        std::string file_path  = {};
+        bool        gamma      = false;
+    };
+
+    struct Image {
+        uint                       texture_id = 0;
+        bool                       gamma      = false;
+        Shared_Image               decoded    = nullptr;
+        std::vector<Mipmap::Level> mips       = {}; // made by the worker as well
+    };
+
+    struct Upload {
+        Image       image  = {};
+        std::size_t size   = 0;
+        std::size_t staged = 0; // bytes already copied into the pixel buffer
+    };
+
+    void decode_loop();
+    bool start_upload();
+    void finish_upload();
+
+    // shared with the workers
+    std::mutex              mutex;
+    std::condition_variable wake;
+    std::deque<Job>         jobs     = {};
+    std::deque<Image>       decoded  = {};
+    bool                    stopping = false;
+
+    std::vector<std::thread> workers = {};
+
+    // render thread only
+    std::size_t              bytes_per_frame = 0;
+    uint                     pixel_buffer    = 0;
+    std::optional<Upload>    current         = {};
+    std::unordered_set<uint> pending         = {};
+    Uploaded                 uploaded        = {};
+};
+
+}
@@ -0,0 +1,459 @@
+#include "Transform.h"
+#include "Cpu.h"
+
+#include <cmath>
+
+#if defined(CPU_SSE2)
+#include <emmintrin.h>
+#endif
+#if defined(CPU_X86)
+#include <immintrin.h>
+#endif
+
+static_assert(sizeof(float3) == 3 * sizeof(float), "the aos kernels expect packed float3");
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+// the first 3 rows of the matrix that is applied: for vectors without the translation,
+// for normals the inverse transpose of the 3x3 part
+struct Coefficients {
+    float m[3][4];
+};
+
+enum Kind {
+    points,
+    vectors,
+    normals
+};
+
+Coefficients Make_Coefficients(float44 const& mat, Kind kind)
+{
+    float44 source = mat;
+    if (kind == normals) {
+        float44 linear = mat;
+        linear.data[0][3] = linear.data[1][3] = linear.data[2][3] = 0.0f;
+        linear.data[3][0] = linear.data[3][1] = linear.data[3][2] = 0.0f;
+        linear.data[3][3] = 1.0f;
+        source = transpose(inverse_affine(linear));
+    }
+
+    Coefficients result{};
+    for (int row = 0; row < 3; ++row) {
+        for (int col = 0; col < 4; ++col) {
+            result.m[row][col] = col == 3 && kind != points ? 0.0f : source.data[row][col];
+        }
+    }
+    return result;
+}
+
+// ---------------------------------------------
+// kernels, one version per instruction set. they all use the same operations in the
+// same order (no fma), so every path gives bit identical results
+// ---------------------------------------------
+
+using AoS_Kernel = void (*)(Coefficients const& c, const float3* in, float3* out, std::size_t count);
+using SoA_Kernel = void (*)(Coefficients const& c, Transform::Float3_Arrays in, Transform::Float3_Arrays out, std::size_t count);
+
+template <bool Normalize>
+void Apply_Scalar(Coefficients const& c, float& x, float& y, float& z)
+{
+    float const tx = c.m[0][0] * x + c.m[0][1] * y + c.m[0][2] * z + c.m[0][3];
+    float const ty = c.m[1][0] * x + c.m[1][1] * y + c.m[1][2] * z + c.m[1][3];
+    float const tz = c.m[2][0] * x + c.m[2][1] * y + c.m[2][2] * z + c.m[2][3];
+    x = tx;
+    y = ty;
+    z = tz;
+
+    if (Normalize) {
+        float const len     = std::sqrt(x * x + y * y + z * z);
+        float const inverse = len > 0.0f ? 1.0f / len : 0.0f; // a zero normal stays zero
+        x = x * inverse;
+        y = y * inverse;
+        z = z * inverse;
+    }
+}
+
+template <bool Normalize>
+void AoS_Scalar(Coefficients const& c, const float3* in, float3* out, std::size_t count)
+{
+    for (std::size_t n = 0; n < count; ++n) {
+        float x = in[n].x, y = in[n].y, z = in[n].z;
+        Apply_Scalar<Normalize>(c, x, y, z);
+        out[n].x = x;
+        out[n].y = y;
+        out[n].z = z;
+    }
+}
+
+template <bool Normalize>
+void SoA_Scalar(Coefficients const& c, Transform::Float3_Arrays in, Transform::Float3_Arrays out, std::size_t first, std::size_t count)
+{
+    for (std::size_t n = first; n < count; ++n) {
+        float x = in.x[n], y = in.y[n], z = in.z[n];
+        Apply_Scalar<Normalize>(c, x, y, z);
+        out.x[n] = x;
+        out.y[n] = y;
+        out.z[n] = z;
+    }
+}
+
+template <bool Normalize>
+void SoA_Scalar(Coefficients const& c, Transform::Float3_Arrays in, Transform::Float3_Arrays out, std::size_t count)
+{
+    SoA_Scalar<Normalize>(c, in, out, 0, count);
+}
+
+#if defined(CPU_SSE2)
+// 4 points per register
+struct Coefficients_SSE2 {
+    __m128 m[3][4];
+
+    explicit Coefficients_SSE2(Coefficients const& c)
+    {
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 4; ++col) { m[row][col] = _mm_set1_ps(c.m[row][col]); }
+        }
+    }
+};
+
+template <bool Normalize>
+void Apply_SSE2(Coefficients_SSE2 const& c, __m128& x, __m128& y, __m128& z)
+{
+    __m128 t[3];
+    for (int row = 0; row < 3; ++row) {
+        __m128 sum = _mm_add_ps(_mm_mul_ps(c.m[row][0], x), _mm_mul_ps(c.m[row][1], y));
+        sum = _mm_add_ps(sum, _mm_mul_ps(c.m[row][2], z));
+        t[row] = _mm_add_ps(sum, c.m[row][3]);
+    }
+    x = t[0];
+    y = t[1];
+    z = t[2];
+
+    if (Normalize) {
+        __m128 const len     = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(x, x), _mm_mul_ps(y, y)), _mm_mul_ps(z, z)));
+        __m128 const inverse = _mm_and_ps(_mm_div_ps(_mm_set1_ps(1.0f), len), _mm_cmpgt_ps(len, _mm_setzero_ps()));
+        x = _mm_mul_ps(x, inverse);
+        y = _mm_mul_ps(y, inverse);
+        z = _mm_mul_ps(z, inverse);
+    }
+}
+
+// [x0 y0 z0 x1] [y1 z1 x2 y2] [z2 x3 y3 z3] <-> [x0..x3] [y0..y3] [z0..z3], per 128 bit lane.
+// the same shuffles work for all register widths, so they are macros
+#define DEINTERLEAVE(shuffle, a, b, c, x, y, z)                 \
+    {                                                           \
+        auto const xy = shuffle(b, c, _MM_SHUFFLE(2, 1, 3, 2)); \
+        auto const yz = shuffle(a, b, _MM_SHUFFLE(1, 0, 2, 1)); \
+        x = shuffle(a, xy, _MM_SHUFFLE(2, 0, 3, 0));            \
+        y = shuffle(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));           \
+        z = shuffle(yz, c, _MM_SHUFFLE(3, 0, 3, 1));            \
+    }
+
+#define INTERLEAVE(shuffle, x, y, z, a, b, c)                   \
+    {                                                           \
+        auto const xy = shuffle(x, y, _MM_SHUFFLE(2, 0, 2, 0)); \
+        auto const yz = shuffle(y, z, _MM_SHUFFLE(3, 1, 3, 1)); \
+        auto const zx = shuffle(z, x, _MM_SHUFFLE(3, 1, 2, 0)); \
+        a = shuffle(xy, zx, _MM_SHUFFLE(2, 0, 2, 0));           \
+        b = shuffle(yz, xy, _MM_SHUFFLE(3, 1, 2, 0));           \
+        c = shuffle(zx, yz, _MM_SHUFFLE(3, 1, 3, 1));           \
+    }
+
+template <bool Normalize>
+void AoS_SSE2(Coefficients const& coefficients, const float3* in, float3* out, std::size_t count)
+{
+    Coefficients_SSE2 const c{ coefficients };
+
+    std::size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        const float* source = &in[n].x;
+        float*       target = &out[n].x;
+
+        __m128 x, y, z;
+        DEINTERLEAVE(_mm_shuffle_ps, _mm_loadu_ps(source), _mm_loadu_ps(source + 4), _mm_loadu_ps(source + 8), x, y, z);
+        Apply_SSE2<Normalize>(c, x, y, z);
+
+        __m128 a, b, d;
+        INTERLEAVE(_mm_shuffle_ps, x, y, z, a, b, d);
+        _mm_storeu_ps(target, a);
+        _mm_storeu_ps(target + 4, b);
+        _mm_storeu_ps(target + 8, d);
+    }
+    AoS_Scalar<Normalize>(coefficients, in + n, out + n, count - n);
+}
+
+template <bool Normalize>
+void SoA_SSE2(Coefficients const& coefficients, Transform::Float3_Arrays in, Transform::Float3_Arrays out, std::size_t count)
+{
+    Coefficients_SSE2 const c{ coefficients };
+
+    std::size_t n = 0;
+    for (; n + 4 <= count; n += 4) {
+        __m128 x = _mm_loadu_ps(in.x + n), y = _mm_loadu_ps(in.y + n), z = _mm_loadu_ps(in.z + n);
+        Apply_SSE2<Normalize>(c, x, y, z);
+        _mm_storeu_ps(out.x + n, x);
+        _mm_storeu_ps(out.y + n, y);
+        _mm_storeu_ps(out.z + n, z);
+    }
+    SoA_Scalar<Normalize>(coefficients, in, out, n, count);
+}
+#endif
+
+#if defined(CPU_X86)
+// 8 points per register
+struct Coefficients_AVX2 {
+    __m256 m[3][4];
+
+    TARGET_AVX2 explicit Coefficients_AVX2(Coefficients const& c)
+    {
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 4; ++col) { m[row][col] = _mm256_set1_ps(c.m[row][col]); }
+        }
+    }
+};
+
+template <bool Normalize>
+TARGET_AVX2 void Apply_AVX2(Coefficients_AVX2 const& c, __m256& x, __m256& y, __m256& z)
+{
+    __m256 t[3];
+    for (int row = 0; row < 3; ++row) {
+        __m256 sum = _mm256_add_ps(_mm256_mul_ps(c.m[row][0], x), _mm256_mul_ps(c.m[row][1], y));
+        sum = _mm256_add_ps(sum, _mm256_mul_ps(c.m[row][2], z));
+        t[row] = _mm256_add_ps(sum, c.m[row][3]);
+    }
+    x = t[0];
+    y = t[1];
+    z = t[2];
+
+    if (Normalize) {
+        __m256 const len     = _mm256_sqrt_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x, x), _mm256_mul_ps(y, y)), _mm256_mul_ps(z, z)));
+        __m256 const inverse = _mm256_and_ps(_mm256_div_ps(_mm256_set1_ps(1.0f), len), _mm256_cmp_ps(len, _mm256_setzero_ps(), _CMP_GT_OQ));
+        x = _mm256_mul_ps(x, inverse);
+        y = _mm256_mul_ps(y, inverse);
+        z = _mm256_mul_ps(z, inverse);
+    }
+}
+
+// the low 128 bit lanes hold the points 0-3, the high ones 4-7
+TARGET_AVX2 __m256 Load_Halves(const float* low, const float* high)
+{
+    return _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(low)), _mm_loadu_ps(high), 1);
+}
+
+TARGET_AVX2 void Store_Halves(float* low, float* high, __m256 value)
+{
+    _mm_storeu_ps(low, _mm256_castps256_ps128(value));
+    _mm_storeu_ps(high, _mm256_extractf128_ps(value, 1));
+}
+
+template <bool Normalize>
+TARGET_AVX2 void AoS_AVX2(Coefficients const& coefficients, const float3* in, float3* out, std::size_t count)
+{
+    Coefficients_AVX2 const c{ coefficients };
+
+    std::size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        const float* source = &in[n].x;
+        float*       target = &out[n].x;
+
+        __m256 x, y, z;
+        DEINTERLEAVE(_mm256_shuffle_ps, Load_Halves(source, source + 12), Load_Halves(source + 4, source + 16), Load_Halves(source + 8, source + 20), x, y, z);
+        Apply_AVX2<Normalize>(c, x, y, z);
+
+        __m256 a, b, d;
+        INTERLEAVE(_mm256_shuffle_ps, x, y, z, a, b, d);
+        Store_Halves(target, target + 12, a);
+        Store_Halves(target + 4, target + 16, b);
+        Store_Halves(target + 8, target + 20, d);
+    }
+    AoS_Scalar<Normalize>(coefficients, in + n, out + n, count - n);
+}
+
+template <bool Normalize>
+TARGET_AVX2 void SoA_AVX2(Coefficients const& coefficients, Transform::Float3_Arrays in, Transform::Float3_Arrays out, std::size_t count)
+{
+    Coefficients_AVX2 const c{ coefficients };
+
+    std::size_t n = 0;
+    for (; n + 8 <= count; n += 8) {
+        __m256 x = _mm256_loadu_ps(in.x + n), y = _mm256_loadu_ps(in.y + n), z = _mm256_loadu_ps(in.z + n);
+        Apply_AVX2<Normalize>(c, x, y, z);
+        _mm256_storeu_ps(out.x + n, x);
+        _mm256_storeu_ps(out.y + n, y);
+        _mm256_storeu_ps(out.z + n, z);
+    }
+    SoA_Scalar<Normalize>(coefficients, in, out, n, count);
+}
+
+// the avx-512 intrinsics of gcc 12 start from deliberately undefined registers and warn about it
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+
+// 16 points per register
+struct Coefficients_AVX512 {
+    __m512 m[3][4];
+
+    TARGET_AVX512 explicit Coefficients_AVX512(Coefficients const& c)
+    {
+        for (int row = 0; row < 3; ++row) {
+            for (int col = 0; col < 4; ++col) { m[row][col] = _mm512_set1_ps(c.m[row][col]); }
+        }
+    }
+};
+
+template <bool Normalize>
+TARGET_AVX512 void Apply_AVX512(Coefficients_AVX512 const& c, __m512& x, __m512& y, __m512& z)
+{
+    __m512 t[3];
+    for (int row = 0; row < 3; ++row) {
+        __m512 sum = _mm512_add_ps(_mm512_mul_ps(c.m[row][0], x), _mm512_mul_ps(c.m[row][1], y));
+        sum = _mm512_add_ps(sum, _mm512_mul_ps(c.m[row][2], z));
+        t[row] = _mm512_add_ps(sum, c.m[row][3]);
+    }
+    x = t[0];
+    y = t[1];
+    z = t[2];
+
+    if (Normalize) {
+        __m512 const    len      = _mm512_sqrt_ps(_mm512_add_ps(_mm512_add_ps(_mm512_mul_ps(x, x), _mm512_mul_ps(y, y)), _mm512_mul_ps(z, z)));
+        __mmask16 const non_zero = _mm512_cmp_ps_mask(len, _mm512_setzero_ps(), _CMP_GT_OQ);
+        __m512 const    inverse  = _mm512_maskz_div_ps(non_zero, _mm512_set1_ps(1.0f), len);
+        x = _mm512_mul_ps(x, inverse);
+        y = _mm512_mul_ps(y, inverse);
+        z = _mm512_mul_ps(z, inverse);
+    }
+}
+
+// the 128 bit lanes hold the points 0-3, 4-7, 8-11 and 12-15
+TARGET_AVX512 __m512 Load_Quarters(const float* source)
+{
+    __m512 value = _mm512_castps128_ps512(_mm_loadu_ps(source));
+    value = _mm512_insertf32x4(value, _mm_loadu_ps(source + 12), 1);
+    value = _mm512_insertf32x4(value, _mm_loadu_ps(source + 24), 2);
+    return _mm512_insertf32x4(value, _mm_loadu_ps(source + 36), 3);
+}
+
+TARGET_AVX512 void Store_Quarters(float* target, __m512 value)
+{
+    _mm_storeu_ps(target, _mm512_castps512_ps128(value));
+    _mm_storeu_ps(target + 12, _mm512_extractf32x4_ps(value, 1));
+    _mm_storeu_ps(target + 24, _mm512_extractf32x4_ps(value, 2));
+    _mm_storeu_ps(target + 36, _mm512_extractf32x4_ps(value, 3));
+}
+
+template <bool Normalize>
+TARGET_AVX512 void AoS_AVX512(Coefficients const& coefficients, const float3* in, float3* out, std::size_t count)
+{
+    Coefficients_AVX512 const c{ coefficients };
+
+    std::size_t n = 0;
+    for (; n + 16 <= count; n += 16) {
+        const float* source = &in[n].x;
+        float*       target = &out[n].x;
+
+        __m512 x, y, z;
+        DEINTERLEAVE(_mm512_shuffle_ps, Load_Quarters(source), Load_Quarters(source + 4), Load_Quarters(source + 8), x, y, z);
+        Apply_AVX512<Normalize>(c, x, y, z);
+
+        __m512 a, b, d;
+        INTERLEAVE(_mm512_shuffle_ps, x, y, z, a, b, d);
+        Store_Quarters(target, a);
+        Store_Quarters(target + 4, b);
+        Store_Quarters(target + 8, d);
+    }
+    AoS_Scalar<Normalize>(coefficients, in + n, out + n, count - n);
+}
+
+template <bool Normalize>
+TARGET_AVX512 void SoA_AVX512(Coefficients const& coefficients, Transform::Float3_Arrays in, Transform::Float3_Arrays out, std::size_t count)
+{
+    Coefficients_AVX512 const c{ coefficients };
+
+    std::size_t n = 0;
+    for (; n + 16 <= count; n += 16) {
+        __m512 x = _mm512_loadu_ps(in.x + n), y = _mm512_loadu_ps(in.y + n), z = _mm512_loadu_ps(in.z + n);
+        Apply_AVX512<Normalize>(c, x, y, z);
+        _mm512_storeu_ps(out.x + n, x);
+        _mm512_storeu_ps(out.y + n, y);
+        _mm512_storeu_ps(out.z + n, z);
+    }
+    SoA_Scalar<Normalize>(coefficients, in, out, n, count);
+}
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+#undef DEINTERLEAVE
+#undef INTERLEAVE
+
+struct Kernels {
+    AoS_Kernel aos = nullptr;
+    SoA_Kernel soa = nullptr;
+};
+
+template <bool Normalize>
+Kernels Select_Kernels(Transform::Path path)
+{
+    if (path == Transform::scalar) {
+        return { AoS_Scalar<Normalize>, SoA_Scalar<Normalize> };
+    }
+#if defined(CPU_X86) && defined(CPU_SSE2)
+    Cpu_Features const& features = Get_Cpu_Features();
+    if ((path == Transform::best || path == Transform::avx512) && features.avx512) {
+        return { AoS_AVX512<Normalize>, SoA_AVX512<Normalize> };
+    }
+    if (path != Transform::sse2 && features.avx2) {
+        return { AoS_AVX2<Normalize>, SoA_AVX2<Normalize> };
+    }
+#endif
+#if defined(CPU_SSE2)
+    return { AoS_SSE2<Normalize>, SoA_SSE2<Normalize> };
+#else
+    return { AoS_Scalar<Normalize>, SoA_Scalar<Normalize> };
+#endif
+}
+
+Kernels Select_Kernels(Kind kind, Transform::Path path)
+{
+    return kind == normals ? Select_Kernels<true>(path) : Select_Kernels<false>(path);
+}
+
+#pragma endregion
+
+void Transform::Points(float44 const& mat, const float3* in, float3* out, std::size_t count, Path path)
+{
+    Select_Kernels(points, path).aos(Make_Coefficients(mat, points), in, out, count);
+}
+
+void Transform::Points(float44 const& mat, Float3_Arrays in, Float3_Arrays out, std::size_t count, Path path)
+{
+    Select_Kernels(points, path).soa(Make_Coefficients(mat, points), in, out, count);
+}
+
+void Transform::Vectors(float44 const& mat, const float3* in, float3* out, std::size_t count, Path path)
+{
+    Select_Kernels(vectors, path).aos(Make_Coefficients(mat, vectors), in, out, count);
+}
+
+void Transform::Vectors(float44 const& mat, Float3_Arrays in, Float3_Arrays out, std::size_t count, Path path)
+{
+    Select_Kernels(vectors, path).soa(Make_Coefficients(mat, vectors), in, out, count);
+}
+
+void Transform::Normals(float44 const& mat, const float3* in, float3* out, std::size_t count, Path path)
+{
+    Select_Kernels(normals, path).aos(Make_Coefficients(mat, normals), in, out, count);
+}
+
+void Transform::Normals(float44 const& mat, Float3_Arrays in, Float3_Arrays out, std::size_t count, Path path)
+{
+    Select_Kernels(normals, path).soa(Make_Coefficients(mat, normals), in, out, count);
+}
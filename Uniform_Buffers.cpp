@@ -0,0 +1,150 @@
+#include "Uniform_Buffers.h"
+#include "GL_Extensions.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <glad/glad.h>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+// the biggest offset alignment gl asks for (uniform & storage buffers), the regions are multiples of it
+constexpr std::size_t Region_Alignment = 256;
+
+constexpr GLbitfield Persistent_Flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+void Wait_And_Delete(void*& fence)
+{
+    if (fence == nullptr) {
+        return;
+    }
+    GLsync const sync = static_cast<GLsync>(fence);
+    GLenum result = GL_TIMEOUT_EXPIRED;
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 1'000'000'000); // 1 s
+    }
+    glDeleteSync(sync);
+    fence = nullptr;
+}
+
+#pragma endregion
+
+// ---------------------------------------------
+// frame block
+// ---------------------------------------------
+#pragma region "Frame block"
+GL::Frame_Block::Frame_Block()
+{
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, buffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(Frame_Uniforms), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+GL::Frame_Block::~Frame_Block()
+{
+    glDeleteBuffers(1, &buffer);
+}
+
+void GL::Frame_Block::update(Frame_Uniforms const& frame)
+{
+    glBindBufferBase(GL_UNIFORM_BUFFER, Frame_Binding, buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Frame_Uniforms), &frame);
+}
+#pragma endregion
+
+// ---------------------------------------------
+// stream buffer
+// ---------------------------------------------
+#pragma region "Stream buffer"
+GL::Stream_Buffer::~Stream_Buffer()
+{
+    release();
+}
+
+std::size_t GL::Stream_Buffer::write(const void* data, std::size_t bytes, std::size_t alignment)
+{
+    assert(alignment != 0 && Region_Alignment % alignment == 0);
+
+    std::size_t start = (region_used + alignment - 1) / alignment * alignment;
+    if (buffer == 0 || start + bytes > region_size) {
+        // the draws that were already submitted keep reading the old buffer
+        reserve(std::max(region_size * 2, start + bytes));
+        start = 0;
+    }
+
+    // gl may still read this region from Frame_Count frames ago
+    if (region_used == 0) {
+        Wait_And_Delete(fences[region]);
+    }
+
+    std::size_t const offset = region * region_size + start;
+    if (mapped) {
+        std::memcpy(mapped + offset, data, bytes);
+    }
+    else {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, GLintptr(offset), GLsizeiptr(bytes), data);
+    }
+    region_used = start + bytes;
+    return offset;
+}
+
+void GL::Stream_Buffer::next_frame()
+{
+    if (buffer == 0) {
+        return;
+    }
+    if (mapped && region_used != 0) {
+        fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+    region      = (region + 1) % Frame_Count;
+    region_used = 0;
+}
+
+void GL::Stream_Buffer::reserve(std::size_t region_bytes)
+{
+    release();
+
+    region_size = (region_bytes + Region_Alignment - 1) / Region_Alignment * Region_Alignment;
+    GLsizeiptr const size = GLsizeiptr(region_size * Frame_Count);
+
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (Get_Extensions().buffer_storage) {
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, Persistent_Flags);
+        mapped = static_cast<u8*>(glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, Persistent_Flags));
+        assert(mapped != nullptr);
+    }
+    else {
+        glBufferData(GL_COPY_WRITE_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+void GL::Stream_Buffer::release()
+{
+    if (buffer == 0) {
+        return;
+    }
+    for (void*& fence : fences) {
+        if (fence != nullptr) {
+            glDeleteSync(static_cast<GLsync>(fence));
+            fence = nullptr;
+        }
+    }
+    if (mapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        mapped = nullptr;
+    }
+    glDeleteBuffers(1, &buffer);
+    buffer      = 0;
+    region      = 0;
+    region_used = 0;
+}
+#pragma endregion
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "Common.h"
+#include "Matrix.h"
+
+#include <array>
+
+namespace GL {
+
+// binding points of the blocks the shaders share
+constexpr uint Draw_Binding  = 0; // std430 buffer Draws of the indirect shaders, per draw data
+constexpr uint Frame_Binding = 1; // std140 uniform Frame, per frame data
+
+// the std140 block Frame, row_major in the shaders like float44 stores it
+struct Frame_Uniforms {
+    float44 view       = identity44();
+    float44 projection = identity44();
+    float   time       = 0.0f; // seconds
+    float   padding[3] = {};
+};
+static_assert(sizeof(Frame_Uniforms) == 144, "std140 layout of the shader block");
+
+// --------------------------------------------------
+// the Frame block every shader reads view, projection & time from: one
+// upload per frame instead of setting them in every program. a Shader
+// binds its Frame block to Frame_Binding when it links
+// --------------------------------------------------
+struct Frame_Block {
+
+    Frame_Block(); // needs a context
+    ~Frame_Block();
+
+    void update(Frame_Uniforms const& frame);
+
+    no_copy_and_assign(Frame_Block);
+    no_move_and_assign(Frame_Block);
+
+private:
+    uint buffer = 0;
+};
+
+// --------------------------------------------------
+// data that is written every frame while gl still reads the last ones:
+// a ring of Frame_Count regions in one buffer, a frame only writes its own.
+// with buffer storage (4.4) the buffer stays mapped (persistent & coherent),
+// write() is a memcpy and next_frame() waits on the fence of the frame that
+// used the region Frame_Count frames ago, which normally has long finished.
+// without it write() is one glBufferSubData into the region.
+// the regions grow to the biggest frame seen, nothing is allocated after that
+// --------------------------------------------------
+struct Stream_Buffer {
+    static constexpr std::size_t Frame_Count = 3;
+
+    Stream_Buffer() = default; // the buffer is created by the first write, needs a context then
+    ~Stream_Buffer();
+
+    // copies the bytes into the region of this frame, returns their offset in the buffer (a multiple of alignment)
+    std::size_t write(const void* data, std::size_t bytes, std::size_t alignment);
+
+    // after the draws that read this frame were submitted
+    void next_frame();
+
+    uint id() const { return buffer; }
+
+    no_copy_and_assign(Stream_Buffer);
+    no_move_and_assign(Stream_Buffer);
+
+private:
+    void reserve(std::size_t region_bytes);
+    void release();
+
+    uint        buffer       = 0;
+    u8*         mapped       = nullptr; // the whole buffer, nullptr without buffer storage
+    std::size_t region_size  = 0;
+    std::size_t region       = 0; // of this frame
+    std::size_t region_used  = 0;
+
+    std::array<void*, Frame_Count> fences = {}; // GLsync of the last frame that used each region
+};
+
+}
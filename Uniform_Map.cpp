@@ -0,0 +1,49 @@
+#include "Uniform_Map.h"
+
+#include <algorithm>
+
+void Uniform_Map::insert(Uniform uniform, int location)
+{
+    // at most half full, a lookup finds its slot or an empty one within a few probes
+    if ((count + 1) * 2 > slots.size()) {
+        std::vector<Slot> const old_slots = std::move(slots);
+        slots.assign(std::max<std::size_t>(8, old_slots.size() * 2), Slot{});
+        count = 0;
+        for (Slot const& slot : old_slots) {
+            if (slot.hash != 0) {
+                insert(Uniform{ slot.hash }, slot.location);
+            }
+        }
+    }
+
+    u64 const   hash = uniform.hash != 0 ? uniform.hash : 1;
+    std::size_t n    = hash & (slots.size() - 1);
+    while (slots[n].hash != 0 && slots[n].hash != hash) {
+        n = (n + 1) & (slots.size() - 1);
+    }
+    count += slots[n].hash == 0 ? 1 : 0;
+    slots[n] = { hash, location };
+}
+
+int Uniform_Map::find(Uniform uniform) const
+{
+    if (slots.empty()) {
+        return -1;
+    }
+    u64 const   hash = uniform.hash != 0 ? uniform.hash : 1;
+    std::size_t n    = hash & (slots.size() - 1);
+    while (slots[n].hash != 0) {
+        if (slots[n].hash == hash) {
+            return slots[n].location;
+        }
+        n = (n + 1) & (slots.size() - 1);
+    }
+    return -1;
+}
+
+int Uniform_Map::at(Uniform uniform) const
+{
+    int const location = find(uniform);
+    assert(location != -1 && "the uniform is not in the list of the shader");
+    return location;
+}
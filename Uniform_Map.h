@@ -0,0 +1,31 @@
+#pragma once
+
+#include "Common.h"
+#include "Hash.h"
+
+#include <vector>
+
+// a uniform name hashed at compile time: "model"_uniform is only an integer
+// at runtime, send_value finds the location without any string work
+struct Uniform {
+    u64 hash = 0;
+};
+constexpr Uniform operator""_uniform(const char* name, std::size_t size)
+{
+    return { Fnv1a(name, size) };
+}
+
+// the locations of the listed uniforms of a program by name hash,
+// open addressing with linear probing in a power of two table
+struct Uniform_Map {
+    void insert(Uniform uniform, int location); // a hash that is already in replaces the location
+    int  find(Uniform uniform) const; // -1 if it wasn't listed
+    int  at(Uniform uniform) const;   // has to be listed
+
+    struct Slot {
+        u64 hash     = 0; // 0: empty
+        int location = -1;
+    };
+    std::vector<Slot> slots = {};
+    std::size_t       count = 0;
+};
@@ -4,8 +4,17 @@
 // templated mathematical vector
 // --------------------------------------------------
 
+#include "Cpu.h"
+
+#include <cmath>
 #include <cstddef>
 
+#if defined(CPU_SSE2)
+#include <emmintrin.h>
+#elif defined(CPU_NEON)
+#include <arm_neon.h>
+#endif
+
 // --------------------------------------------------
 // generic base
 // --------------------------------------------------
@@ -29,7 +38,7 @@ template <class Type>
 struct Vector<Type, 3> {
 
     Vector() : x(0), y(0), z(0) {}
-    Vector(Type v) : x(v), y(v), z() {}
+    Vector(Type v) : x(v), y(v), z(v) {}
     Vector(Type X, Type Y, Type Z) : x(X), y(Y), z(Z) {}
 
     union {
@@ -40,17 +49,177 @@ struct Vector<Type, 3> {
 
 template <class Type>
 struct Vector<Type, 4> {
+
+    Vector() : x(0), y(0), z(0), w(0) {}
+    Vector(Type v) : x(v), y(v), z(v), w(v) {}
+    Vector(Type X, Type Y, Type Z, Type W) : x(X), y(Y), z(Z), w(W) {}
+
     union {
         Type data[4];
         struct { Type x, y, z, w; };
     };
 };
 
+// --------------------------------------------------
+// 4 float lanes in one register: sse2 on x86, neon on arm64,
+// a plain array everywhere else. only what the vectors need
+// --------------------------------------------------
+namespace Simd {
+
+#if defined(CPU_SSE2)
+using Register = __m128;
+
+inline Register load(const float* p)                 { return _mm_loadu_ps(p); }
+inline void     store(float* p, Register a)          { _mm_storeu_ps(p, a); }
+inline Register splat(float v)                       { return _mm_set1_ps(v); }
+inline Register set(float x, float y, float z, float w) { return _mm_set_ps(w, z, y, x); }
+inline Register add(Register a, Register b)          { return _mm_add_ps(a, b); }
+inline Register sub(Register a, Register b)          { return _mm_sub_ps(a, b); }
+inline Register mul(Register a, Register b)          { return _mm_mul_ps(a, b); }
+inline Register div(Register a, Register b)          { return _mm_div_ps(a, b); }
+inline Register sqrt(Register a)                     { return _mm_sqrt_ps(a); }
+inline float    first(Register a)                    { return _mm_cvtss_f32(a); }
+
+// the sum of all lanes in every lane
+inline Register horizontal_sum(Register a)
+{
+    a = _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_add_ps(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+// (y, z, x, w) and (z, x, y, w)
+inline Register yzx(Register a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1)); }
+inline Register zxy(Register a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 1, 0, 2)); }
+
+// the 4 registers as the rows of a 4x4 matrix
+inline void transpose(Register& a, Register& b, Register& c, Register& d)
+{
+    _MM_TRANSPOSE4_PS(a, b, c, d);
+}
+
+#elif defined(CPU_NEON)
+using Register = float32x4_t;
+
+inline Register load(const float* p)                 { return vld1q_f32(p); }
+inline void     store(float* p, Register a)          { vst1q_f32(p, a); }
+inline Register splat(float v)                       { return vdupq_n_f32(v); }
+inline Register set(float x, float y, float z, float w) { float const v[4] = { x, y, z, w }; return vld1q_f32(v); }
+inline Register add(Register a, Register b)          { return vaddq_f32(a, b); }
+inline Register sub(Register a, Register b)          { return vsubq_f32(a, b); }
+inline Register mul(Register a, Register b)          { return vmulq_f32(a, b); }
+inline Register div(Register a, Register b)          { return vdivq_f32(a, b); }
+inline Register sqrt(Register a)                     { return vsqrtq_f32(a); }
+inline float    first(Register a)                    { return vgetq_lane_f32(a, 0); }
+
+inline Register horizontal_sum(Register a)
+{
+    return vdupq_n_f32(vaddvq_f32(a));
+}
+
+inline Register yzx(Register a) { return set(vgetq_lane_f32(a, 1), vgetq_lane_f32(a, 2), vgetq_lane_f32(a, 0), vgetq_lane_f32(a, 3)); }
+inline Register zxy(Register a) { return set(vgetq_lane_f32(a, 2), vgetq_lane_f32(a, 0), vgetq_lane_f32(a, 1), vgetq_lane_f32(a, 3)); }
+
+inline void transpose(Register& a, Register& b, Register& c, Register& d)
+{
+    float32x4x2_t const ab = vtrnq_f32(a, b); // a0 b0 a2 b2 | a1 b1 a3 b3
+    float32x4x2_t const cd = vtrnq_f32(c, d);
+    a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+
+#else
+struct Register {
+    float lanes[4];
+};
+
+template <class Operation>
+Register per_lane(Register a, Register b, Operation operation)
+{
+    Register result;
+    for (int n = 0; n < 4; ++n) { result.lanes[n] = operation(a.lanes[n], b.lanes[n]); }
+    return result;
+}
+
+inline Register load(const float* p)                 { return { p[0], p[1], p[2], p[3] }; }
+inline void     store(float* p, Register a)          { for (int n = 0; n < 4; ++n) { p[n] = a.lanes[n]; } }
+inline Register splat(float v)                       { return { v, v, v, v }; }
+inline Register set(float x, float y, float z, float w) { return { x, y, z, w }; }
+inline Register add(Register a, Register b)          { return per_lane(a, b, [](float l, float r) { return l + r; }); }
+inline Register sub(Register a, Register b)          { return per_lane(a, b, [](float l, float r) { return l - r; }); }
+inline Register mul(Register a, Register b)          { return per_lane(a, b, [](float l, float r) { return l * r; }); }
+inline Register div(Register a, Register b)          { return per_lane(a, b, [](float l, float r) { return l / r; }); }
+inline Register sqrt(Register a)                     { return per_lane(a, a, [](float l, float) { return std::sqrt(l); }); }
+inline float    first(Register a)                    { return a.lanes[0]; }
+
+inline Register horizontal_sum(Register a)
+{
+    return splat((a.lanes[0] + a.lanes[1]) + (a.lanes[2] + a.lanes[3]));
+}
+
+inline Register yzx(Register a) { return { a.lanes[1], a.lanes[2], a.lanes[0], a.lanes[3] }; }
+inline Register zxy(Register a) { return { a.lanes[2], a.lanes[0], a.lanes[1], a.lanes[3] }; }
+
+inline void transpose(Register& a, Register& b, Register& c, Register& d)
+{
+    Register* rows[4] = { &a, &b, &c, &d };
+    for (int row = 0; row < 4; ++row) {
+        for (int col = row + 1; col < 4; ++col) {
+            float const swapped = rows[row]->lanes[col];
+            rows[row]->lanes[col] = rows[col]->lanes[row];
+            rows[col]->lanes[row] = swapped;
+        }
+    }
+}
+#endif
+
+}
+
+// --------------------------------------------------
+// float vectors on top of the simd registers
+// --------------------------------------------------
+template <>
+struct alignas(16) Vector<float, 4> {
+
+    Vector() : simd(Simd::splat(0.0f)) {}
+    Vector(float v) : simd(Simd::splat(v)) {}
+    Vector(float X, float Y, float Z, float W) : simd(Simd::set(X, Y, Z, W)) {}
+    Vector(Vector<float, 3> const& v, float W) : simd(Simd::set(v.x, v.y, v.z, W)) {}
+    Vector(Simd::Register r) : simd(r) {}
+
+    union {
+        float data[4];
+        struct { float x, y, z, w; };
+        Simd::Register simd;
+    };
+};
+
+// a float3 padded to a whole register (the 4th lane is always 0). for hot math only,
+// everything stored for the gpu (e.g. Vertex) keeps the packed float3
+struct alignas(16) float3a {
+
+    float3a() : simd(Simd::splat(0.0f)) {}
+    float3a(float v) : simd(Simd::set(v, v, v, 0.0f)) {}
+    float3a(float X, float Y, float Z) : simd(Simd::set(X, Y, Z, 0.0f)) {}
+    float3a(Vector<float, 3> const& v) : simd(Simd::set(v.x, v.y, v.z, 0.0f)) {}
+    float3a(Simd::Register r) : simd(r) {}
+
+    operator Vector<float, 3>() const { return { x, y, z }; }
+
+    union {
+        float data[4];
+        struct { float x, y, z, padding; };
+        Simd::Register simd;
+    };
+};
+
 // --------------------------------------------------
 // typedefs for easier access
 // --------------------------------------------------
 using float2 = Vector<float, 2>;
 using float3 = Vector<float, 3>;
+using float4 = Vector<float, 4>;
 
 // --------------------------------------------------
 // generic operations
@@ -98,23 +267,21 @@ Vector<Type, Size> operator - (Vector<Type, Size> const& a, Vector<Type, Size> c
 }
 
 template <class Type, std::size_t Size>
-Vector<Type, Size> operator += (Vector<Type, Size> const& a, Vector<Type, Size> const& b)
+Vector<Type, Size>& operator += (Vector<Type, Size>& a, Vector<Type, Size> const& b)
 {
-    Vector<Type, Size> result;
     for (std::size_t n = 0; n < Size; ++n) {
-        result.data[n] = a.data[n] + b.data[n];
+        a.data[n] += b.data[n];
     }
-    return result;
+    return a;
 }
 
 template <class Type, std::size_t Size>
-Vector<Type, Size> operator -= (Vector<Type, Size> const& a, Vector<Type, Size> const& b)
+Vector<Type, Size>& operator -= (Vector<Type, Size>& a, Vector<Type, Size> const& b)
 {
-    Vector<Type, Size> result;
     for (std::size_t n = 0; n < Size; ++n) {
-        result.data[n] = a.data[n] - b.data[n];
+        a.data[n] -= b.data[n];
     }
-    return result;
+    return a;
 }
 
 template <class Type, std::size_t Size>
@@ -155,7 +322,7 @@ Type dot_product(Vector<Type, Size> const& a, Vector<Type, Size> const& b)
 {
     Type result = 0;
     for (std::size_t n = 0; n < Size; ++n) {
-        result += a[n] + b[n];
+        result += a.data[n] * b.data[n];
     }
     return result;
 }
@@ -187,12 +354,56 @@ Type length(Vector<Type, Size> const& vec)
 template <class Type, std::size_t Size>
 Vector<Type, Size> normalize(Vector<Type, Size> const& vec)
 {
-    Vector<Type, Size> result;
+    Vector<Type, Size> result = vec; // a zero vector stays zero
     Type const len = length(vec);
     if (len != Type(0)) {
         for (std::size_t n = 0; n < Size; ++n) {
-            result[n] = vec[n] * (Type(1) / len);
+            result.data[n] = vec.data[n] * (Type(1) / len);
         }
     }
     return result;
-}
\ No newline at end of file
+}
+// --------------------------------------------------
+// simd float4/float3a operations, picked over the generic templates
+// --------------------------------------------------
+inline float4 operator + (float4 const& a, float4 const& b) { return Simd::add(a.simd, b.simd); }
+inline float4 operator - (float4 const& a, float4 const& b) { return Simd::sub(a.simd, b.simd); }
+inline float4 operator * (float4 const& a, float const& v)  { return Simd::mul(a.simd, Simd::splat(v)); }
+inline float4 operator * (float const& v, float4 const& a)  { return Simd::mul(a.simd, Simd::splat(v)); }
+inline float4 operator / (float4 const& a, float const& v)  { return Simd::div(a.simd, Simd::splat(v)); }
+inline float4& operator += (float4& a, float4 const& b)     { a.simd = Simd::add(a.simd, b.simd); return a; }
+inline float4& operator -= (float4& a, float4 const& b)     { a.simd = Simd::sub(a.simd, b.simd); return a; }
+
+inline float  dot_product(float4 const& a, float4 const& b) { return Simd::first(Simd::horizontal_sum(Simd::mul(a.simd, b.simd))); }
+inline float  squared_length(float4 const& vec)             { return dot_product(vec, vec); }
+inline float  length(float4 const& vec)                     { return std::sqrt(dot_product(vec, vec)); }
+
+inline float4 normalize(float4 const& vec)
+{
+    Simd::Register const len = Simd::sqrt(Simd::horizontal_sum(Simd::mul(vec.simd, vec.simd)));
+    return Simd::first(len) != 0.0f ? float4{ Simd::mul(vec.simd, Simd::div(Simd::splat(1.0f), len)) } : vec;
+}
+
+inline float3a operator + (float3a const& a, float3a const& b) { return Simd::add(a.simd, b.simd); }
+inline float3a operator - (float3a const& a, float3a const& b) { return Simd::sub(a.simd, b.simd); }
+inline float3a operator * (float3a const& a, float const& v)   { return Simd::mul(a.simd, Simd::splat(v)); }
+inline float3a operator * (float const& v, float3a const& a)   { return Simd::mul(a.simd, Simd::splat(v)); }
+inline float3a operator / (float3a const& a, float const& v)   { return Simd::div(a.simd, Simd::set(v, v, v, 1.0f)); } // keeps the padding 0
+inline float3a& operator += (float3a& a, float3a const& b)     { a.simd = Simd::add(a.simd, b.simd); return a; }
+inline float3a& operator -= (float3a& a, float3a const& b)     { a.simd = Simd::sub(a.simd, b.simd); return a; }
+
+inline float   dot_product(float3a const& a, float3a const& b) { return Simd::first(Simd::horizontal_sum(Simd::mul(a.simd, b.simd))); }
+inline float   squared_length(float3a const& vec)              { return dot_product(vec, vec); }
+inline float   length(float3a const& vec)                      { return std::sqrt(dot_product(vec, vec)); }
+
+inline float3a normalize(float3a const& vec)
+{
+    Simd::Register const len = Simd::sqrt(Simd::horizontal_sum(Simd::mul(vec.simd, vec.simd)));
+    return Simd::first(len) != 0.0f ? float3a{ Simd::mul(vec.simd, Simd::div(Simd::splat(1.0f), len)) } : vec;
+}
+
+inline float3a cross_product(float3a const& a, float3a const& b)
+{
+    // the 4th lane is a.w * b.w - a.w * b.w = 0
+    return Simd::sub(Simd::mul(Simd::yzx(a.simd), Simd::zxy(b.simd)), Simd::mul(Simd::zxy(a.simd), Simd::yzx(b.simd)));
+}
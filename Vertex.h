@@ -2,6 +2,7 @@
 
 #include "Vector.h" // math-vec
 #include <vector>   // stl-vec
+#include <cassert>
 
 
 struct Vertex {
@@ -12,3 +13,45 @@ struct Vertex {
     float3 bitangent;
 };
 using Vertices = std::vector<Vertex>;
+
+
+// split layout: the positions in one stream, everything else in a second one.
+// position only work (depth/shadow passes, bounds, transforms) reads 12 instead of 56 bytes per vertex
+struct Vertex_Attributes {
+    float3 normal;
+    float2 tex_coord;
+    float3 tangent;
+    float3 bitangent;
+};
+
+struct Vertex_Streams {
+    std::vector<float3>            positions  = {};
+    std::vector<Vertex_Attributes> attributes = {}; // same length as positions
+
+    std::size_t size() const { return positions.size(); }
+};
+
+inline Vertex_Streams Split_Vertices(Vertices const& vertices)
+{
+    Vertex_Streams streams{};
+    streams.positions.resize(vertices.size());
+    streams.attributes.resize(vertices.size());
+    for (std::size_t n = 0; n < vertices.size(); ++n) {
+        Vertex const& v = vertices[n];
+        streams.positions[n]  = v.position;
+        streams.attributes[n] = { v.normal, v.tex_coord, v.tangent, v.bitangent };
+    }
+    return streams;
+}
+
+inline Vertices Interleave_Vertices(Vertex_Streams const& streams)
+{
+    assert(streams.positions.size() == streams.attributes.size());
+
+    Vertices vertices(streams.size());
+    for (std::size_t n = 0; n < vertices.size(); ++n) {
+        Vertex_Attributes const& a = streams.attributes[n];
+        vertices[n] = { streams.positions[n], a.normal, a.tex_coord, a.tangent, a.bitangent };
+    }
+    return vertices;
+}
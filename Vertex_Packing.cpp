@@ -0,0 +1,267 @@
+#include "Vertex_Packing.h"
+#include "Profiling.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+// ---------------------------------------------
+// module internal code
+// ---------------------------------------------
+#pragma region "Module internal"
+
+float Sign(float value)
+{
+    return value >= 0.0f ? 1.0f : -1.0f;
+}
+
+// the gl conversion of normalized signed integers (4.2+)
+float From_Snorm(int value, int bits)
+{
+    float const max = float((1 << (bits - 1)) - 1);
+    return std::max(float(value) / max, -1.0f);
+}
+
+// octahedral with the given bits per component: rounding each component on its own is
+// not the closest direction, so all 4 neighbours are tried
+void Quantize_Octahedral(float3 direction, int bits, int& x, int& y)
+{
+    x = y = 0;
+    if (length(direction) == 0.0f) {
+        return;
+    }
+    direction = normalize(direction);
+
+    float const  max     = float((1 << (bits - 1)) - 1);
+    float2 const encoded = Vertex_Packing::Encode_Octahedral(direction);
+    int const    base_x  = int(std::floor(encoded.x * max));
+    int const    base_y  = int(std::floor(encoded.y * max));
+
+    float best = -2.0f;
+    for (int dy = 0; dy <= 1; ++dy) {
+        for (int dx = 0; dx <= 1; ++dx) {
+            int const cx = std::clamp(base_x + dx, -int(max), int(max));
+            int const cy = std::clamp(base_y + dy, -int(max), int(max));
+
+            float const similarity = dot_product(direction, Vertex_Packing::Decode_Octahedral({ From_Snorm(cx, bits), From_Snorm(cy, bits) }));
+            if (similarity > best) {
+                best = similarity;
+                x    = cx;
+                y    = cy;
+            }
+        }
+    }
+}
+
+u32 Pack_Tangent(float3 tangent, float sign)
+{
+    int x, y;
+    Quantize_Octahedral(tangent, 10, x, y);
+    u32 const w = sign < 0.0f ? 3u : 1u; // -1 / +1 as 2 bit two's complement
+    return (u32(x) & 0x3FF) | ((u32(y) & 0x3FF) << 10) | (w << 30);
+}
+
+int Field(u32 packed, int shift, int bits)
+{
+    // sign extend the bit field
+    int const value = int(packed << (32 - shift - bits));
+    return value >> (32 - bits);
+}
+
+// atan2 in double, acos of a float dot product can't resolve angles below ~0.0005
+float Angle(float3 a, float3 b)
+{
+    double const cx = double(a.y) * b.z - double(a.z) * b.y;
+    double const cy = double(a.z) * b.x - double(a.x) * b.z;
+    double const cz = double(a.x) * b.y - double(a.y) * b.x;
+    double const d  = double(a.x) * b.x + double(a.y) * b.y + double(a.z) * b.z;
+    return float(std::atan2(std::sqrt(cx * cx + cy * cy + cz * cz), d));
+}
+
+#pragma endregion
+
+float2 Vertex_Packing::Encode_Octahedral(float3 direction)
+{
+    float const sum = std::abs(direction.x) + std::abs(direction.y) + std::abs(direction.z);
+    if (sum == 0.0f) {
+        return { 0.0f, 0.0f };
+    }
+
+    float x = direction.x / sum;
+    float y = direction.y / sum;
+    if (direction.z < 0.0f) {
+        // fold the lower half over the diagonals
+        float const folded_x = (1.0f - std::abs(y)) * Sign(x);
+        float const folded_y = (1.0f - std::abs(x)) * Sign(y);
+        x = folded_x;
+        y = folded_y;
+    }
+    return { x, y };
+}
+
+float3 Vertex_Packing::Decode_Octahedral(float2 encoded)
+{
+    float3 direction{ encoded.x, encoded.y, 1.0f - std::abs(encoded.x) - std::abs(encoded.y) };
+    float const t = std::max(-direction.z, 0.0f);
+    direction.x += direction.x >= 0.0f ? -t : t;
+    direction.y += direction.y >= 0.0f ? -t : t;
+    return normalize(direction);
+}
+
+u16 Vertex_Packing::To_Half(float value)
+{
+    u32 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    u32 const sign      = (bits >> 16) & 0x8000;
+    u32 const magnitude = bits & 0x7FFFFFFF;
+
+    if (magnitude >= 0x7F800000) { // inf & nan
+        return u16(sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 : 0));
+    }
+    if (magnitude >= 0x477FF000) { // rounds above 65504
+        return u16(sign | 0x7C00);
+    }
+    if (magnitude < 0x38800000) { // below 2^-14: denormal half, exact in float math
+        float absolute;
+        std::memcpy(&absolute, &magnitude, sizeof(absolute));
+        return u16(sign | u32(std::nearbyint(absolute * 16777216.0f)));
+    }
+
+    u32 const rounded = magnitude + 0x0FFF + ((magnitude >> 13) & 1); // to nearest even
+    return u16(sign | ((rounded - 0x38000000) >> 13));
+}
+
+float Vertex_Packing::From_Half(u16 value)
+{
+    u32 const sign     = u32(value & 0x8000) << 16;
+    u32 const exponent = (value >> 10) & 0x1F;
+    u32 const mantissa = value & 0x3FF;
+
+    if (exponent == 0) {
+        float const absolute = float(mantissa) / 16777216.0f;
+        return sign ? -absolute : absolute;
+    }
+
+    u32 const bits = exponent == 31
+        ? sign | 0x7F800000 | (mantissa << 13)
+        : sign | ((exponent + 112) << 23) | (mantissa << 13);
+    float result;
+    std::memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+Packed_Vertices Vertex_Packing::Pack(Vertices const& vertices)
+{
+    measure_time();
+
+    Packed_Vertices packed{};
+    packed.vertices.resize(vertices.size());
+    if (vertices.empty()) {
+        return packed;
+    }
+
+    float3 low{ FLT_MAX, FLT_MAX, FLT_MAX };
+    float3 high{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+    for (Vertex const& v : vertices) {
+        for (int c = 0; c < 3; ++c) {
+            low.data[c]  = std::min(low.data[c], v.position.data[c]);
+            high.data[c] = std::max(high.data[c], v.position.data[c]);
+        }
+    }
+    packed.position_offset = low;
+    packed.position_scale  = high - low;
+
+    for_size (n, vertices) {
+        Vertex const&  v = vertices[n];
+        Packed_Vertex& p = packed.vertices[n];
+
+        for (int c = 0; c < 3; ++c) {
+            float const extent   = packed.position_scale.data[c];
+            float const relative = extent > 0.0f ? (v.position.data[c] - low.data[c]) / extent : 0.0f;
+            p.position[c] = u16(std::lround(std::clamp(relative, 0.0f, 1.0f) * 65535.0f));
+        }
+        p.position[3] = 0;
+
+        int x, y;
+        Quantize_Octahedral(v.normal, 16, x, y);
+        p.normal[0] = i16(x);
+        p.normal[1] = i16(y);
+
+        float const handedness = dot_product(cross_product(v.normal, v.tangent), v.bitangent);
+        p.tangent = Pack_Tangent(v.tangent, Sign(handedness));
+
+        p.tex_coord[0] = To_Half(v.tex_coord.x);
+        p.tex_coord[1] = To_Half(v.tex_coord.y);
+    }
+
+#ifdef _DEBUG
+    Error const error = Measure_Error(vertices, packed);
+    assert(error.position  <= Max_Position_Error);
+    assert(error.normal    <= Max_Normal_Error);
+    assert(error.tangent   <= Max_Tangent_Error);
+    assert(error.tex_coord <= Max_Tex_Coord_Error);
+#endif
+
+    return packed;
+}
+
+Vertices Vertex_Packing::Unpack(Packed_Vertices const& packed)
+{
+    Vertices vertices(packed.size());
+    for_size (n, vertices) {
+        Packed_Vertex const& p = packed.vertices[n];
+        Vertex&              v = vertices[n];
+
+        for (int c = 0; c < 3; ++c) {
+            v.position.data[c] = packed.position_offset.data[c] + float(p.position[c]) / 65535.0f * packed.position_scale.data[c];
+        }
+
+        v.normal  = Decode_Octahedral({ From_Snorm(p.normal[0], 16), From_Snorm(p.normal[1], 16) });
+        v.tangent = Decode_Octahedral({ From_Snorm(Field(p.tangent, 0, 10), 10), From_Snorm(Field(p.tangent, 10, 10), 10) });
+
+        float const sign = Sign(float(Field(p.tangent, 30, 2)));
+        v.bitangent = cross_product(v.normal, v.tangent) * sign;
+
+        v.tex_coord.x = From_Half(p.tex_coord[0]);
+        v.tex_coord.y = From_Half(p.tex_coord[1]);
+    }
+    return vertices;
+}
+
+Vertex_Packing::Error Vertex_Packing::Measure_Error(Vertices const& original, Packed_Vertices const& packed)
+{
+    assert(original.size() == packed.size());
+
+    Error error{};
+    Vertices const unpacked = Unpack(packed);
+
+    float const extent = std::max({ packed.position_scale.x, packed.position_scale.y, packed.position_scale.z });
+    for_size (n, original) {
+        Vertex const& a = original[n];
+        Vertex const& b = unpacked[n];
+
+        if (extent > 0.0f) {
+            for (int c = 0; c < 3; ++c) {
+                error.position = std::max(error.position, std::abs(a.position.data[c] - b.position.data[c]) / extent);
+            }
+        }
+
+        if (length(a.normal) > 0.0f) {
+            error.normal = std::max(error.normal, Angle(normalize(a.normal), b.normal));
+        }
+        if (length(a.tangent) > 0.0f) {
+            error.tangent = std::max(error.tangent, Angle(normalize(a.tangent), b.tangent));
+        }
+        if (length(a.bitangent) > 0.0f && length(b.bitangent) > 0.0f) {
+            error.bitangent = std::max(error.bitangent, Angle(normalize(a.bitangent), normalize(b.bitangent)));
+        }
+
+        for (int c = 0; c < 2; ++c) {
+            float const magnitude = std::max(std::abs(a.tex_coord.data[c]), 1.0f);
+            error.tex_coord = std::max(error.tex_coord, std::abs(a.tex_coord.data[c] - b.tex_coord.data[c]) / magnitude);
+        }
+    }
+    return error;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+// --------------------------------------------------
+// packed vertex format: 20 instead of 56 bytes per vertex
+//   position   unorm16 inside the bounds of the mesh
+//   normal     octahedral, snorm16
+//   tangent    octahedral, snorm10, bitangent sign in the 2 bit w
+//   tex coord  half floats
+// the bitangent is rebuilt as sign * cross(normal, tangent),
+// shader/model_loading_packed.vertex has the matching decode
+// --------------------------------------------------
+
+#include "Common.h"
+#include "Vertex.h"
+
+struct Packed_Vertex {
+    u16 position[4];  // [3] is padding (0), keeps the stride at a multiple of 4
+    i16 normal[2];
+    u32 tangent;      // GL_INT_2_10_10_10_REV: x & y octahedral, w = +1/-1
+    u16 tex_coord[2];
+};
+static_assert(sizeof(Packed_Vertex) == 20, "Packed_Vertex must stay tightly packed");
+
+struct Packed_Vertices {
+    std::vector<Packed_Vertex> vertices = {};
+
+    // position = position_offset + unorm * position_scale, both go to the shader as uniforms
+    float3 position_offset = {};
+    float3 position_scale  = {};
+
+    std::size_t size() const { return vertices.size(); }
+};
+
+namespace Vertex_Packing {
+
+// worst case errors of a pack & unpack round trip (checked in debug builds),
+// the position error is relative to the largest extent of the mesh bounds,
+// the tex coord error is relative to the magnitude of the tex coord (half float)
+constexpr float Max_Position_Error  = 1.0f / 65535.0f;
+constexpr float Max_Normal_Error    = 0.0002f; // radians
+constexpr float Max_Tangent_Error   = 0.005f;  // radians
+constexpr float Max_Tex_Coord_Error = 1.0f / 2048.0f;
+
+Packed_Vertices Pack(Vertices const& vertices);
+Vertices        Unpack(Packed_Vertices const& packed);
+
+struct Error {
+    float position  = 0.0f; // relative to the largest extent
+    float normal    = 0.0f; // radians
+    float tangent   = 0.0f; // radians
+    float tex_coord = 0.0f; // relative
+    float bitangent = 0.0f; // radians, only small if the tangent frame was orthogonal
+};
+
+// normals & tangents of zero length (missing attributes) are skipped
+Error Measure_Error(Vertices const& original, Packed_Vertices const& packed);
+
+// building blocks, the same math as the shader decode
+float2 Encode_Octahedral(float3 direction); // any length, 0 gives (0, 0)
+float3 Decode_Octahedral(float2 encoded);   // unit length
+u16    To_Half(float value);                // round to nearest even
+float  From_Half(u16 value);
+
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+// --------------------------------------------------
+// minimal test & benchmark helpers. every Test_*.cpp is its own
+// program (see the Makefile): main() runs the checks, with --bench
+// it also runs the benchmarks, the exit code is the failure count
+// --------------------------------------------------
+
+#include "../Common.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace Test {
+
+inline int& Failure_Count()
+{
+    static int count = 0;
+    return count;
+}
+
+inline void Fail(const char* file, int line, const char* expression)
+{
+    std::cerr << file << ':' << line << ": check failed: " << expression << '\n';
+    Failure_Count()++;
+}
+
+inline bool Bench_Requested(int argc, char** argv)
+{
+    return argc > 1 && std::strcmp(argv[1], "--bench") == 0;
+}
+
+// prints the summary, the result is what main() returns
+inline int Result(const char* name)
+{
+    std::cout << name << ": " << (Failure_Count() == 0 ? "ok" : "FAILED") << '\n';
+    return Failure_Count();
+}
+
+// mean nanoseconds per call over count calls
+template <class Function>
+double Time_Per_Call(u64 count, Function&& function)
+{
+    using Clock = std::chrono::steady_clock;
+    auto const start = Clock::now();
+    for (u64 n = 0; n < count; ++n) {
+        function();
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / double(count);
+}
+
+inline void Print_Bench(const char* name, double nanoseconds)
+{
+    std::cout << "  " << name << ": ";
+    if (nanoseconds >= 1e6)      { std::cout << nanoseconds / 1e6 << " ms\n"; }
+    else if (nanoseconds >= 1e3) { std::cout << nanoseconds / 1e3 << " us\n"; }
+    else                         { std::cout << nanoseconds << " ns\n"; }
+}
+
+}
+
+// keeps going after a failure, so one run shows all of them
+#define check(condition) \
+    do { if (!(condition)) { Test::Fail(__FILE__, __LINE__, #condition); } } while (false)
+
+#define check_near(value, expected, tolerance) \
+    do { if (!(std::abs(double(value) - double(expected)) <= double(tolerance))) { \
+        Test::Fail(__FILE__, __LINE__, #value " ~ " #expected); } } while (false)
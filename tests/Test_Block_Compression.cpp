@@ -0,0 +1,198 @@
+#include "Test.h"
+#include "../Block_Compression.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+Block_Format const Formats[] = { bc1, bc3, bc5, bc7 };
+const char*  const Format_Names[] = { "bc1", "bc3", "bc5", "bc7" };
+
+// smooth gradients with a little noise, like most texture content (the same slope at every size)
+Bytes Test_Image(int width, int height, u32 seed, int noise)
+{
+    std::mt19937 random{ seed };
+    Bytes rgba(std::size_t(width) * height * 4);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            uchar* pixel = rgba.data() + (std::size_t(y) * width + x) * 4;
+            int const base[4] = { (x * 3) % 256, (y * 3) % 256, (x + y + 64) % 256, 255 - (x * 2) % 256 };
+            for (int c = 0; c < 4; ++c) {
+                int const offset = noise > 0 ? int(random() % (2 * noise + 1)) - noise : 0;
+                pixel[c] = uchar(std::clamp(base[c] + offset, 0, 255));
+            }
+        }
+    }
+    return rgba;
+}
+
+// the channels a format stores: bc1 has no alpha, bc5 only red & green
+bool Stored(Block_Format format, int channel)
+{
+    return format == bc5 ? channel < 2 : format == bc1 ? channel < 3 : true;
+}
+
+struct Error {
+    int    max  = 0;
+    double rmse = 0.0;
+};
+
+Error Measure(Block_Format format, const uchar* a, const uchar* b, std::size_t pixel_count)
+{
+    Error error{};
+    double sum = 0.0;
+    int    count = 0;
+    for (std::size_t n = 0; n < pixel_count; ++n) {
+        for (int c = 0; c < 4; ++c) {
+            if (!Stored(format, c)) { continue; }
+            int const d = int(a[n * 4 + c]) - int(b[n * 4 + c]);
+            error.max = std::max(error.max, std::abs(d));
+            sum += d * d;
+            ++count;
+        }
+    }
+    error.rmse = std::sqrt(sum / std::max(count, 1));
+    return error;
+}
+
+Error Round_Trip_Block(Block_Format format, const uchar rgba[64], uchar decoded[64])
+{
+    Byte block[16];
+    Encode_Block(format, rgba, block);
+    Decode_Block(format, block, decoded);
+    return Measure(format, rgba, decoded, 16);
+}
+
+void Check_Constant_Blocks()
+{
+    std::mt19937 random{ 1 };
+    for (int n = 0; n < 200; ++n) {
+        uchar const color[4] = { uchar(random()), uchar(random()), uchar(random()), uchar(random()) };
+        uchar rgba[64], decoded[64];
+        for (int p = 0; p < 16; ++p) { std::copy(color, color + 4, rgba + p * 4); }
+
+        // 565 rounding for the bc1 colors, 7 bits + a shared p-bit for bc7
+        check(Round_Trip_Block(bc1, rgba, decoded).max <= 4);
+        check(Round_Trip_Block(bc3, rgba, decoded).max <= 4);
+        check(decoded[3] == color[3] && decoded[63] == color[3]);
+        check(Round_Trip_Block(bc5, rgba, decoded).max == 0);
+        check(decoded[2] == 0 && decoded[3] == 255);
+        check(Round_Trip_Block(bc7, rgba, decoded).max <= 1);
+    }
+}
+
+// two colors in a random pattern. bc1 & bc3 refine the endpoints onto both colors, bc7 keeps
+// the endpoints 1/16 inside the range (no least squares pass) and a step of its 16 values off
+void Check_Two_Color_Blocks()
+{
+    std::mt19937 random{ 2 };
+    for (int n = 0; n < 200; ++n) {
+        uchar const colors[2][4] = {
+            { uchar(random()), uchar(random()), uchar(random()), uchar(random()) },
+            { uchar(random()), uchar(random()), uchar(random()), uchar(random()) },
+        };
+        uchar rgba[64], decoded[64];
+        for (int p = 0; p < 16; ++p) {
+            const uchar* color = colors[random() % 2];
+            std::copy(color, color + 4, rgba + p * 4);
+        }
+
+        check(Round_Trip_Block(bc1, rgba, decoded).max <= 4);
+        check(Round_Trip_Block(bc3, rgba, decoded).max <= 4);
+        check(Round_Trip_Block(bc5, rgba, decoded).max == 0);
+        check(Round_Trip_Block(bc7, rgba, decoded).max <= 16);
+    }
+}
+
+void Check_Images()
+{
+    // error bounds of smooth content with some noise, from the quality of the encoders at the time of writing
+    double const max_rmse[]  = { 3.5, 3.0, 1.0, 3.0 };
+    int    const max_error[] = { 16, 16, 2, 14 };
+
+    for (auto [width, height] : { std::pair{ 64, 64 }, std::pair{ 13, 7 }, std::pair{ 1, 1 }, std::pair{ 5, 18 } }) {
+        Bytes const rgba = Test_Image(width, height, u32(width * height), 4);
+
+        // blocks past the border repeat the edge pixels, like an image padded to whole blocks
+        int const padded_width = Block_Count(width) * 4, padded_height = Block_Count(height) * 4;
+        Bytes padded(std::size_t(padded_width) * padded_height * 4);
+        for (int y = 0; y < padded_height; ++y) {
+            for (int x = 0; x < padded_width; ++x) {
+                int const source = std::min(y, height - 1) * width + std::min(x, width - 1);
+                std::copy_n(rgba.data() + source * 4, 4, padded.data() + (std::size_t(y) * padded_width + x) * 4);
+            }
+        }
+
+        for_size (f, Formats) {
+            Block_Format const format = Formats[f];
+            Bytes const blocks = Compress_Image(format, rgba.data(), width, height);
+            check(blocks.size() == std::size_t(Block_Count(width)) * Block_Count(height) * Block_Bytes(format));
+            check(blocks == Compress_Image(format, padded.data(), padded_width, padded_height));
+            check(blocks == Compress_Image(format, rgba.data(), width, height, 3));
+
+            // the decoder writes the pixels inside the image and nothing else
+            Bytes decoded(rgba.size() + 64, 0xCD);
+            Decompress_Image(format, blocks.data(), width, height, decoded.data());
+            check(std::all_of(decoded.end() - 64, decoded.end(), [](uchar value) { return value == 0xCD; }));
+
+            Error const error = Measure(format, rgba.data(), decoded.data(), std::size_t(width) * height);
+            if (error.rmse > max_rmse[f] || error.max > max_error[f]) {
+                std::cerr << Format_Names[f] << ' ' << width << 'x' << height << ": rmse " << error.rmse << ", max " << error.max << '\n';
+            }
+            check(error.rmse <= max_rmse[f] && error.max <= max_error[f]);
+        }
+    }
+}
+
+// random pixels give many ties between palette entries, the lower index has to win on both paths
+void Check_Paths_Match()
+{
+    for (int noise : { 0, 8, 128 }) {
+        Bytes const rgba = Test_Image(67, 33, u32(noise + 3), noise);
+        for (Block_Format format : Formats) {
+            check(Compress_Image(format, rgba.data(), 67, 33, 1, block_best) ==
+                  Compress_Image(format, rgba.data(), 67, 33, 1, block_scalar));
+        }
+    }
+}
+
+void Check_Other_BC7_Modes()
+{
+    // mode m starts with m zero bits and a one, 8 zero bits are reserved
+    uchar rgba[64];
+    for (u32 mode = 0; mode <= 8; ++mode) {
+        if (mode == 6) { continue; }
+        Byte block[16];
+        std::fill(block, block + 16, Byte(0xA5));
+        block[0] = mode == 8 ? Byte(0) : Byte((block[0] & ~((2u << mode) - 1)) | (1u << mode));
+        Decode_Block(bc7, block, rgba);
+        check(std::all_of(rgba, rgba + 64, [](uchar value) { return value == 0; }));
+    }
+
+    std::fill(rgba, rgba + 64, uchar(200));
+    Byte block[16];
+    Encode_Block(bc7, rgba, block);
+    check(block[0] == 1 << 6);
+}
+
+int main(int argc, char** argv)
+{
+    Check_Constant_Blocks();
+    Check_Two_Color_Blocks();
+    Check_Images();
+    Check_Paths_Match();
+    Check_Other_BC7_Modes();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Bytes const rgba = Test_Image(512, 512, 7, 8);
+        std::cout << "Compress_Image of a 512x512 image, one thread:\n";
+        for_size (f, Formats) {
+            for (Block_Path path : { block_scalar, block_best }) {
+                std::string const name = std::string(Format_Names[f]) + (path == block_best ? " best" : " scalar");
+                Test::Print_Bench(name.c_str(), Test::Time_Per_Call(3, [&] { Compress_Image(Formats[f], rgba.data(), 512, 512, 1, path); }));
+            }
+        }
+    }
+
+    return Test::Result("Block_Compression");
+}
@@ -0,0 +1,62 @@
+#include "Test.h"
+#include "../Image_Cache.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+// binary ppm, the pixels depend on seed so different seeds are different content
+void Write_Image(fs::path const& path, int size, int seed)
+{
+    std::ofstream file{ path, std::ios::binary };
+    file << "P6\n" << size << ' ' << size << "\n255\n";
+    for (int n = 0; n < size * size * 3; ++n) {
+        file.put(char((n * 7 + seed * 31) & 0xff));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    fs::path const directory = fs::temp_directory_path() / "image_cache_test";
+    fs::create_directories(directory / "sub");
+    fs::path const original = directory / "image.ppm";
+    fs::path const copy     = directory / "copy.ppm";
+    fs::path const other    = directory / "other.ppm";
+    Write_Image(original, 64, 0);
+    Write_Image(copy, 64, 0);
+    Write_Image(other, 64, 1);
+
+    // one decode per content, however the file is named
+    Shared_Image const image = Image_Cache::Load(original.string());
+    check(image && image->x == 64 && image->y == 64 && image->channels == 3);
+    check(Image_Cache::Load(original.string()) == image);
+    check(Image_Cache::Load((directory / "sub" / ".." / "image.ppm").string()) == image);
+    check(Image_Cache::Load(copy.string()) == image);
+    check(Image_Cache::Load(other.string()) != image);
+    check(Image_Cache::Load((directory / "missing.ppm").string()) == nullptr);
+
+    Image_Cache::Stats stats = Image_Cache::Get_Stats();
+    check(stats.misses == 2 && stats.hits == 3);
+    check(stats.bytes_cached == 2 * image->size());
+
+    // evicted images stay alive for their holders
+    Image_Cache::Set_Budget(0);
+    stats = Image_Cache::Get_Stats();
+    check(stats.bytes_cached == 0 && stats.evictions == 2);
+    check(image->pixels != nullptr);
+    Image_Cache::Set_Budget(std::size_t(256) << 20);
+
+    if (Test::Bench_Requested(argc, argv)) {
+        fs::path const big = directory / "big.ppm";
+        Write_Image(big, 1024, 2);
+        std::string const path = big.string();
+
+        std::cout << "image cache, 1024x1024 rgb:\n";
+        Test::Print_Bench("miss (hash & decode)", Test::Time_Per_Call(1, [&] { Image_Cache::Load(path); }));
+        Test::Print_Bench("hit", Test::Time_Per_Call(100'000, [&] { Image_Cache::Load(path); }));
+    }
+
+    fs::remove_all(directory);
+    return Test::Result("Image_Cache");
+}
@@ -0,0 +1,151 @@
+#include "Test.h"
+#include "../Indirect_Commands.h"
+
+#include <string>
+#include <vector>
+
+// an arena mesh: a range of the shared buffers of its VAO, 4 levels of 3000, 1200, 300 & 60 indices
+Mesh Arena_Mesh(uint VAO, uint index_size, u32 first, float3 center)
+{
+    Mesh mesh{};
+    mesh.VAO             = VAO;
+    mesh.index_size      = index_size;
+    mesh.in_arena        = true;
+    mesh.base_vertex     = first * 2;
+    mesh.index_offset    = u64(first) * index_size;
+    mesh.lods            = { { 0, 3000, 0.0f }, { 3000, 1200, 0.002f }, { 4200, 300, 0.01f }, { 4500, 60, 0.05f } };
+    mesh.bounding_center = center;
+    mesh.bounding_radius = 1.0f;
+    return mesh;
+}
+
+Textures const Bricks = { { 10, "bricks.png", Texture::diffuse }, { 11, "bricks_normal.png", Texture::normal } };
+Textures const Stone  = { { 12, "stone.png", Texture::diffuse } };
+
+void Check_Runs()
+{
+    Meshes meshes{};
+    meshes.push_back(Arena_Mesh(1, 2, 0, {}));
+    meshes.push_back(Arena_Mesh(1, 2, 4560, {}));
+    meshes.push_back(Arena_Mesh(2, 2, 0, {}));    // another VAO
+    meshes.push_back(Arena_Mesh(2, 4, 100, {}));  // another index size
+    meshes.push_back(Arena_Mesh(2, 4, 9000, {}));
+    meshes[4].textures = Bricks;                  // other textures
+    meshes.push_back(Arena_Mesh(2, 4, 20000, {}));
+    meshes[5].textures = Bricks;
+    meshes.push_back(Arena_Mesh(2, 4, 30000, {}));
+    meshes[6].lods[0].index_count = 0;            // nothing to draw, doesn't end the run
+    meshes.push_back(Arena_Mesh(2, 4, 40000, {}));
+    meshes[7].textures = Bricks;
+    meshes.push_back(Arena_Mesh(2, 4, 50000, {}));
+    meshes[8].textures = Stone;
+
+    float44 model = identity44();
+    model.data[0][3] = 5.0f;
+
+    Indirect_Commands batch{};
+    batch.build(meshes, model, nullptr, 8);
+
+    check(batch.commands.size() == 8);
+    check(batch.runs.size() == 5);
+    u32 const run_sizes[] = { 2, 1, 1, 3, 1 };
+    std::size_t next_command = 0;
+    for_size (n, batch.runs) {
+        Indirect_Commands::Run const& run = batch.runs[n];
+        check(run.command_count == run_sizes[n]);
+        check(run.first_command == next_command);
+        check(run.first_draw % 8 == 0);
+        check(run.first_draw + run.command_count <= batch.draws.size());
+        next_command += run.command_count;
+    }
+    check(batch.runs[2].index_size == 4 && batch.runs[1].index_size == 2);
+    check(batch.runs[3].first_mesh == &meshes[4]);
+
+    // full detail, the first index counts in indices of the mesh's own size
+    check(batch.commands[1].count == 3000);
+    check(batch.commands[1].first_index == 4560);
+    check(batch.commands[1].base_vertex == 4560 * 2);
+    check(batch.commands[1].instance_count == 1);
+    check(batch.commands[3].first_index == 100);
+    check(batch.draws[batch.runs[3].first_draw + 2].model == model);
+    check(batch.draws[0].position_scale.x == 1.0f && batch.draws[0].position_offset.x == 0.0f);
+
+    // the capacity stays, the contents don't
+    batch.build({}, model, nullptr, 8);
+    check(batch.commands.empty() && batch.draws.empty() && batch.runs.empty());
+}
+
+void Check_Levels()
+{
+    Meshes meshes{};
+    for (float distance : { 0.5f, 20.0f, 200.0f, 2000.0f, 1e6f }) {
+        meshes.push_back(Arena_Mesh(1, 4, 0, { 0.0f, 0.0f, -distance }));
+    }
+    meshes.push_back(Arena_Mesh(1, 4, 0, { 0.0f, 0.0f, -50.0f }));
+    meshes.back().layout = Mesh::packed;
+    meshes.back().packed_vertices.position_offset = { 1.0f, 2.0f, 3.0f };
+    meshes.back().packed_vertices.position_scale  = { 0.5f, 0.25f, 0.125f };
+
+    Lod_View const view = Make_Lod_View({}, identity44(), 1.0f, 1080);
+    Indirect_Commands batch{};
+    batch.build(meshes, view.model, &view, 1);
+
+    check(batch.commands.size() == meshes.size());
+    for_size (n, meshes) {
+        Mesh_Lod const lod = meshes[n].lod(Select_Lod(meshes[n], view));
+        check(batch.commands[n].count == lod.index_count);
+        check(batch.commands[n].first_index == lod.first_index);
+    }
+    // inside the sphere full detail, far away the coarsest level
+    check(batch.commands[0].count == 3000);
+    check(batch.commands[4].count == 60);
+    check(batch.commands[1].count > batch.commands[4].count);
+
+    Draw_Data const& packed = batch.draws.back();
+    check(packed.position_offset.y == 2.0f && packed.position_scale.z == 0.125f);
+}
+
+// a scene of arenas: 16 VAOs with a few texture sets each, meshes spread over a large area
+Meshes Bench_Scene(std::size_t count)
+{
+    std::vector<Textures> texture_sets(4);
+    for_size (n, texture_sets) { texture_sets[n] = { { uint(n + 1), "", Texture::diffuse }, { uint(n + 100), "", Texture::normal } }; }
+
+    Meshes meshes(count);
+    for_size (n, meshes) {
+        float const x = float(n % 317) * 3.0f, z = float(n / 317) * 3.0f;
+        uint const VAO = uint(1 + n * 16 / count);
+        meshes[n] = Arena_Mesh(VAO, 2 << (VAO % 2), u32(n * 4560), { x, 0.0f, -z });
+        meshes[n].textures = texture_sets[(n / 64) % texture_sets.size()];
+    }
+    return meshes;
+}
+
+void Bench()
+{
+    Indirect_Commands batch{};
+    std::cout << "Indirect_Commands::build (us per call, ns per mesh):\n";
+    for (std::size_t count : { 10000, 50000, 100000 }) {
+        Meshes const meshes = Bench_Scene(count);
+        Lod_View const view = Make_Lod_View({ 450.0f, 10.0f, 0.0f }, identity44(), 1.0f, 1080);
+        batch.build(meshes, identity44(), &view, 8);
+
+        for (bool lod : { false, true }) {
+            double const ns = Test::Time_Per_Call(20, [&] { batch.build(meshes, identity44(), lod ? &view : nullptr, 8); });
+            std::cout << "  " << count << " meshes, " << (lod ? "lod selection: " : "full detail:   ") << ns / 1e3 << " us, "
+                      << ns / double(count) << " ns per mesh, " << batch.runs.size() << " runs\n";
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Check_Runs();
+    Check_Levels();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Bench();
+    }
+
+    return Test::Result("Indirect_Commands");
+}
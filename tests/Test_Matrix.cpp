@@ -0,0 +1,195 @@
+#include "Test.h"
+#include "../Matrix.h"
+
+#include <algorithm>
+#include <random>
+
+using double44 = Matrix<double, 4, 4>;
+
+std::mt19937                          random_engine{ 7 };
+std::uniform_real_distribution<float> random_value{ -2.0f, 2.0f };
+
+float44 Random_Matrix()
+{
+    float44 result;
+    for (auto& row : result.data) {
+        for (float& value : row) { value = random_value(random_engine); }
+    }
+    return result;
+}
+
+float4 Random_Unit_Quaternion()
+{
+    return normalize(float4{ random_value(random_engine), random_value(random_engine), random_value(random_engine), random_value(random_engine) });
+}
+
+double44 To_Double(float44 const& mat)
+{
+    double44 result;
+    for (int row = 0; row < 4; ++row) {
+        for (int col = 0; col < 4; ++col) { result.data[row][col] = mat.data[row][col]; }
+    }
+    return result;
+}
+
+double Max_Difference(float44 const& a, double44 const& b)
+{
+    double worst = 0.0;
+    for (int row = 0; row < 4; ++row) {
+        for (int col = 0; col < 4; ++col) { worst = std::max(worst, std::abs(a.data[row][col] - b.data[row][col])); }
+    }
+    return worst;
+}
+
+// element wise, the double versions are the reference
+void Check_Scalar_Operations()
+{
+    for (int n = 0; n < 1000; ++n) {
+        float44 const  mat    = Random_Matrix();
+        double44 const exact  = To_Double(mat);
+        float const    value  = random_value(random_engine);
+        double const   scalar = value;
+
+        for (int row = 0; row < 4; ++row) {
+            for (int col = 0; col < 4; ++col) {
+                double const element = exact.data[row][col];
+                check_near((mat + value).data[row][col], element + scalar, 1e-6);
+                check_near((value + mat).data[row][col], scalar + element, 1e-6);
+                check_near((mat - value).data[row][col], element - scalar, 1e-6);
+                check_near((value - mat).data[row][col], scalar - element, 1e-6);
+                check_near((mat * value).data[row][col], element * scalar, 1e-6);
+                check_near((value * mat).data[row][col], scalar * element, 1e-6);
+                check_near((mat / value).data[row][col], element / scalar, 1e-3);
+            }
+        }
+        check(Max_Difference(mat + mat, exact + exact) == 0.0);
+        check(Max_Difference(mat - mat, double44(0.0)) == 0.0);
+    }
+}
+
+void Check_Products()
+{
+    double worst_product = 0.0, worst_vector = 0.0, worst_inverse = 0.0, worst_affine = 0.0;
+    for (int n = 0; n < 10'000; ++n) {
+        float44 const a = Random_Matrix(), b = Random_Matrix();
+        worst_product = std::max(worst_product, Max_Difference(a * b, To_Double(a) * To_Double(b)));
+        check(Max_Difference(transpose(a), transpose(To_Double(a))) == 0.0);
+
+        float4 const           vec{ random_value(random_engine), random_value(random_engine), random_value(random_engine), random_value(random_engine) };
+        Vector<double, 4> const exact_vec{ vec.x, vec.y, vec.z, vec.w };
+        float4 const            product = a * vec;
+        Vector<double, 4> const exact   = To_Double(a) * exact_vec;
+        for (int k = 0; k < 4; ++k) { worst_vector = std::max(worst_vector, std::abs(product.data[k] - exact.data[k])); }
+
+        // well conditioned: identity plus some noise
+        float44 near_identity = identity44();
+        for (auto& row : near_identity.data) {
+            for (float& value : row) { value += random_value(random_engine) * 0.2f; }
+        }
+        worst_inverse = std::max(worst_inverse, Max_Difference(near_identity * inverse(near_identity), To_Double(identity44())));
+
+        float3 const  offset{ random_value(random_engine), random_value(random_engine), random_value(random_engine) };
+        float3 const  scale{ 0.5f + std::abs(random_value(random_engine)), 0.5f + std::abs(random_value(random_engine)), 0.5f + std::abs(random_value(random_engine)) };
+        float44 const affine = compose_trs(offset, Random_Unit_Quaternion(), scale);
+        worst_affine = std::max(worst_affine, Max_Difference(inverse_affine(affine), To_Double(inverse(affine))));
+    }
+    check(worst_product <= 1e-5);
+    check(worst_vector <= 1e-5);
+    check(worst_inverse <= 1e-5);
+    check(worst_affine <= 1e-5);
+}
+
+void Check_Builders()
+{
+    float4 const  q        = normalize(float4{ 0.3f, -0.2f, 0.5f, 0.8f });
+    float44 const composed = compose_trs({ 1, 2, 3 }, q, { 2, 3, 4 });
+    check(Max_Difference(composed, To_Double(translation({ 1, 2, 3 }) * rotation(q) * scaling({ 2, 3, 4 }))) <= 1e-6);
+
+    // the near plane corner ends up in the ndc corner, the far plane at depth 1
+    float44 const projection = perspective(3.14159265f / 2.0f, 2.0f, 1.0f, 100.0f);
+    float4 const  corner     = projection * float4{ 2, 1, -1, 1 };
+    check_near(corner.x / corner.w, 1.0, 1e-6);
+    check_near(corner.y / corner.w, 1.0, 1e-6);
+    check_near(corner.z / corner.w, -1.0, 1e-6);
+    float4 const far_point = projection * float4{ 0, 0, -100, 1 };
+    check_near(far_point.z / far_point.w, 1.0, 1e-6);
+
+    float4 const ortho = orthographic(-2, 2, -1, 1, 0.5f, 10) * float4{ 2, 1, -10, 1 };
+    check_near(ortho.x, 1.0, 1e-6);
+    check_near(ortho.y, 1.0, 1e-6);
+    check_near(ortho.z, 1.0, 1e-6);
+
+    float3 const viewed = transform_point(look_at({ 0, 0, 5 }, { 0, 0, 0 }, { 0, 1, 0 }), { 1, 2, 0 });
+    check_near(viewed.x, 1.0, 1e-6);
+    check_near(viewed.y, 2.0, 1e-6);
+    check_near(viewed.z, -5.0, 1e-6);
+
+    float3 const rotated = transform_point(rotation(float3{ 0, 0, 1 }, 3.14159265f / 2.0f), { 1, 0, 0 });
+    check_near(rotated.x, 0.0, 1e-6);
+    check_near(rotated.y, 1.0, 1e-6);
+
+    float3 const moved = transform_vector(translation({ 5, 5, 5 }), { 1, 0, 0 });
+    check(moved.x == 1.0f && moved.y == 0.0f && moved.z == 0.0f);
+}
+
+// the simd float44 operations against plain loops over the same data
+void Run_Benchmarks()
+{
+    constexpr std::size_t Count = 1 << 16; // a power of 2, so the index wraps with a mask
+    std::vector<float44> a(Count), b(Count), affine(Count), result(Count);
+    for (std::size_t n = 0; n < Count; ++n) {
+        a[n]      = Random_Matrix();
+        b[n]      = Random_Matrix();
+        affine[n] = compose_trs({ 1, 2, 3 }, Random_Unit_Quaternion(), { 1.5f, 2.0f, 0.7f });
+    }
+
+    std::size_t index = 0;
+    auto next = [&] { index = (index + 1) & (Count - 1); return index; };
+    float4      sink{};
+
+    std::cout << "float44, per matrix:\n";
+    Test::Print_Bench("multiply simd", Test::Time_Per_Call(1 << 22, [&] { std::size_t const n = next(); result[n] = a[n] * b[n]; }));
+    Test::Print_Bench("multiply scalar", Test::Time_Per_Call(1 << 22, [&] {
+        std::size_t const n = next();
+        for (int row = 0; row < 4; ++row) {
+            for (int col = 0; col < 4; ++col) {
+                float sum = 0.0f;
+                for (int k = 0; k < 4; ++k) { sum += a[n].data[row][k] * b[n].data[k][col]; }
+                result[n].data[row][col] = sum;
+            }
+        }
+    }));
+    Test::Print_Bench("matrix * float4 simd", Test::Time_Per_Call(1 << 22, [&] { sink += a[next()] * float4{ 1, 2, 3, 1 }; }));
+    Test::Print_Bench("matrix * float4 scalar", Test::Time_Per_Call(1 << 22, [&] {
+        float44 const& mat = a[next()];
+        float const    vec[4] = { 1, 2, 3, 1 };
+        for (int row = 0; row < 4; ++row) {
+            float sum = 0.0f;
+            for (int k = 0; k < 4; ++k) { sum += mat.data[row][k] * vec[k]; }
+            sink.data[row] += sum;
+        }
+    }));
+    Test::Print_Bench("transpose simd", Test::Time_Per_Call(1 << 22, [&] { std::size_t const n = next(); result[n] = transpose(a[n]); }));
+    Test::Print_Bench("transpose scalar", Test::Time_Per_Call(1 << 22, [&] {
+        std::size_t const n = next();
+        for (int row = 0; row < 4; ++row) {
+            for (int col = 0; col < 4; ++col) { result[n].data[col][row] = a[n].data[row][col]; }
+        }
+    }));
+    Test::Print_Bench("inverse", Test::Time_Per_Call(1 << 22, [&] { std::size_t const n = next(); result[n] = inverse(affine[n]); }));
+    Test::Print_Bench("inverse_affine", Test::Time_Per_Call(1 << 22, [&] { std::size_t const n = next(); result[n] = inverse_affine(affine[n]); }));
+    std::cout << "  (" << sink.x + result[0].data[0][0] << ")\n";
+}
+
+int main(int argc, char** argv)
+{
+    Check_Scalar_Operations();
+    Check_Products();
+    Check_Builders();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Run_Benchmarks();
+    }
+
+    return Test::Result("Matrix");
+}
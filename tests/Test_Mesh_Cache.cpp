@@ -0,0 +1,173 @@
+#include "Test.h"
+#include "../Mesh_Cache.h"
+
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+Mesh Fan(uint vertex_count, uint seed)
+{
+    Mesh mesh{};
+    for (uint n = 0; n < vertex_count; ++n) {
+        Vertex v{};
+        float const f = float(n + seed);
+        v.position  = { f, f * 0.5f, -f };
+        v.normal    = { 0.0f, 1.0f, f * 1e-6f };
+        v.tex_coord = { f * 0.25f, 1.0f - f };
+        v.tangent   = { 1.0f, 0.0f, f };
+        v.bitangent = { 0.0f, f, 1.0f };
+        mesh.vertices.push_back(v);
+    }
+    for (uint n = 1; n + 1 < vertex_count; ++n) {
+        mesh.indices.insert(mesh.indices.end(), { 0, n, n + 1 });
+    }
+    mesh.bounding_center = { float(seed), 2.0f, 3.0f };
+    mesh.bounding_radius = float(vertex_count);
+    return mesh;
+}
+
+bool Same_Mesh(Mesh const& a, Mesh const& b)
+{
+    bool same =
+        a.vertices.size() == b.vertices.size() && a.indices == b.indices &&
+        std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(Vertex)) == 0 &&
+        a.lods.size() == b.lods.size() && a.textures.size() == b.textures.size() &&
+        std::memcmp(&a.bounding_center, &b.bounding_center, sizeof(float3)) == 0 && a.bounding_radius == b.bounding_radius;
+    for (std::size_t n = 0; same && n < a.lods.size(); ++n) {
+        same = a.lods[n].first_index == b.lods[n].first_index && a.lods[n].index_count == b.lods[n].index_count && a.lods[n].error == b.lods[n].error;
+    }
+    for (std::size_t n = 0; same && n < a.textures.size(); ++n) {
+        same = a.textures[n].path == b.textures[n].path && a.textures[n].type == b.textures[n].type;
+    }
+    return same;
+}
+
+std::vector<char> Read_File(fs::path const& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    return { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+}
+
+void Write_File(fs::path const& path, std::vector<char> const& bytes)
+{
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+    file.write(bytes.data(), std::streamsize(bytes.size()));
+}
+
+Mesh_Cache::Key const Key { "models/test.obj", 1234567, 42 };
+
+void Check_Round_Trip(fs::path const& path)
+{
+    Meshes meshes{};
+
+    // 16 bit indices up to the last vertex, lods and textures
+    meshes.push_back(Fan(u32(Max_16_Bit_Vertices), 1));
+    Mesh& small = meshes.back();
+    small.indices.insert(small.indices.end(), { 0, 1, u32(Max_16_Bit_Vertices - 1) });
+    small.lods = { { 0, u32(small.indices.size()), 0.0f }, { 0, 300, 0.01f }, { 3, 3, 0.5f } };
+    small.textures = { { 7, "diffuse.png", Texture::diffuse }, { 8, "textures/normal map.png", Texture::normal } };
+
+    // no data at all
+    meshes.push_back({});
+
+    // one vertex too many for 16 bit indices
+    meshes.push_back(Fan(u32(Max_16_Bit_Vertices + 1), 2));
+    Mesh& large = meshes.back();
+    large.indices.insert(large.indices.end(), { u32(Max_16_Bit_Vertices), 0, 1 });
+    large.textures = { { 0, "height.png", Texture::height }, { 0, "", Texture::specular } };
+
+    meshes.push_back(Fan(3, 3));
+
+    check(Mesh_Cache::Write(path.string(), Key, meshes));
+    std::optional<Meshes> const read = Mesh_Cache::Read(path.string(), Key);
+    check(read && read->size() == meshes.size());
+    if (read && read->size() == meshes.size()) {
+        for_size (n, meshes) {
+            check(Same_Mesh((*read)[n], meshes[n]));
+        }
+        check((*read)[0].textures[0].id == 0);
+    }
+
+    // the index size follows the vertex count: 2 more bytes per index past Max_16_Bit_Vertices
+    check(Mesh_Cache::Write(path.string(), Key, { Fan(u32(Max_16_Bit_Vertices), 0) }));
+    u64 const size_16 = fs::file_size(path);
+    check(Mesh_Cache::Write(path.string(), Key, { Fan(u32(Max_16_Bit_Vertices + 1), 0) }));
+    u64 const size_32 = fs::file_size(path);
+    check(size_32 - size_16 >= (Max_16_Bit_Vertices - 2) * 3 * sizeof(u16));
+    check(Mesh_Cache::Read(path.string(), Key));
+
+    // a different source state or import setting is a different bake
+    Mesh_Cache::Key changed = Key;
+    changed.source_time++;
+    check(!Mesh_Cache::Read(path.string(), changed));
+    changed = Key;
+    changed.import_flags = 0;
+    check(!Mesh_Cache::Read(path.string(), changed));
+    changed = Key;
+    changed.source_path = "models/test.ob";
+    check(!Mesh_Cache::Read(path.string(), changed));
+
+    check(!Mesh_Cache::Read((path.string() + ".missing"), Key));
+}
+
+void Check_Rejected(fs::path const& path)
+{
+    Meshes meshes{ Fan(10, 0) };
+    meshes[0].textures = { { 0, "diffuse.png", Texture::diffuse } };
+    check(Mesh_Cache::Write(path.string(), Key, meshes));
+    check(Mesh_Cache::Read(path.string(), Key));
+    std::vector<char> const bytes = Read_File(path);
+
+    // the version follows the 4 byte magic
+    std::vector<char> patched = bytes;
+    u32 version = 0;
+    std::memcpy(&version, patched.data() + 4, sizeof(version));
+    check(version == Mesh_Cache::Version);
+    version = Mesh_Cache::Version - 1;
+    std::memcpy(patched.data() + 4, &version, sizeof(version));
+    Write_File(path, patched);
+    check(!Mesh_Cache::Read(path.string(), Key));
+
+    patched = bytes;
+    patched[0] = 'X';
+    Write_File(path, patched);
+    check(!Mesh_Cache::Read(path.string(), Key));
+
+    for (std::size_t size : { std::size_t(10), bytes.size() / 2, bytes.size() - 1 }) {
+        Write_File(path, std::vector<char>(bytes.begin(), bytes.begin() + size));
+        check(!Mesh_Cache::Read(path.string(), Key));
+    }
+
+    // the writer stores what it gets, the reader has to catch it
+    Meshes broken = meshes;
+    broken[0].indices.back() = u32(broken[0].vertices.size());
+    check(Mesh_Cache::Write(path.string(), Key, broken));
+    check(!Mesh_Cache::Read(path.string(), Key));
+
+    broken = meshes;
+    broken[0].textures[0].type = Texture::Type(Texture_Type_Count);
+    check(Mesh_Cache::Write(path.string(), Key, broken));
+    check(!Mesh_Cache::Read(path.string(), Key));
+
+    broken = meshes;
+    broken[0].lods = { { 0, u32(broken[0].indices.size()) + 3, 0.0f } };
+    check(Mesh_Cache::Write(path.string(), Key, broken));
+    check(!Mesh_Cache::Read(path.string(), Key));
+
+    // and nothing is left over from a broken one
+    check(Mesh_Cache::Write(path.string(), Key, meshes));
+    check(Mesh_Cache::Read(path.string(), Key));
+}
+
+int main(int argc, char** argv)
+{
+    fs::path const directory = fs::temp_directory_path() / "mesh_cache_test";
+    fs::create_directories(directory);
+
+    Check_Round_Trip(directory / "round_trip.mesh");
+    Check_Rejected(directory / "rejected.mesh");
+
+    fs::remove_all(directory);
+    return Test::Result("Mesh_Cache");
+}
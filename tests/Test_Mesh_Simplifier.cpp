@@ -0,0 +1,212 @@
+#include "Test.h"
+#include "../Mesh_Optimizer.h"
+#include "../Mesh_Simplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <set>
+
+// a bumpy square over -1..1 in x & z with an open border all around. the column at
+// x = 0 is a uv seam: the triangles right of it use copies of its vertices
+Mesh Terrain(uint cells)
+{
+    Mesh mesh{};
+    auto height = [](float x, float z) { return 0.1f * std::sin(x * 3.0f) * std::cos(z * 2.0f) + 0.01f * std::sin(x * 17.0f); };
+    for (uint z = 0; z <= cells; ++z) {
+        for (uint x = 0; x <= cells; ++x) {
+            Vertex v{};
+            float const px = 2.0f * x / cells - 1.0f, pz = 2.0f * z / cells - 1.0f;
+            v.position  = { px, height(px, pz), pz };
+            v.normal    = { 0.0f, 1.0f, 0.0f };
+            v.tex_coord = { px, pz };
+            mesh.vertices.push_back(v);
+        }
+    }
+    uint const seam_column = cells / 2;
+    uint const first_copy  = uint(mesh.vertices.size());
+    for (uint z = 0; z <= cells; ++z) {
+        Vertex copy = mesh.vertices[z * (cells + 1) + seam_column];
+        copy.tex_coord.x += 1.0f;
+        mesh.vertices.push_back(copy);
+    }
+
+    for (uint z = 0; z < cells; ++z) {
+        for (uint x = 0; x < cells; ++x) {
+            auto corner = [&](uint cx, uint cz) { return cx == seam_column && x >= seam_column ? first_copy + cz : cz * (cells + 1) + cx; };
+            uint const a = corner(x, z), b = corner(x, z + 1), c = corner(x + 1, z), d = corner(x + 1, z + 1);
+            mesh.indices.insert(mesh.indices.end(), { a, b, c, c, b, d });
+        }
+    }
+    return mesh;
+}
+
+// on the border of the square or the seam
+bool On_Outline(float3 a, float3 b)
+{
+    for (float line : { -1.0f, 0.0f, 1.0f }) {
+        if (a.x == line && b.x == line) { return true; }
+    }
+    return std::abs(a.z) == 1.0f && a.z == b.z;
+}
+
+// total length in x & z of the edges without an opposite edge, and whether all of them
+// lie on the outline or on the seam
+float Open_Edge_Length(Vertices const& vertices, const uint* indices, std::size_t count, bool& on_outline)
+{
+    std::set<std::pair<uint, uint>> edges{};
+    for (std::size_t n = 0; n < count; n += 3) {
+        for (int c = 0; c < 3; ++c) { edges.insert({ indices[n + c], indices[n + (c + 1) % 3] }); }
+    }
+
+    float length_sum = 0.0f;
+    on_outline = true;
+    for (auto const& [a, b] : edges) {
+        if (edges.count({ b, a }) != 0) { continue; }
+        float3 const pa = vertices[a].position, pb = vertices[b].position;
+        on_outline = on_outline && On_Outline(pa, pb);
+        length_sum += std::hypot(pa.x - pb.x, pa.z - pb.z);
+    }
+    return length_sum;
+}
+
+bool References(Indices const& indices, uint vertex)
+{
+    return std::find(indices.begin(), indices.end(), vertex) != indices.end();
+}
+
+void Check_Simplify()
+{
+    uint const    cells = 64;
+    Mesh const    mesh  = Terrain(cells);
+    std::size_t const target = mesh.indices.size() / 4 / 3 * 3;
+
+    // loose error: the index target stops it
+    float         error  = -1.0f;
+    Indices const coarse = Mesh_Simplifier::Simplify(mesh.vertices, mesh.indices, target, 1.0f, &error);
+    check(coarse.size() <= target);
+    check(coarse.size() % 3 == 0 && !coarse.empty());
+    check(error >= 0.0f && error <= 1.0f);
+
+    // tight error: the error stops it before the target
+    float         tight_error = -1.0f;
+    Indices const fine        = Mesh_Simplifier::Simplify(mesh.vertices, mesh.indices, target, 0.001f, &tight_error);
+    check(tight_error <= 0.001f);
+    check(fine.size() > target && fine.size() < mesh.indices.size());
+
+    // the outline and the seam keep their shape: 4 sides of 2 plus both sides of the seam
+    for (Indices const* result : { &coarse, &fine }) {
+        bool        on_outline = false;
+        float const outline    = Open_Edge_Length(mesh.vertices, result->data(), result->size(), on_outline);
+        check(on_outline);
+        check_near(outline, 12.0, 1e-4);
+
+        // seam vertices never move, so they are all still there
+        for (uint z = 0; z <= cells; ++z) {
+            check(References(*result, z * (cells + 1) + cells / 2));
+            check(References(*result, uint(mesh.vertices.size()) - cells - 1 + z));
+        }
+        for (uint corner : { 0u, cells, cells * (cells + 1), cells * (cells + 1) + cells }) {
+            check(References(*result, corner));
+        }
+    }
+}
+
+void Check_Build_Lods()
+{
+    Mesh mesh = Terrain(64);
+    std::size_t const full_count = mesh.indices.size();
+    Mesh_Simplifier::Build_Lods(mesh);
+
+    check(mesh.lod_count() >= 3 && mesh.lod_count() <= Mesh_Simplifier::Max_Lods);
+    check(mesh.lod(0).first_index == 0 && mesh.lod(0).index_count == full_count);
+    check(mesh.bounding_radius > 1.4f);
+
+    for (std::size_t n = 1; n < mesh.lod_count(); ++n) {
+        Mesh_Lod const previous = mesh.lod(n - 1), level = mesh.lod(n);
+        check(level.first_index == previous.first_index + previous.index_count);
+        check(level.index_count <= previous.index_count * 3 / 4);
+        check(level.error >= previous.error && level.error <= Mesh_Simplifier::Max_Error);
+
+        bool        on_outline = false;
+        float const outline    = Open_Edge_Length(mesh.vertices, &mesh.indices[level.first_index], level.index_count, on_outline);
+        check(on_outline);
+        check_near(outline, 12.0, 1e-4);
+    }
+    check(mesh.indices.size() == std::size_t(mesh.lods.back().first_index) + mesh.lods.back().index_count);
+}
+
+using Position_Edge = std::pair<std::array<float, 3>, std::array<float, 3>>;
+
+// the open edges of one level that are not on the outline or the seam, by position
+std::set<Position_Edge> Cut_Edges(Mesh const& piece, Mesh_Lod const& level)
+{
+    std::set<std::pair<uint, uint>> edges{};
+    for (std::size_t n = level.first_index; n < std::size_t(level.first_index) + level.index_count; n += 3) {
+        for (int c = 0; c < 3; ++c) { edges.insert({ piece.indices[n + c], piece.indices[n + (c + 1) % 3] }); }
+    }
+
+    std::set<Position_Edge> cut{};
+    for (auto const& [a, b] : edges) {
+        if (edges.count({ b, a }) != 0) { continue; }
+        float3 const pa = piece.vertices[a].position, pb = piece.vertices[b].position;
+        if (!On_Outline(pa, pb)) {
+            cut.insert({ { pa.x, pa.y, pa.z }, { pb.x, pb.y, pb.z } });
+        }
+    }
+    return cut;
+}
+
+// the pieces of a split mesh get their levels on their own and draw whichever level fits,
+// so the edges along the cuts have to be the same in every level of every piece
+void Check_Split_Lods()
+{
+    Mesh mesh = Terrain(64);
+    std::size_t const triangle_count = mesh.indices.size() / 3;
+
+    std::vector<std::vector<bool>> cut_vertices{};
+    Meshes pieces = Mesh_Optimizer::Split_Mesh(std::move(mesh), 1500, &cut_vertices);
+    check(pieces.size() >= 3 && cut_vertices.size() == pieces.size());
+
+    std::size_t split_triangles = 0;
+    for_size (n, pieces) {
+        split_triangles += pieces[n].indices.size() / 3;
+        check(cut_vertices[n].size() == pieces[n].vertices.size());
+        Mesh_Simplifier::Build_Lods(pieces[n], Mesh_Simplifier::Max_Lods, Mesh_Simplifier::Max_Error, cut_vertices[n]);
+        check(pieces[n].lod_count() >= 2);
+    }
+    check(split_triangles == triangle_count);
+
+    // every cut edge of a piece is the reverse of a cut edge of another piece
+    std::map<Position_Edge, std::size_t> owners{};
+    for_size (n, pieces) {
+        for (Position_Edge const& edge : Cut_Edges(pieces[n], pieces[n].lod(0))) { owners[edge] = n; }
+    }
+    for (auto const& [edge, owner] : owners) {
+        auto const reverse = owners.find({ edge.second, edge.first });
+        check(reverse != owners.end() && reverse->second != owner);
+    }
+
+    for (Mesh const& piece : pieces) {
+        std::set<Position_Edge> const full = Cut_Edges(piece, piece.lod(0));
+        check(!full.empty());
+        for (std::size_t level = 1; level < piece.lod_count(); ++level) {
+            check(Cut_Edges(piece, piece.lod(level)) == full);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Check_Simplify();
+    Check_Build_Lods();
+    Check_Split_Lods();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Mesh const mesh = Terrain(300);
+        std::cout << "level of detail chain of a 180k triangle terrain:\n";
+        Test::Print_Bench("Build_Lods", Test::Time_Per_Call(1, [&] { Mesh copy = mesh; Mesh_Simplifier::Build_Lods(copy); }));
+    }
+
+    return Test::Result("Mesh_Simplifier");
+}
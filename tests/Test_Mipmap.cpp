@@ -0,0 +1,122 @@
+#include "Test.h"
+#include "../Cpu.h"
+#include "../Mipmap.h"
+
+#include <algorithm>
+#include <random>
+
+struct Image {
+    Bytes pixels   = {};
+    int   width    = 0;
+    int   height   = 0;
+    int   channels = 0;
+};
+
+Image Random_Image(int width, int height, int channels, u32 seed)
+{
+    std::mt19937 random{ seed };
+    Image image{ Bytes(std::size_t(width) * height * channels), width, height, channels };
+    for (Byte& value : image.pixels) { value = Byte(random()); }
+    return image;
+}
+
+double Srgb_To_Linear(double value) { return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4); }
+double Linear_To_Srgb(double value) { return value <= 0.0031308 ? value * 12.92 : 1.055 * std::pow(value, 1.0 / 2.4) - 0.055; }
+
+// 2x2 average in double, the pixels past an odd edge are the edge pixels
+Bytes Box_Reference(const Byte* pixels, int width, int height, int channels, bool srgb)
+{
+    int const target_width = std::max(1, width / 2), target_height = std::max(1, height / 2);
+    Bytes result(std::size_t(target_width) * target_height * channels);
+    for (int y = 0; y < target_height; ++y) {
+        for (int x = 0; x < target_width; ++x) {
+            for (int c = 0; c < channels; ++c) {
+                bool const color = srgb && c < 3;
+                double sum = 0.0;
+                for (int k = 0; k < 4; ++k) {
+                    int const source_x = std::min(2 * x + k % 2, width - 1), source_y = std::min(2 * y + k / 2, height - 1);
+                    double const value = pixels[(std::size_t(source_y) * width + source_x) * channels + c] / 255.0;
+                    sum += color ? Srgb_To_Linear(value) : value;
+                }
+                double const average = sum / 4.0;
+                result[(std::size_t(y) * target_width + x) * channels + c] = Byte(std::lround((color ? Linear_To_Srgb(average) : average) * 255.0));
+            }
+        }
+    }
+    return result;
+}
+
+void Check_Paths_Match(Image const& image, bool gamma, Mipmap::Filter filter)
+{
+    std::vector<Mipmap::Level> const reference = Mipmap::Generate(image.pixels.data(), image.width, image.height, image.channels, gamma, filter, Mipmap::scalar);
+    for (Mipmap::Path path : { Mipmap::sse2, Mipmap::avx2, Mipmap::best }) {
+        std::vector<Mipmap::Level> const levels = Mipmap::Generate(image.pixels.data(), image.width, image.height, image.channels, gamma, filter, path);
+        check(levels.size() == reference.size());
+        for (std::size_t n = 0; n < std::min(levels.size(), reference.size()); ++n) {
+            check(levels[n].width == reference[n].width && levels[n].height == reference[n].height);
+            check(levels[n].pixels == reference[n].pixels);
+        }
+    }
+}
+
+// every level is made from the one above, so each is compared to the reference of its own source
+void Check_Box_Reference(Image const& image, bool gamma)
+{
+    bool const srgb = gamma && image.channels >= 3;
+    std::vector<Mipmap::Level> const levels = Mipmap::Generate(image.pixels.data(), image.width, image.height, image.channels, gamma, Mipmap::box, Mipmap::scalar);
+
+    const Byte* source = image.pixels.data();
+    int width = image.width, height = image.height;
+    for (Mipmap::Level const& level : levels) {
+        Bytes const expected = Box_Reference(source, width, height, image.channels, srgb);
+        check(expected.size() == level.pixels.size());
+        int worst = 0;
+        for (std::size_t n = 0; n < std::min(expected.size(), level.pixels.size()); ++n) {
+            worst = std::max(worst, std::abs(int(expected[n]) - int(level.pixels[n])));
+        }
+        check(worst <= 1); // float sums against the double reference may round to the other side
+        source = level.pixels.data();
+        width  = level.width;
+        height = level.height;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Cpu_Features const& features = Get_Cpu_Features();
+    std::cout << "mipmap paths: scalar" << (features.sse2 ? ", sse2" : "") << (features.avx2 ? ", avx2" : "") << '\n';
+
+    // odd sizes hit the edge handling and the single pixel tails of the simd loops
+    for (int channels = 1; channels <= 4; ++channels) {
+        Image const image = Random_Image(67, 45, channels, u32(channels));
+        for (bool gamma : { false, true }) {
+            Check_Paths_Match(image, gamma, Mipmap::box);
+            Check_Paths_Match(image, gamma, Mipmap::kaiser);
+            Check_Box_Reference(image, gamma);
+        }
+    }
+    Check_Paths_Match(Random_Image(1, 9, 4, 7), true, Mipmap::kaiser);
+
+    // flat color stays flat, also through the kaiser lobes
+    Image flat = Random_Image(32, 32, 4, 0);
+    for (std::size_t n = 0; n < flat.pixels.size(); ++n) { flat.pixels[n] = Byte(40 + n % 4 * 50); }
+    for (Mipmap::Level const& level : Mipmap::Generate(flat.pixels.data(), 32, 32, 4, true, Mipmap::kaiser)) {
+        for (std::size_t n = 0; n < level.pixels.size(); ++n) { check(level.pixels[n] == Byte(40 + n % 4 * 50)); }
+    }
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Image const image = Random_Image(1024, 1024, 4, 42);
+        std::cout << "mipmap chain of 1024x1024 srgb rgba:\n";
+        const char* names[] = { "best", "scalar", "sse2", "avx2" };
+        for (Mipmap::Filter filter : { Mipmap::box, Mipmap::kaiser }) {
+            for (Mipmap::Path path : { Mipmap::scalar, Mipmap::sse2, Mipmap::avx2 }) {
+                std::string const name = std::string(filter == Mipmap::box ? "box " : "kaiser ") + names[path];
+                Test::Print_Bench(name.c_str(), Test::Time_Per_Call(5, [&] {
+                    Mipmap::Generate(image.pixels.data(), image.width, image.height, image.channels, true, filter, path);
+                }));
+            }
+        }
+    }
+
+    return Test::Result("Mipmap");
+}
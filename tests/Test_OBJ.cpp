@@ -0,0 +1,376 @@
+#include "Test.h"
+#include "../OBJ.h"
+
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// the getline/split/stof loader the mapped parser replaced, kept as the reference of the benchmark.
+// it only reads v/vt/vn triangles and takes the normal of the third corner for all three
+namespace Getline_Loader {
+
+using Tokens = std::vector<std::string>;
+
+Tokens split(std::string text, char const delimiter)
+{
+    std::stringstream ss { text };
+    std::vector<std::string> tokens {};
+
+    for (std::string token{}; std::getline(ss, token, delimiter);/**/) {
+        if (token.empty()) {
+            return {};
+        }
+        tokens.push_back(token);
+    }
+    return tokens;
+}
+
+float3 to_vec3(Tokens const& tokens) { return { std::stof(tokens[1]), std::stof(tokens[2]), std::stof(tokens[3]) }; }
+float2 to_vec2(Tokens const& tokens) { return { std::stof(tokens[1]), std::stof(tokens[2]) }; }
+
+Triplet to_triplet(std::string line)
+{
+    auto tokens = split(line, '/');
+    return { std::atoi(tokens[0].c_str()), std::atoi(tokens[1].c_str()), std::atoi(tokens[2].c_str()) };
+}
+
+OBJ Load_OBJ(const char* file_name)
+{
+    std::ifstream file{ file_name };
+
+    Indices v_i, uv_i, vt_i;
+    std::vector<float3> temp_vertices, temp_normals;
+    std::vector<float2> temp_tex;
+
+    for (std::string line{}; std::getline(file, line);/**/) {
+        if (line.empty()) { continue; }
+
+        Tokens      const tokens = split(line, ' ');
+        std::string const type{ tokens[0] };
+
+        if (type == "#")  { continue; }
+        if (type == "v")  { temp_vertices.push_back(to_vec3(tokens)); continue; }
+        if (type == "vn") { temp_normals.push_back(to_vec3(tokens)); continue; }
+        if (type == "vt") { temp_tex.push_back(to_vec2(tokens)); continue; }
+        if (type == "f") {
+            Triplet a = to_triplet(tokens[1]);
+            Triplet b = to_triplet(tokens[2]);
+            Triplet c = to_triplet(tokens[3]);
+            v_i.insert(v_i.end(), { uint(a[0]), uint(b[0]), uint(c[0]) });
+            uv_i.insert(uv_i.end(), { uint(a[1]), uint(b[1]), uint(c[1]) });
+            vt_i.insert(vt_i.end(), { uint(c[2]), uint(c[2]), uint(c[2]) });
+        }
+    }
+
+    OBJ obj{};
+    obj.name = file_name;
+    for_size (n, v_i) {
+        obj.vertices.push_back(temp_vertices[v_i[n] - 1]);
+        obj.normals.push_back(temp_normals[vt_i[n] - 1]);
+        obj.tex_coords.push_back(temp_tex[uv_i[n] - 1]);
+    }
+    return obj;
+}
+
+}
+
+// a bumpy grid of cells * cells quads with one normal per triangle (the same vn for its three
+// corners, so the getline loader reads it right as well), line_end lets the tests use crlf files.
+// smooth: one normal per position instead, neighbouring triangles share their corners
+std::string Grid_OBJ(uint cells, const char* line_end = "\n", bool smooth = false)
+{
+    std::string text = "# generated grid";
+    text += line_end;
+    char line[128];
+    for (uint z = 0; z <= cells; ++z) {
+        for (uint x = 0; x <= cells; ++x) {
+            float const px = float(x) / cells, pz = float(z) / cells;
+            std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f%s", px, 0.1f * std::sin(px * 7.0f + pz * 3.0f), pz, line_end);
+            text += line;
+            std::snprintf(line, sizeof(line), "vt %.5f %.5f%s", px, 1.0f - pz, line_end);
+            text += line;
+            if (smooth) {
+                std::snprintf(line, sizeof(line), "vn %.4f 0.9999 %.4f%s", 0.1f * px, -0.1f * pz, line_end);
+                text += line;
+            }
+        }
+    }
+
+    uint normal = 0;
+    for (uint z = 0; z < cells; ++z) {
+        for (uint x = 0; x < cells; ++x) {
+            uint const a = z * (cells + 1) + x + 1, b = a + cells + 1, c = a + 1, d = b + 1;
+            for (std::array<uint, 3> const& triangle : { std::array<uint, 3>{ a, b, c }, std::array<uint, 3>{ c, b, d } }) {
+                if (smooth) {
+                    std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u%s", triangle[0], triangle[0], triangle[0],
+                                  triangle[1], triangle[1], triangle[1], triangle[2], triangle[2], triangle[2], line_end);
+                    text += line;
+                    continue;
+                }
+                float const tilt = 0.01f * float(normal % 17);
+                std::snprintf(line, sizeof(line), "vn %.4f 0.9999 %.4f%s", tilt, -tilt, line_end);
+                text += line;
+                ++normal;
+                std::snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u%s", triangle[0], triangle[0], normal,
+                              triangle[1], triangle[1], normal, triangle[2], triangle[2], normal, line_end);
+                text += line;
+            }
+        }
+    }
+    return text;
+}
+
+void Write_File(fs::path const& path, std::string const& text)
+{
+    std::ofstream file{ path, std::ios::binary };
+    file.write(text.data(), std::streamsize(text.size()));
+}
+
+bool Same(float3 a, float3 b) { return a.x == b.x && a.y == b.y && a.z == b.z; }
+bool Same(float2 a, float2 b) { return a.x == b.x && a.y == b.y; }
+
+bool Same_OBJ(OBJ const& a, OBJ const& b)
+{
+    if (a.vertices.size() != b.vertices.size() || a.normals.size() != b.normals.size() || a.tex_coords.size() != b.tex_coords.size()) {
+        return false;
+    }
+    for_size (n, a.vertices)   { if (!Same(a.vertices[n], b.vertices[n]))     { return false; } }
+    for_size (n, a.normals)    { if (!Same(a.normals[n], b.normals[n]))       { return false; } }
+    for_size (n, a.tex_coords) { if (!Same(a.tex_coords[n], b.tex_coords[n])) { return false; } }
+    return true;
+}
+
+template <class Type>
+bool Same_Bytes(std::vector<Type> const& a, std::vector<Type> const& b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(Type)) == 0;
+}
+
+bool Same_Bytes(OBJ const& a, OBJ const& b)
+{
+    return Same_Bytes(a.vertices, b.vertices) && Same_Bytes(a.normals, b.normals) && Same_Bytes(a.tex_coords, b.tex_coords);
+}
+
+bool Same_Bytes(OBJ_Records const& a, OBJ_Records const& b)
+{
+    return Same_Bytes(a.positions, b.positions) && Same_Bytes(a.normals, b.normals) &&
+           Same_Bytes(a.tex_coords, b.tex_coords) && Same_Bytes(a.corners, b.corners);
+}
+
+OBJ_Records Read_Text(std::string const& text, uint thread_count = 1, std::size_t piece_count = 0)
+{
+    return Read_OBJ_Records(text.data(), text.data() + text.size(), thread_count, piece_count);
+}
+
+void Check_Triplets()
+{
+    auto parse = [](const char* text) {
+        const char* at = text;
+        Triplet const triplet = Parse_Triplet(at, text + std::strlen(text));
+        check(*at == '\0' || *at == ' ');
+        return triplet;
+    };
+    check((parse("7") == Triplet{ 7, 0, 0 }));
+    check((parse("7/3") == Triplet{ 7, 3, 0 }));
+    check((parse("7//2") == Triplet{ 7, 0, 2 }));
+    check((parse("7/3/2") == Triplet{ 7, 3, 2 }));
+    check((parse("123456/7/89 1/1/1") == Triplet{ 123456, 7, 89 }));
+}
+
+void Check_Records()
+{
+    std::string const text =
+        "# comment v 1 2 3\n"
+        "mtllib box.mtl\n"
+        "o box\n"
+        "v 1 2 3\n"
+        "v\t-0.5   +4.25e1  1E-3\n"
+        "  v 0.1 0.2 0.3\n"
+        "v 3.4028235e38 -1.17549435e-38 0.12345678901234567890\n"
+        "vt 0.25 0.75\n"
+        "vn 0 0 1\n"
+        "usemtl red\n"
+        "s off\n"
+        "f 1 2 3\n"
+        "f 1/1/1 2/1/1 3/1/1 4/1/1\n"
+        "f 4//1 3//1 2//1\n"
+        "vp 1 2 3\n"
+        "f 1/1 2/1 3/1";
+
+    OBJ_Records const records = Read_Text(text);
+    check(records.positions.size() == 4 && records.tex_coords.size() == 1 && records.normals.size() == 1);
+    check(Same(records.positions[0], { 1.0f, 2.0f, 3.0f }));
+    check(Same(records.positions[1], { -0.5f, 42.5f, 1e-3f }));
+    check(Same(records.positions[2], { 0.1f, 0.2f, 0.3f }));
+    check(Same(records.positions[3], { std::strtof("3.4028235e38", nullptr), std::strtof("-1.17549435e-38", nullptr),
+                                       std::strtof("0.12345678901234567890", nullptr) }));
+    check(Same(records.tex_coords[0], { 0.25f, 0.75f }));
+
+    // the quad is a fan around its first corner
+    std::vector<Triplet> const corners = {
+        { 1, 0, 0 }, { 2, 0, 0 }, { 3, 0, 0 },
+        { 1, 1, 1 }, { 2, 1, 1 }, { 3, 1, 1 },
+        { 1, 1, 1 }, { 3, 1, 1 }, { 4, 1, 1 },
+        { 4, 0, 1 }, { 3, 0, 1 }, { 2, 0, 1 },
+        { 1, 1, 0 }, { 2, 1, 0 }, { 3, 1, 0 },
+    };
+    check(records.corners == corners);
+
+    // the flat form: missing data is zero
+    OBJ obj{};
+    obj.vertices.resize(records.corners.size());
+    obj.normals.resize(records.corners.size());
+    obj.tex_coords.resize(records.corners.size());
+    Resolve_Corners(records, obj, 0, records.corners.size());
+    check(Same(obj.vertices[7], records.positions[2]) && Same(obj.normals[7], { 0.0f, 0.0f, 1.0f }));
+    check(Same(obj.normals[0], {}) && Same(obj.tex_coords[0], {}) && Same(obj.tex_coords[3], { 0.25f, 0.75f }));
+
+    check(Read_Text("").corners.empty());
+}
+
+void Check_Parser_Matches_Getline_Loader(fs::path const& path)
+{
+    Write_File(path, Grid_OBJ(40));
+    OBJ const obj = Load_OBJ(path.string().c_str());
+    check(obj.vertices.size() == 40 * 40 * 6);
+    check(Same_OBJ(obj, Getline_Loader::Load_OBJ(path.string().c_str())));
+}
+
+// the pieces are cut at arbitrary bytes and moved to the next line start,
+// every cut and every thread count has to give exactly the single piece result
+void Check_Pieces()
+{
+    for (const char* line_end : { "\n", "\r\n" }) {
+        std::string const text = Grid_OBJ(12, line_end);
+        OBJ_Records const whole = Read_Text(text);
+        check(whole.corners.size() == 12 * 12 * 6);
+
+        for (std::size_t piece_count : { 2, 3, 5, 7, 13, 31, 97, 500 }) {
+            check(Same_Bytes(Read_Text(text, 1, piece_count), whole));
+            check(Same_Bytes(Read_Text(text, 3, piece_count), whole));
+            check(Same_Bytes(Read_Text(text, All_Cores, piece_count), whole));
+        }
+        // no line break at the end of the last line
+        check(Same_Bytes(Read_Text(text.substr(0, text.size() - std::strlen(line_end)), 3, 7), whole));
+    }
+    check(Same_Bytes(Read_Text(Grid_OBJ(12, "\r\n")), Read_Text(Grid_OBJ(12))));
+
+    // shorter than the piece count: most pieces are empty
+    std::string const tiny = "v 1 2 3\r\nf 1 1 1\r\n";
+    OBJ_Records const records = Read_Text(tiny, 3, 64);
+    check(records.positions.size() == 1 && records.corners.size() == 3);
+    check(Same_Bytes(records, Read_Text(tiny)));
+}
+
+// large enough for the automatic piece count to cut it
+void Check_Thread_Counts(fs::path const& path)
+{
+    std::string const text = Grid_OBJ(220, "\r\n");
+    Write_File(path, text);
+    check(text.size() > (8 << 20));
+
+    std::string const name = path.string();
+    OBJ const single = Load_OBJ(name.c_str(), 1);
+    check(single.vertices.size() == 220 * 220 * 6);
+    check(Same_Bytes(Load_OBJ(name.c_str(), 3), single));
+    check(Same_Bytes(Load_OBJ(name.c_str(), All_Cores), single));
+}
+
+// the indexed mesh expands back to exactly what Load_OBJ returns
+bool Expands_To(Mesh const& mesh, OBJ const& obj)
+{
+    if (mesh.indices.size() != obj.vertices.size()) {
+        return false;
+    }
+    for_size (n, mesh.indices) {
+        if (mesh.indices[n] >= mesh.vertices.size()) { return false; }
+        Vertex const& vertex = mesh.vertices[mesh.indices[n]];
+        if (std::memcmp(&vertex.position,  &obj.vertices[n],   sizeof(float3)) != 0 ||
+            std::memcmp(&vertex.normal,    &obj.normals[n],    sizeof(float3)) != 0 ||
+            std::memcmp(&vertex.tex_coord, &obj.tex_coords[n], sizeof(float2)) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Check_Indexed_Mesh(fs::path const& path)
+{
+    // corners are the same vertex only if v, vt and vn all match
+    OBJ_Records const records = Read_Text("v 0 0 0\nv 1 0 0\nv 0 1 0\nv 1 1 0\nvn 0 0 1\nvn 0 0 -1\n"
+                                          "f 1//1 2//1 3//1\nf 3//1 2//1 4//1\nf 1//2 2//2 3//1\nf 1 2 3\n");
+    Mesh mesh{};
+    Deduplicate_Corners(records, mesh);
+    check(mesh.vertices.size() == 9);
+    check((mesh.indices == Indices{ 0, 1, 2, 2, 1, 3, 4, 5, 2, 6, 7, 8 }));
+
+    for (bool smooth : { false, true }) {
+        Write_File(path, Grid_OBJ(30, "\n", smooth));
+        std::string const name = path.string();
+        Mesh const indexed = Load_OBJ_Mesh(name.c_str());
+        check(Expands_To(indexed, Load_OBJ(name.c_str())));
+        check(indexed.vertices.size() == (smooth ? 31 * 31 : 30 * 30 * 6));
+
+        Mesh const threaded = Load_OBJ_Mesh(name.c_str(), 3);
+        check(threaded.indices == indexed.indices);
+        check(Same_Bytes(threaded.vertices, indexed.vertices));
+    }
+}
+
+void Bench(fs::path const& path)
+{
+    std::string const text = Grid_OBJ(400);
+    Write_File(path, text);
+    std::cout << "grid of " << 400 * 400 * 2 << " triangles, " << text.size() / (1 << 20) << " MB:\n";
+
+    std::string const name = path.string();
+    double const getline_ns = Test::Time_Per_Call(1, [&] { Getline_Loader::Load_OBJ(name.c_str()); });
+    double const mapped_ns  = Test::Time_Per_Call(3, [&] { Load_OBJ(name.c_str()); });
+    Test::Print_Bench("getline & stof Load_OBJ", getline_ns);
+    Test::Print_Bench("mapped Load_OBJ", mapped_ns);
+    std::cout << "  " << text.size() / (mapped_ns / 1e9) / (1 << 20) << " MB/s, " << getline_ns / mapped_ns << "x\n";
+
+    std::cout << "mapped Load_OBJ by thread count (" << Worker_Count(All_Cores) << " hardware threads):\n";
+    for (uint thread_count : { 1u, 2u, 3u, 4u, 8u, All_Cores }) {
+        std::string const label = thread_count == All_Cores ? "All_Cores" : std::to_string(thread_count) + " thread" + (thread_count > 1 ? "s" : "");
+        Test::Print_Bench(label.c_str(), Test::Time_Per_Call(3, [&] { Load_OBJ(name.c_str(), thread_count); }));
+    }
+
+    // shared corners, what Load_OBJ_Mesh saves over the flat form
+    std::string const smooth = Grid_OBJ(400, "\n", true);
+    OBJ_Records const records = Read_Text(smooth);
+    Mesh mesh{};
+    double const dedup_ns = Test::Time_Per_Call(3, [&] { mesh = {}; Deduplicate_Corners(records, mesh); });
+
+    std::size_t const expanded_bytes = records.corners.size() * sizeof(Vertex);
+    std::size_t const indexed_bytes  = mesh.vertices.size() * sizeof(Vertex) + mesh.indices.size() * sizeof(uint);
+    std::cout << "smooth grid, " << records.corners.size() << " corners -> " << mesh.vertices.size() << " vertices, "
+              << expanded_bytes / (1 << 20) << " MB -> " << indexed_bytes / (1 << 20) << " MB:\n";
+    Test::Print_Bench("Deduplicate_Corners", dedup_ns);
+    std::cout << "  " << records.corners.size() / (dedup_ns / 1e9) / 1e6 << " M corners/s\n";
+}
+
+int main(int argc, char** argv)
+{
+    fs::path const directory = fs::temp_directory_path() / "obj_test";
+    fs::create_directories(directory);
+
+    Check_Triplets();
+    Check_Records();
+    Check_Parser_Matches_Getline_Loader(directory / "grid.obj");
+    Check_Pieces();
+    Check_Thread_Counts(directory / "large.obj");
+    Check_Indexed_Mesh(directory / "indexed.obj");
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Bench(directory / "bench.obj");
+    }
+
+    fs::remove_all(directory);
+    return Test::Result("OBJ");
+}
@@ -0,0 +1,184 @@
+#include "Test.h"
+#include "../Offset_Allocator.h"
+
+#include <algorithm>
+#include <map>
+#include <random>
+
+// the allocator against a unit by unit map of the space: which allocation owns every unit (0 = free)
+struct Brute_Force {
+    struct Live {
+        u64 size      = 0;
+        u64 alignment = 1;
+        u32 id        = 0;
+    };
+
+    std::vector<u32>    owners{};
+    std::map<u64, Live> live{}; // by offset
+    u32                 next_id = 1;
+
+    struct Run {
+        u64 offset = 0;
+        u64 size   = 0;
+    };
+
+    // the maximal free runs, in offset order
+    std::vector<Run> free_runs() const
+    {
+        std::vector<Run> runs{};
+        for (u64 unit = 0; unit < owners.size(); ++unit) {
+            if (owners[unit] != 0) { continue; }
+            if (runs.empty() || runs.back().offset + runs.back().size != unit) { runs.push_back({ unit, 0 }); }
+            runs.back().size++;
+        }
+        return runs;
+    }
+
+    static bool Fits(Run const& run, u64 size, u64 alignment)
+    {
+        u64 const offset = (run.offset + alignment - 1) / alignment * alignment;
+        return offset + size <= run.offset + run.size;
+    }
+
+    void fill(u64 offset, u64 size, u32 id)
+    {
+        std::fill(owners.begin() + std::ptrdiff_t(offset), owners.begin() + std::ptrdiff_t(offset + size), id);
+    }
+};
+
+void Check_Same_State(Offset_Allocator const& allocator, Brute_Force const& model)
+{
+    std::vector<Brute_Force::Run> const runs = model.free_runs();
+    u64 largest = 0;
+    for (Brute_Force::Run const& run : runs) { largest = std::max(largest, run.size); }
+
+    u64 used = 0;
+    for (auto const& [offset, allocation] : model.live) { used += allocation.size; }
+
+    check(allocator.capacity() == model.owners.size());
+    check(allocator.used() == used);
+    check(allocator.allocation_count() == model.live.size());
+    check(allocator.free_block_count() == runs.size()); // neighbouring free blocks are always merged
+    check(allocator.largest_free() == largest);
+}
+
+void Check_Allocate(Offset_Allocator& allocator, Brute_Force& model, u64 size, u64 alignment)
+{
+    std::vector<Brute_Force::Run> const runs   = model.free_runs();
+    std::optional<u64> const            offset = allocator.allocate(size, alignment);
+
+    if (!offset) {
+        // nothing may fit anywhere
+        for (Brute_Force::Run const& run : runs) { check(!Brute_Force::Fits(run, size, alignment)); }
+        return;
+    }
+
+    check(*offset % alignment == 0 && *offset + size <= model.owners.size());
+    check(std::all_of(model.owners.begin() + std::ptrdiff_t(*offset), model.owners.begin() + std::ptrdiff_t(*offset + size), [](u32 owner) { return owner == 0; }));
+
+    // best fit: no smaller free run could have taken it
+    auto const chosen = std::find_if(runs.begin(), runs.end(), [&](Brute_Force::Run const& run) { return run.offset <= *offset && *offset < run.offset + run.size; });
+    check(chosen != runs.end());
+    if (chosen != runs.end()) {
+        for (Brute_Force::Run const& run : runs) { check(run.size >= chosen->size || !Brute_Force::Fits(run, size, alignment)); }
+    }
+
+    model.live[*offset] = { size, alignment, model.next_id };
+    model.fill(*offset, size, model.next_id++);
+}
+
+void Check_Defragment(Offset_Allocator& allocator, Brute_Force& model)
+{
+    std::vector<Offset_Allocator::Move> const moves = allocator.defragment();
+    check(moves.size() == model.live.size());
+
+    std::map<u64, Brute_Force::Live> packed{};
+    std::fill(model.owners.begin(), model.owners.end(), 0u);
+    u64 end = 0;
+    auto allocation = model.live.begin();
+    for (Offset_Allocator::Move const& move : moves) {
+        if (allocation == model.live.end()) { break; }
+        // in offset order, packed to the front with the alignment kept
+        u64 const expected = (end + allocation->second.alignment - 1) / allocation->second.alignment * allocation->second.alignment;
+        check(move.from == allocation->first && move.size == allocation->second.size);
+        check(move.to == expected && move.to <= move.from);
+
+        packed[move.to] = allocation->second;
+        model.fill(move.to, move.size, allocation->second.id);
+        end = move.to + move.size;
+        ++allocation;
+    }
+    model.live = std::move(packed);
+}
+
+void Check_Random_Operations()
+{
+    std::mt19937     random{ 1 };
+    Offset_Allocator allocator{ 1000 };
+    Brute_Force      model{};
+    model.owners.assign(1000, 0);
+
+    int failed_allocations = 0, grows = 0, defragments = 0;
+    for (int operation = 0; operation < 100'000; ++operation) {
+        u32 const kind = random() % 20;
+        if (kind < 10) {
+            u64 const         size      = 1 + random() % 50;
+            u64 const         alignment = u64(1) << (random() % 4);
+            std::size_t const count     = model.live.size();
+            Check_Allocate(allocator, model, size, alignment);
+            failed_allocations += model.live.size() == count;
+        }
+        else if (kind < 18) {
+            if (!model.live.empty()) {
+                auto allocation = model.live.begin();
+                std::advance(allocation, random() % model.live.size());
+                allocator.free(allocation->first);
+                model.fill(allocation->first, allocation->second.size, 0);
+                model.live.erase(allocation);
+            }
+        }
+        else if (kind == 18) {
+            // grow only once it got full, the capacity stays small enough for the brute force
+            if (allocator.largest_free() < 64 && model.owners.size() < 8000) {
+                u64 const capacity = model.owners.size() + 1 + random() % 500;
+                allocator.grow(capacity);
+                model.owners.resize(capacity, 0);
+                ++grows;
+            }
+        }
+        else if (random() % 50 == 0) {
+            Check_Defragment(allocator, model);
+            ++defragments;
+        }
+        Check_Same_State(allocator, model);
+    }
+    check(failed_allocations > 0 && grows > 0 && defragments > 0); // every path was taken
+
+    // everything freed is one block again
+    for (auto const& [offset, allocation] : model.live) { allocator.free(offset); }
+    check(allocator.used() == 0 && allocator.allocation_count() == 0);
+    check(allocator.free_block_count() == 1 && allocator.largest_free() == allocator.capacity());
+}
+
+int main(int argc, char** argv)
+{
+    Check_Random_Operations();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        // a mesh arena sized buffer with many live allocations, each free is followed by an allocate
+        std::mt19937     random{ 2 };
+        Offset_Allocator allocator{ u64(1) << 30 };
+        std::vector<u64> live{};
+        for (int n = 0; n < 10'000; ++n) { live.push_back(*allocator.allocate(1 + random() % 65536, 16)); }
+
+        std::cout << "offset allocator, 10k live allocations:\n";
+        Test::Print_Bench("free & allocate", Test::Time_Per_Call(1'000'000, [&] {
+            u64& slot = live[random() % live.size()];
+            allocator.free(slot);
+            slot = allocator.allocate(1 + random() % 65536, 16).value_or(0);
+        }));
+        Test::Print_Bench("defragment", Test::Time_Per_Call(10, [&] { allocator.defragment(); }));
+    }
+
+    return Test::Result("Offset_Allocator");
+}
@@ -0,0 +1,144 @@
+#include "Test.h"
+#include "../Draw_Keys.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// the gl free part of Render_Queue: the keys and their sort
+
+std::mt19937_64 random_engine{ 21 };
+
+// draw n in the low bits, the state bits from a pool of distinct_states values (0: all random)
+std::vector<u64> Random_Keys(std::size_t count, std::size_t distinct_states)
+{
+    std::vector<u64> states(distinct_states);
+    for (u64& state : states) { state = random_engine(); }
+
+    std::vector<u64> keys(count);
+    for_size (n, keys) {
+        u64 const state = distinct_states == 0 ? random_engine() : states[random_engine() % distinct_states];
+        keys[n] = (state << Draw_Keys::Draw_Bits) | n;
+    }
+    return keys;
+}
+
+bool Sorts_Like_Stable_Sort(std::vector<u64> keys, int first_bit)
+{
+    std::vector<u64> expected = keys;
+    std::stable_sort(expected.begin(), expected.end(), [first_bit](u64 a, u64 b) { return (a >> first_bit) < (b >> first_bit); });
+
+    std::vector<u64> scratch{};
+    std::vector<u32> histograms{};
+    Draw_Keys::Sort(keys, scratch, histograms, first_bit);
+    return keys == expected;
+}
+
+void Check_Sort()
+{
+    for (std::size_t count : { 0, 1, 2, 100, 5000, 100000 }) {
+        for (std::size_t distinct_states : { 0, 1, 2, 7, 300 }) {
+            std::vector<u64> const keys = Random_Keys(count, distinct_states);
+            check(Sorts_Like_Stable_Sort(keys, Draw_Keys::Draw_Bits));
+
+            // and as a plain sort of every bit, the low bits are random here
+            std::vector<u64> shuffled = keys;
+            std::shuffle(shuffled.begin(), shuffled.end(), random_engine);
+            check(Sorts_Like_Stable_Sort(shuffled, 0));
+            check(Sorts_Like_Stable_Sort(shuffled, 40));
+        }
+    }
+
+    // only the top or the lowest sorted bit differs
+    std::vector<u64> keys(1000);
+    for_size (n, keys) { keys[n] = (u64(n % 3 == 0) << 63) | n; }
+    check(Sorts_Like_Stable_Sort(keys, Draw_Keys::Draw_Bits));
+    for_size (n, keys) { keys[n] = (u64(n % 5 == 0) << Draw_Keys::Draw_Bits) | n; }
+    check(Sorts_Like_Stable_Sort(keys, Draw_Keys::Draw_Bits));
+}
+
+void Check_Key_Order()
+{
+    using Draw_Keys::Make;
+    Textures const textures_a = { { 3, "a.png", Texture::diffuse } };
+    Textures const textures_b = { { 3, "a.png", Texture::normal } };
+
+    check(Draw_Keys::Draw(Make(1, true, 5, textures_a, 7, 2.0f, 12345)) == 12345);
+    check(Draw_Keys::Draw(Make(0, false, 5, textures_a, 7, 2.0f, u32(Draw_Keys::Max_Draws - 1))) == Draw_Keys::Max_Draws - 1);
+
+    // pass before shader before textures before VAO before depth before draw
+    check(Make(0, false, 999, textures_a, 999, 1e6f, 9) < Make(1, false, 0, textures_a, 0, 0.0f, 0));
+    check(Make(0, false, 1, textures_a, 999, 1e6f, 9) < Make(0, false, 2, textures_a, 0, 0.0f, 0));
+    check(Make(0, false, 1, textures_a, 1, 1e6f, 9) < Make(0, false, 1, textures_a, 2, 0.0f, 0));
+    check(Make(0, false, 1, textures_a, 1, 1.0f, 9) < Make(0, false, 1, textures_a, 1, 2.0f, 0));
+    check((Make(0, false, 1, textures_a, 1, 1.0f, 0) >> 41) != (Make(0, false, 1, textures_b, 1, 1.0f, 0) >> 41));
+
+    // truncated ids stay in their own bits
+    check(Make(0, false, ~0u, textures_a, ~0u, 1.0f, ~0u) < Make(1, false, 0, textures_a, 0, 0.0f, 0));
+    check(Make(0, false, 1, textures_a, 1, 1.0f, ~0u) < Make(0, false, 1, textures_a, 1, 2.0f, 0));
+
+    // front to back or back to front, negative depth counts as 0
+    check(Make(0, false, 1, {}, 1, 1.0f, 0) < Make(0, false, 1, {}, 1, 1.5f, 0));
+    check(Make(0, true, 1, {}, 1, 1.0f, 0) > Make(0, true, 1, {}, 1, 1.5f, 0));
+    check(Make(0, false, 1, {}, 1, -5.0f, 0) == Make(0, false, 1, {}, 1, 0.0f, 0));
+}
+
+struct Bench_Draw {
+    uint            program = 0;
+    uint            VAO     = 0;
+    Textures const* textures = nullptr;
+    float           depth   = 0.0f;
+    bool            transparent = false;
+};
+
+void Bench()
+{
+    std::size_t const count = 100000;
+
+    // a scene of 40 shaders, 2000 texture sets and 300 VAOs, one pass in ten transparent
+    std::vector<Textures> texture_sets(2000);
+    for_size (n, texture_sets) {
+        texture_sets[n] = { { uint(n * 3 + 1), "", Texture::diffuse }, { uint(n * 3 + 2), "", Texture::normal } };
+    }
+    std::uniform_real_distribution<float> random_depth{ 0.5f, 500.0f };
+    std::vector<Bench_Draw> draws(count);
+    for (Bench_Draw& draw : draws) {
+        draw.program     = uint(1 + random_engine() % 40);
+        draw.VAO         = uint(1 + random_engine() % 300);
+        draw.textures    = &texture_sets[random_engine() % texture_sets.size()];
+        draw.depth       = random_depth(random_engine);
+        draw.transparent = random_engine() % 10 == 0;
+    }
+
+    std::vector<u64> keys{}, scratch{};
+    std::vector<u32> histograms{};
+    auto build = [&] {
+        keys.clear();
+        for_size (n, draws) {
+            Bench_Draw const& draw = draws[n];
+            keys.push_back(Draw_Keys::Make(draw.transparent, draw.transparent, draw.program, *draw.textures, draw.VAO, draw.depth, u32(n)));
+        }
+    };
+    build();
+    std::vector<u64> const built = keys;
+    std::vector<u64> const random = Random_Keys(count, 0);
+
+    std::cout << "100k draws:\n";
+    Test::Print_Bench("key build", Test::Time_Per_Call(100, build));
+    Test::Print_Bench("key build + sort", Test::Time_Per_Call(100, [&] { build(); Draw_Keys::Sort(keys, scratch, histograms); }));
+    Test::Print_Bench("sort", Test::Time_Per_Call(100, [&] { keys = built; Draw_Keys::Sort(keys, scratch, histograms); }));
+    Test::Print_Bench("sort, 45 random bits", Test::Time_Per_Call(100, [&] { keys = random; Draw_Keys::Sort(keys, scratch, histograms); }));
+    Test::Print_Bench("std::stable_sort", Test::Time_Per_Call(10, [&] { keys = built; std::stable_sort(keys.begin(), keys.end()); }));
+}
+
+int main(int argc, char** argv)
+{
+    Check_Sort();
+    Check_Key_Order();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Bench();
+    }
+
+    return Test::Result("Render_Queue");
+}
@@ -0,0 +1,191 @@
+#include "Test.h"
+#include "../Transform.h"
+#include "../Cpu.h"
+
+#include <random>
+#include <cstring>
+#include <vector>
+
+using namespace Transform;
+
+Path const Simd_Paths[] = { best, sse2, avx2, avx512 };
+const char* const Path_Names[] = { "best", "scalar", "sse2", "avx2", "avx512" };
+
+std::mt19937                          random_engine{ 5 };
+std::uniform_real_distribution<float> random_value{ -3.0f, 3.0f };
+
+std::vector<float3> Random_Points(std::size_t count)
+{
+    std::vector<float3> points(count);
+    for (float3& point : points) { point = { random_value(random_engine), random_value(random_engine), random_value(random_engine) }; }
+    return points;
+}
+
+// rotation, non uniform scale and translation
+float44 Test_Matrix()
+{
+    float44 mat{};
+    float const c = std::cos(0.7f), s = std::sin(0.7f);
+    float const values[4][4] = {
+        { 2.0f * c, -s,   0.3f,  1.5f },
+        { 2.0f * s,  c,   0.1f, -2.0f },
+        { 0.2f,      0.4f, 0.5f, 3.0f },
+        { 0.0f,      0.0f, 0.0f, 1.0f },
+    };
+    for (int row = 0; row < 4; ++row) {
+        for (int col = 0; col < 4; ++col) { mat.data[row][col] = values[row][col]; }
+    }
+    return mat;
+}
+
+bool Same_Bytes(std::vector<float3> const& a, std::vector<float3> const& b)
+{
+    return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float3)) == 0;
+}
+
+// one function with the aos & soa overloads
+using AoS_Function = void (*)(float44 const&, const float3*, float3*, std::size_t, Path);
+using SoA_Function = void (*)(float44 const&, Float3_Arrays, Float3_Arrays, std::size_t, Path);
+
+struct Function {
+    const char*  name;
+    AoS_Function aos;
+    SoA_Function soa;
+};
+
+Function const Functions[] = {
+    { "Points",  Points,  Points },
+    { "Vectors", Vectors, Vectors },
+    { "Normals", Normals, Normals },
+};
+
+std::vector<float3> Run_SoA(Function const& function, float44 const& mat, std::vector<float3> const& in, Path path, bool in_place)
+{
+    std::size_t const count = in.size();
+    std::vector<float> x(count), y(count), z(count), ox(count), oy(count), oz(count);
+    for_size (n, in) {
+        x[n] = in[n].x;
+        y[n] = in[n].y;
+        z[n] = in[n].z;
+    }
+    Float3_Arrays const source{ x.data(), y.data(), z.data() };
+    Float3_Arrays const target = in_place ? source : Float3_Arrays{ ox.data(), oy.data(), oz.data() };
+    function.soa(mat, source, target, count, path);
+
+    std::vector<float3> result(count);
+    for_size (n, result) { result[n] = { target.x[n], target.y[n], target.z[n] }; }
+    return result;
+}
+
+// every path, aos or soa, separate or in place, gives the bits of the scalar path. the counts
+// cover the tails after the last whole register of every width
+void Check_Paths()
+{
+    float44 const mat = Test_Matrix();
+    std::vector<std::size_t> counts{};
+    for (std::size_t count = 0; count <= 49; ++count) { counts.push_back(count); }
+    counts.push_back(1000);
+    counts.push_back(1031);
+
+    for (std::size_t count : counts) {
+        std::vector<float3> const in = Random_Points(count);
+        for (Function const& function : Functions) {
+            std::vector<float3> reference(count);
+            function.aos(mat, in.data(), reference.data(), count, scalar);
+            check(Same_Bytes(Run_SoA(function, mat, in, scalar, false), reference));
+
+            for (Path path : Simd_Paths) {
+                std::vector<float3> out(count);
+                function.aos(mat, in.data(), out.data(), count, path);
+                check(Same_Bytes(out, reference));
+
+                std::vector<float3> in_place = in;
+                function.aos(mat, in_place.data(), in_place.data(), count, path);
+                check(Same_Bytes(in_place, reference));
+
+                check(Same_Bytes(Run_SoA(function, mat, in, path, false), reference));
+                check(Same_Bytes(Run_SoA(function, mat, in, path, true), reference));
+            }
+        }
+    }
+}
+
+// the scalar path against plain matrix math
+void Check_Results()
+{
+    float44 const mat     = Test_Matrix();
+    float44 const inverse = inverse_affine(mat);
+    std::vector<float3> in = Random_Points(100);
+    in[7] = {}; // a zero normal stays zero
+
+    std::vector<float3> points(in.size()), vectors(in.size()), normals(in.size());
+    Points(mat, in.data(), points.data(), in.size(), scalar);
+    Vectors(mat, in.data(), vectors.data(), in.size(), scalar);
+    Normals(mat, in.data(), normals.data(), in.size(), scalar);
+
+    for_size (n, in) {
+        float4 const point  = mat * float4{ in[n].x, in[n].y, in[n].z, 1.0f };
+        float4 const vector = mat * float4{ in[n].x, in[n].y, in[n].z, 0.0f };
+        for (int c = 0; c < 3; ++c) {
+            check_near(points[n].data[c], point.data[c], 1e-5f);
+            check_near(vectors[n].data[c], vector.data[c], 1e-5f);
+        }
+
+        if (n == 7) {
+            check(normals[n] == float3{});
+            continue;
+        }
+        // a normal stays perpendicular to every transformed tangent: n' . (M t) = n . t
+        check_near(length(normals[n]), 1.0f, 1e-5f);
+        float3 const tangent = cross_product(in[n], float3{ 0.3f, 1.0f, -0.2f });
+        float4 const moved   = mat * float4{ tangent.x, tangent.y, tangent.z, 0.0f };
+        check_near(dot_product(normals[n], float3{ moved.x, moved.y, moved.z }), 0.0f, 1e-4f * length(tangent) * length(in[n]));
+
+        // and is the inverse transpose direction
+        float4 const expected = transpose(inverse) * float4{ in[n].x, in[n].y, in[n].z, 0.0f };
+        float3 const direction = normalize(float3{ expected.x, expected.y, expected.z });
+        for (int c = 0; c < 3; ++c) { check_near(normals[n].data[c], direction.data[c], 1e-5f); }
+    }
+}
+
+void Bench(std::size_t count, const char* name)
+{
+    float44 const mat = Test_Matrix();
+    std::vector<float3> const in = Random_Points(count);
+    std::vector<float3> out(count);
+    std::vector<float> x(count), y(count), z(count), ox(count), oy(count), oz(count);
+    for_size (n, in) { x[n] = in[n].x; y[n] = in[n].y; z[n] = in[n].z; }
+
+    std::cout << name << " points (ms per call, speedup over scalar):\n";
+    for (Function const& function : Functions) {
+        for (bool soa : { false, true }) {
+            double scalar_ns = 0.0;
+            std::cout << "  " << function.name << (soa ? " soa:" : " aos:");
+            for (Path path : { scalar, sse2, avx2, avx512 }) {
+                double const ns = Test::Time_Per_Call(count < 100000 ? 1000 : 10, [&] {
+                    if (soa) { function.soa(mat, { x.data(), y.data(), z.data() }, { ox.data(), oy.data(), oz.data() }, count, path); }
+                    else     { function.aos(mat, in.data(), out.data(), count, path); }
+                });
+                if (path == scalar) { scalar_ns = ns; }
+                std::cout << ' ' << Path_Names[path] << ' ' << ns / 1e6 << " (" << scalar_ns / ns << "x)";
+            }
+            std::cout << '\n';
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Check_Paths();
+    Check_Results();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Cpu_Features const& features = Get_Cpu_Features();
+        std::cout << "cpu: sse2 " << features.sse2 << ", avx2 " << features.avx2 << ", avx512 " << features.avx512 << '\n';
+        Bench(1 << 20, "1M");
+        // in the l1/l2 cache, without the memory bandwidth limit
+        Bench(4096, "4k");
+    }
+
+    return Test::Result("Transform");
+}
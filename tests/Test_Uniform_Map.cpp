@@ -0,0 +1,112 @@
+#include "Test.h"
+#include "../Uniform_Map.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+Uniform Runtime_Uniform(std::string const& name)
+{
+    return { Fnv1a(name.data(), name.size()) };
+}
+
+void Check_Insert_Find()
+{
+    Uniform_Map map{};
+    check(map.find("model"_uniform) == -1);
+
+    map.insert("model"_uniform, 3);
+    map.insert("view"_uniform, 0);
+    map.insert("projection"_uniform, 7);
+    check(map.find("model"_uniform) == 3);
+    check(map.at("view"_uniform) == 0);
+    check(map.find("projection"_uniform) == 7);
+    check(map.find("Model"_uniform) == -1);
+    check(map.find("model "_uniform) == -1);
+    check(map.count == 3);
+
+    // the compile time hash is the runtime one
+    check(map.find(Runtime_Uniform("projection")) == 7);
+
+    // a name listed twice keeps the last location
+    map.insert("view"_uniform, 9);
+    check(map.at("view"_uniform) == 9);
+    check(map.count == 3);
+
+    // the hash 0 marks empty slots, a name with that hash is stored as 1
+    map.insert(Uniform{ 0 }, 11);
+    check(map.find(Uniform{ 0 }) == 11);
+    check(map.count == 4);
+}
+
+// many names, every one stays findable while the table grows, and it never gets more than half full
+void Check_Growth()
+{
+    Uniform_Map map{};
+    std::vector<std::string> names{};
+    for (int n = 0; n < 1000; ++n) {
+        names.push_back("lights[" + std::to_string(n) + "].color");
+        map.insert(Runtime_Uniform(names.back()), n);
+
+        check(map.count == names.size());
+        check(map.count * 2 <= map.slots.size());
+        check((map.slots.size() & (map.slots.size() - 1)) == 0);
+        if (n % 97 == 0) {
+            for_size (m, names) { check(map.find(Runtime_Uniform(names[m])) == int(m)); }
+        }
+    }
+    for_size (m, names) { check(map.at(Runtime_Uniform(names[m])) == int(m)); }
+    check(map.find(Runtime_Uniform("lights[1000].color")) == -1);
+    check(map.find(Runtime_Uniform("lights[0].colour")) == -1);
+}
+
+// names that all land in the same slot of the first table probe past each other
+void Check_Collisions()
+{
+    Uniform_Map map{};
+    for (u64 n = 1; n <= 3; ++n) { map.insert(Uniform{ n * 8 }, int(n)); }
+    check(map.slots.size() == 8);
+    for (u64 n = 1; n <= 3; ++n) { check(map.find(Uniform{ n * 8 }) == int(n)); }
+    check(map.find(Uniform{ 32 }) == -1);
+    check(map.find(Uniform{ 16 + 1 }) == -1);
+}
+
+// a typical program: the shader looks up a few of its uniforms per draw
+void Bench()
+{
+    const char* const names[] = {
+        "model", "view", "projection", "normal_matrix", "camera_position", "light_direction",
+        "light_color", "ambient", "shininess", "time", "position_offset", "position_scale",
+    };
+    constexpr std::size_t name_count = sizeof(names) / sizeof(names[0]);
+
+    Uniform_Map map{};
+    std::map<std::string, int> string_map{};
+    for_size (n, names) {
+        map.insert(Runtime_Uniform(names[n]), int(n));
+        string_map[names[n]] = int(n);
+    }
+
+    u64 const count = 1000000;
+    volatile int sink = 0;
+    std::cout << "uniform location lookups of " << name_count << " names:\n";
+    Test::Print_Bench("Uniform_Map::at(\"model\"_uniform)", Test::Time_Per_Call(count, [&] {
+        sink = sink + map.at("model"_uniform) + map.at("light_direction"_uniform) + map.at("position_scale"_uniform);
+    }) / 3);
+    Test::Print_Bench("std::map<std::string, int>::at(const char*)", Test::Time_Per_Call(count, [&] {
+        sink = sink + string_map.at("model") + string_map.at("light_direction") + string_map.at("position_scale");
+    }) / 3);
+}
+
+int main(int argc, char** argv)
+{
+    Check_Insert_Find();
+    Check_Growth();
+    Check_Collisions();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Bench();
+    }
+
+    return Test::Result("Uniform_Map");
+}
@@ -0,0 +1,157 @@
+#include "Test.h"
+#include "../Vector.h"
+
+#include <random>
+#include <vector>
+
+// the float4 & float3a overloads against the generic templates they replace: float4 has the
+// data[] the templates need, so they can be called explicitly, float3a is compared to float3.
+// the Makefile builds this test a second time with -U__SSE2__ for the scalar Simd registers
+
+std::mt19937                          random_engine{ 11 };
+std::uniform_real_distribution<float> random_value{ -2.0f, 2.0f };
+
+float4 Random_Float4()  { return { random_value(random_engine), random_value(random_engine), random_value(random_engine), random_value(random_engine) }; }
+float3 Random_Float3()  { return { random_value(random_engine), random_value(random_engine), random_value(random_engine) }; }
+
+// the simd versions may sum in a different order
+double Tolerance(double expected) { return 1e-6 * (1.0 + std::abs(expected)); }
+
+template <class A, class B, std::size_t Size>
+bool Near(A const& value, B const& expected)
+{
+    for (std::size_t n = 0; n < Size; ++n) {
+        if (std::abs(double(value.data[n]) - double(expected.data[n])) > Tolerance(expected.data[n])) { return false; }
+    }
+    return true;
+}
+
+bool Near(float4 const& value, float4 const& expected)  { return Near<float4, float4, 4>(value, expected); }
+bool Near(float3a const& value, float3 const& expected) { return Near<float3a, float3, 3>(value, expected) && value.padding == 0.0f; }
+
+void Check_Float4()
+{
+    for (int n = 0; n < 10000; ++n) {
+        float4 const a = Random_Float4(), b = Random_Float4();
+        float const  v = random_value(random_engine);
+
+        check(Near(a + b, operator + <float, 4>(a, b)));
+        check(Near(a - b, operator - <float, 4>(a, b)));
+        check(Near(a * v, operator * <float, 4>(a, v)));
+        check(Near(v * a, operator * <float, 4>(v, a)));
+        check(Near(a / v, operator / <float, 4>(a, v)));
+
+        float4 sum = a, difference = a;
+        sum += b;
+        difference -= b;
+        check(Near(sum, operator + <float, 4>(a, b)));
+        check(Near(difference, operator - <float, 4>(a, b)));
+
+        float const dot = dot_product<float, 4>(a, b);
+        float const squared = squared_length<float, 4>(a);
+        float const len = length<float, 4>(a);
+        check_near(dot_product(a, b), dot, Tolerance(dot));
+        check_near(squared_length(a), squared, Tolerance(squared));
+        check_near(length(a), len, Tolerance(len));
+        check(Near(normalize(a), normalize<float, 4>(a)));
+    }
+    check(normalize(float4{}) == float4{});
+}
+
+void Check_Float3a()
+{
+    for (int n = 0; n < 10000; ++n) {
+        float3 const a = Random_Float3(), b = Random_Float3();
+        float const  v = random_value(random_engine);
+        float3a const sa = a, sb = b;
+
+        check(Near(sa + sb, a + b));
+        check(Near(sa - sb, a - b));
+        check(Near(sa * v, a * v));
+        check(Near(v * sa, v * a));
+        check(Near(sa / v, a / v));
+
+        float3a sum = sa, difference = sa;
+        sum += sb;
+        difference -= sb;
+        check(Near(sum, a + b));
+        check(Near(difference, a - b));
+
+        check_near(dot_product(sa, sb), dot_product(a, b), Tolerance(dot_product(a, b)));
+        check_near(squared_length(sa), squared_length(a), Tolerance(squared_length(a)));
+        check_near(length(sa), length(a), Tolerance(length(a)));
+        check(Near(normalize(sa), normalize(a)));
+        check(Near(cross_product(sa, sb), cross_product(a, b)));
+        check(float3(sa) == a);
+    }
+    check(normalize(float3a{}).x == 0.0f && normalize(float3a{}).padding == 0.0f);
+    check(float3a(2.0f).padding == 0.0f);
+}
+
+// ns per element over whole arrays, a result of every run is kept so nothing is optimized away
+volatile float Sink = 0.0f;
+
+template <class Function>
+double Time_Per_Element(std::size_t count, Function&& function)
+{
+    return Test::Time_Per_Call(3, [&] { Sink = function(); }) / double(count);
+}
+
+void Bench()
+{
+    std::size_t const count = 4 << 20;
+    std::vector<float4> a(count), b(count), result(count);
+    std::vector<float3> a3(count), b3(count), result3(count);
+    std::vector<float3a> a3a(count), b3a(count), result3a(count);
+    for (std::size_t n = 0; n < count; ++n) {
+        a[n] = Random_Float4();
+        b[n] = Random_Float4();
+        a3[n] = a3a[n] = Random_Float3();
+        b3[n] = b3a[n] = Random_Float3();
+    }
+
+    std::cout << "ns per element over 4M element arrays, simd vs the generic templates:\n";
+    auto print = [](const char* name, double simd, double generic) {
+        std::cout << "  " << name << ": " << simd << " vs " << generic << " (" << generic / simd << "x)\n";
+    };
+
+    print("float4 a + b * v",
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result[n] = a[n] + b[n] * 0.5f; } return result[count / 2].x; }),
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result[n] = operator + <float, 4>(a[n], operator * <float, 4>(b[n], 0.5f)); } return result[count / 2].x; }));
+    print("float4 dot_product",
+        Time_Per_Element(count, [&] { float sum = 0.0f; for (std::size_t n = 0; n < count; ++n) { sum += dot_product(a[n], b[n]); } return sum; }),
+        Time_Per_Element(count, [&] { float sum = 0.0f; for (std::size_t n = 0; n < count; ++n) { sum += dot_product<float, 4>(a[n], b[n]); } return sum; }));
+    print("float4 normalize",
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result[n] = normalize(a[n]); } return result[count / 2].x; }),
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result[n] = normalize<float, 4>(a[n]); } return result[count / 2].x; }));
+    print("float3a vs float3 a + b * v",
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result3a[n] = a3a[n] + b3a[n] * 0.5f; } return result3a[count / 2].x; }),
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result3[n] = a3[n] + b3[n] * 0.5f; } return result3[count / 2].x; }));
+    print("float3a vs float3 cross_product",
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result3a[n] = cross_product(a3a[n], b3a[n]); } return result3a[count / 2].x; }),
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result3[n] = cross_product(a3[n], b3[n]); } return result3[count / 2].x; }));
+    print("float3a vs float3 normalize",
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result3a[n] = normalize(a3a[n]); } return result3a[count / 2].x; }),
+        Time_Per_Element(count, [&] { for (std::size_t n = 0; n < count; ++n) { result3[n] = normalize(a3[n]); } return result3[count / 2].x; }));
+}
+
+int main(int argc, char** argv)
+{
+#if defined(CPU_SSE2)
+    const char* const registers = "sse2";
+#elif defined(CPU_NEON)
+    const char* const registers = "neon";
+#else
+    const char* const registers = "scalar";
+#endif
+    std::cout << "simd registers: " << registers << '\n';
+
+    Check_Float4();
+    Check_Float3a();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Bench();
+    }
+
+    return Test::Result("Vector");
+}
@@ -0,0 +1,140 @@
+#include "Test.h"
+#include "../Cpu.h"
+#include "../Vertex_Packing.h"
+
+#include <random>
+
+#if defined(CPU_X86) && defined(__GNUC__)
+#include <immintrin.h>
+#define HAS_F16C_REFERENCE 1
+__attribute__((target("f16c"))) u16   F16C_To_Half(float value) { return u16(_cvtss_sh(value, _MM_FROUND_TO_NEAREST_INT)); }
+__attribute__((target("f16c"))) float F16C_From_Half(u16 value) { return _cvtsh_ss(value); }
+#endif
+
+using namespace Vertex_Packing;
+
+bool Same_Bits(float a, float b)
+{
+    return std::memcmp(&a, &b, sizeof(float)) == 0 || (std::isnan(a) && std::isnan(b));
+}
+
+// every half: the value from its fields, and back to the same bits
+void Check_Half_Exhaustive()
+{
+    int wrong = 0;
+    for (u32 half = 0; half < 0x10000; ++half) {
+        u32 const exponent = (half >> 10) & 0x1F;
+        u32 const mantissa = half & 0x3FF;
+        double const magnitude = exponent == 0  ? std::ldexp(double(mantissa), -24)
+                               : exponent == 31 ? (mantissa == 0 ? INFINITY : NAN)
+                               : std::ldexp(double(mantissa | 0x400), int(exponent) - 25);
+        float const expected = float(half & 0x8000 ? -magnitude : magnitude);
+
+        float const value = From_Half(u16(half));
+        wrong += !Same_Bits(value, expected);
+        wrong += !std::isnan(value) && To_Half(value) != half;
+    }
+    check(wrong == 0);
+
+    // ties go to the even neighbour, overflow to infinity
+    check(To_Half(1.0f + 1.0f / 2048.0f) == 0x3C00);
+    check(To_Half(1.0f + 3.0f / 2048.0f) == 0x3C02);
+    check(To_Half(65504.0f) == 0x7BFF);
+    check(To_Half(65520.0f) == 0x7C00);
+    check(To_Half(-1e10f) == 0xFC00);
+    check(To_Half(std::ldexp(1.0f, -25)) == 0x0000);
+    check(To_Half(std::ldexp(3.0f, -26)) == 0x0001);
+}
+
+#if defined(HAS_F16C_REFERENCE)
+// a sweep over all float bit patterns against the hardware conversion
+void Check_Half_Against_F16C()
+{
+    if (!__builtin_cpu_supports("f16c")) {
+        std::cout << "no f16c, skipped the hardware comparison\n";
+        return;
+    }
+    int wrong = 0;
+    for (u64 bits = 0; bits <= 0xFFFFFFFFu; bits += 97) {
+        float value;
+        u32 const pattern = u32(bits);
+        std::memcpy(&value, &pattern, sizeof(value));
+        if (std::isnan(value)) { continue; } // only the payload differs
+        wrong += To_Half(value) != F16C_To_Half(value);
+    }
+    for (u32 half = 0; half < 0x10000; ++half) {
+        wrong += !Same_Bits(From_Half(u16(half)), F16C_From_Half(u16(half)));
+    }
+    check(wrong == 0);
+}
+#endif
+
+// random orthogonal tangent frames, both handednesses
+Vertices Random_Vertices(std::size_t count)
+{
+    std::mt19937                          random{ 3 };
+    std::normal_distribution<float>       gaussian{};
+    std::uniform_real_distribution<float> uniform{ -1.0f, 1.0f };
+
+    Vertices vertices(count);
+    for (Vertex& v : vertices) {
+        v.position = { uniform(random) * 37.0f + 100.0f, uniform(random) * 5.0f, uniform(random) * 0.1f };
+        float3 const normal  = normalize(float3{ gaussian(random), gaussian(random), gaussian(random) });
+        float3 const guess   = normalize(float3{ gaussian(random), gaussian(random), gaussian(random) });
+        float3 const tangent = normalize(guess - normal * dot_product(guess, normal));
+        float const  sign    = uniform(random) < 0.0f ? -1.0f : 1.0f;
+        v.normal    = normal;
+        v.tangent   = tangent;
+        v.bitangent = cross_product(normal, tangent) * sign;
+        v.tex_coord = { uniform(random), uniform(random) * 8.0f };
+    }
+
+    // the octahedron corners & a missing tangent frame
+    vertices[0].normal = { 0, 0, -1 }; vertices[0].tangent = { 1, 0, 0 }; vertices[0].bitangent = { 0, 1, 0 };
+    vertices[1].normal = { 1, 0, 0 };  vertices[1].tangent = { 0, 0, 1 }; vertices[1].bitangent = { 0, 1, 0 };
+    vertices[2].normal = { 0, -1, 0 }; vertices[2].tangent = { 1, 0, 0 }; vertices[2].bitangent = { 0, 0, 1 };
+    vertices[3].normal = {};           vertices[3].tangent = {};          vertices[3].bitangent = {};
+    return vertices;
+}
+
+void Check_Round_Trip()
+{
+    Vertices const        vertices = Random_Vertices(1'000'000);
+    Packed_Vertices const packed   = Pack(vertices);
+    check(packed.size() == vertices.size());
+
+    Error const error = Measure_Error(vertices, packed);
+    check(error.position <= Max_Position_Error);
+    check(error.normal <= Max_Normal_Error);
+    check(error.tangent <= Max_Tangent_Error);
+    check(error.tex_coord <= Max_Tex_Coord_Error);
+    check(error.bitangent <= 0.01f);
+
+    // the bitangent sign survives, a missing normal decodes to some unit vector
+    Vertices const unpacked = Unpack(packed);
+    std::size_t flipped = 0;
+    for (std::size_t n = 4; n < vertices.size(); ++n) {
+        flipped += dot_product(vertices[n].bitangent, unpacked[n].bitangent) < 0.0f;
+    }
+    check(flipped == 0);
+    check_near(length(unpacked[3].normal), 1.0, 1e-5);
+}
+
+int main(int argc, char** argv)
+{
+    Check_Half_Exhaustive();
+#if defined(HAS_F16C_REFERENCE)
+    Check_Half_Against_F16C();
+#endif
+    Check_Round_Trip();
+
+    if (Test::Bench_Requested(argc, argv)) {
+        Vertices const vertices = Random_Vertices(1'000'000);
+        Packed_Vertices packed{};
+        std::cout << "vertex packing, 1M vertices:\n";
+        Test::Print_Bench("pack", Test::Time_Per_Call(3, [&] { packed = Pack(vertices); }));
+        Test::Print_Bench("unpack", Test::Time_Per_Call(3, [&] { Unpack(packed); }));
+    }
+
+    return Test::Result("Vertex_Packing");
+}